@@ -63,7 +63,7 @@
 #define configSUPPORT_STATIC_ALLOCATION          FREERTOS_USE_STATIC_ALLOCATION
 #define configSUPPORT_DYNAMIC_ALLOCATION         !FREERTOS_USE_STATIC_ALLOCATION
 #define configUSE_IDLE_HOOK                      0
-#define configUSE_TICK_HOOK                      0
+#define configUSE_TICK_HOOK                      1
 #define configCPU_CLOCK_HZ                       ( SystemCoreClock )
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 56 )
@@ -173,6 +173,115 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+
+/* Run time statistics on the DWT cycle counter, see freertos_cpp/Stats.hpp,
+   and the flight recorder in the backup SRAM, see freertos_cpp/FlightRecorder.hpp */
+#define configGENERATE_RUN_TIME_STATS            1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS  1
+#define configSTATS_TLS_INDEX                    0
+
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+#ifdef __cplusplus
+extern "C" {
+#endif
+void freertos_stats_configure_counter(void);
+uint32_t freertos_stats_run_time_counter(void);
+void freertos_stats_task_switched_in(void);
+uint32_t freertos_stats_isr_enter(void);
+void freertos_stats_isr_exit(uint32_t start);
+void freertos_flight_task_switched_in(void);
+void freertos_flight_isr(void);
+void freertos_flight_fault(const uint32_t *frame, uint32_t excReturn);
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+/* Kernel trace recorder, see freertos_cpp/Trace.hpp */
+#define configUSE_TRACE_RECORDER                 1
+
+#if (configUSE_TRACE_RECORDER == 1)
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+#ifdef __cplusplus
+extern "C" {
+#endif
+void freertos_trace_task_create(void *handle, uint32_t task, uint32_t priority, const char *name);
+void freertos_trace_task_delete(void *handle);
+void freertos_trace_task_switched_in(uint32_t task);
+void freertos_trace_task_delay(uint32_t ticks);
+void freertos_trace_task_delay_until(uint32_t wakeTick);
+uint32_t freertos_trace_queue_create(uint32_t type);
+void freertos_trace_queue_delete(uint32_t queue);
+void freertos_trace_queue_send(uint32_t queue);
+void freertos_trace_queue_send_failed(uint32_t queue);
+void freertos_trace_queue_send_from_isr(uint32_t queue);
+void freertos_trace_queue_receive(uint32_t queue);
+void freertos_trace_queue_receive_failed(uint32_t queue);
+void freertos_trace_queue_receive_from_isr(uint32_t queue);
+void freertos_trace_blocking_on_queue_send(uint32_t queue);
+void freertos_trace_blocking_on_queue_receive(uint32_t queue);
+void freertos_trace_task_notify(uint32_t task);
+void freertos_trace_task_notify_from_isr(uint32_t task);
+void freertos_trace_task_notify_block(void);
+void freertos_trace_isr_enter(void);
+void freertos_trace_isr_exit(void);
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#define traceRECORDER_TASK_SWITCHED_IN()         freertos_trace_task_switched_in((uint32_t) pxCurrentTCB->uxTCBNumber)
+#define traceTASK_CREATE(pxNewTCB)               \
+  freertos_trace_task_create((void *) (pxNewTCB), (uint32_t) (pxNewTCB)->uxTCBNumber, (uint32_t) (pxNewTCB)->uxPriority, \
+                             (pxNewTCB)->pcTaskName)
+#define traceTASK_DELETE(pxTaskToDelete)         freertos_trace_task_delete((void *) (pxTaskToDelete))
+#define traceTASK_DELAY()                        freertos_trace_task_delay((uint32_t) xTicksToDelay)
+#define traceTASK_DELAY_UNTIL(xTimeToWake)       freertos_trace_task_delay_until((uint32_t) (xTimeToWake))
+#define traceQUEUE_CREATE(pxNewQueue)            \
+  (pxNewQueue)->uxQueueNumber = freertos_trace_queue_create((uint32_t) (pxNewQueue)->ucQueueType)
+#define traceQUEUE_DELETE(pxQueue)               freertos_trace_queue_delete((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND(pxQueue)                 freertos_trace_queue_send((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND_FAILED(pxQueue)          freertos_trace_queue_send_failed((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)        freertos_trace_queue_send_from_isr((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE(pxQueue)              freertos_trace_queue_receive((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue)       freertos_trace_queue_receive_failed((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)     freertos_trace_queue_receive_from_isr((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue)     freertos_trace_blocking_on_queue_send((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue)  freertos_trace_blocking_on_queue_receive((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceTASK_NOTIFY()                       freertos_trace_task_notify((uint32_t) pxTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_FROM_ISR()              freertos_trace_task_notify_from_isr((uint32_t) pxTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_GIVE_FROM_ISR()         freertos_trace_task_notify_from_isr((uint32_t) pxTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_TAKE_BLOCK()            freertos_trace_task_notify_block()
+#define traceTASK_NOTIFY_WAIT_BLOCK()            freertos_trace_task_notify_block()
+#else
+#define traceRECORDER_TASK_SWITCHED_IN()
+#endif
+
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() freertos_stats_configure_counter()
+#define portGET_RUN_TIME_COUNTER_VALUE()         freertos_stats_run_time_counter()
+#define traceTASK_SWITCHED_IN()                  \
+  do {                                           \
+    freertos_stats_task_switched_in();           \
+    freertos_flight_task_switched_in();          \
+    traceRECORDER_TASK_SWITCHED_IN();            \
+  } while (0)
+
+/* Tickless idle, vPortSuppressTicksAndSleep() is in core/src/LowPower.cpp */
+#define configUSE_TICKLESS_IDLE                  2
+
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+#ifdef __cplusplus
+extern "C" {
+#endif
+void PreSleepProcessing(uint32_t *ulExpectedIdleTime);
+void PostSleepProcessing(uint32_t *ulExpectedIdleTime);
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#define configPRE_SLEEP_PROCESSING(x)            PreSleepProcessing(&(x))
+#define configPOST_SLEEP_PROCESSING(x)           PostSleepProcessing(&(x))
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
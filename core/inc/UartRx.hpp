@@ -0,0 +1,133 @@
+/*
+ * UartRx.hpp
+ *
+ *  Circular DMA UART receiver with idle line detection.
+ */
+
+#ifndef CORE_UART_RX_HPP_
+#define CORE_UART_RX_HPP_
+
+#include "stm32f4xx_hal.h"
+
+#include <freertos_cpp/SpscRing.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  Receive driver that keeps the UART RX DMA stream running in circular
+ *  mode and forwards whole spans of bytes to a lock free ring.
+ *
+ *  The DMA half transfer, transfer complete and UART idle line events all
+ *  land in onRxEvent(), which reads the write position from the DMA
+ *  counter. Every byte between the previous position and the new one is
+ *  pushed into the ring in one go, so the CPU takes one interrupt per
+ *  burst (or per half buffer on a continuous stream) instead of one per
+ *  byte.
+ *
+ *  The position alone cannot tell a full turn of the buffer from no
+ *  progress at all. The half transfer and transfer complete events can:
+ *  each stands for the DMA going past the middle or the end, and one that
+ *  the position has not gone past since the last event means the DMA
+ *  lapped bytes that were never handed over. Those count as one buffer of
+ *  overrun.
+ *
+ *  The DMA buffer is passed in so it can be placed in SRAM2 with
+ *  DMA_BUFFER from placement.h.
+ *
+ *  @note onRxEvent() must be called from HAL_UARTEx_RxEventCallback and
+ *        onError() from HAL_UART_ErrorCallback for the UART handle this
+ *        driver was constructed with.
+ */
+class UartRx {
+  public:
+    static constexpr size_t DMA_BUFFER_SIZE = 64;
+    static constexpr size_t RING_SIZE = 256;
+
+    using DmaBuffer = std::array<uint8_t, DMA_BUFFER_SIZE>;
+
+    /**
+     *  What raised HAL_UARTEx_RxEventCallback. HAL reports all three with
+     *  a size only, and half a buffer can be either a half transfer or an
+     *  idle line, so the caller tells them apart.
+     */
+    enum class RxEvent : uint8_t {
+      /** DMA went past the middle of the buffer. */
+      HalfTransfer,
+      /** DMA went past the end of the buffer and wrapped. */
+      TransferComplete,
+      /** The line went idle after a byte. */
+      Idle
+    };
+
+    UartRx(UART_HandleTypeDef& huart, DmaBuffer& dmaBuffer);
+
+    UartRx(const UartRx&) = delete;
+    UartRx& operator=(const UartRx&) = delete;
+
+    /**
+     *  Start circular reception. Call once the UART has been initialised.
+     *
+     *  @return true if the DMA stream was started.
+     */
+    bool start();
+
+    /**
+     *  Read received bytes, blocking until at least one is available or
+     *  the timeout expires.
+     *
+     *  @param data Where to copy the bytes.
+     *  @param length Maximum number of bytes to copy.
+     *  @param ticksToWait How long to wait for data.
+     *  @return Number of bytes copied, 0 on timeout.
+     */
+    size_t read(uint8_t* data, size_t length, TickType_t ticksToWait = portMAX_DELAY);
+
+    /**
+     *  Number of bytes dropped, because the ring was full or the DMA
+     *  lapped them before an event handed them over.
+     */
+    [[nodiscard]] uint32_t overruns() const;
+
+    /**
+     *  Hand over the bytes written by the DMA since the last event.
+     *  ISR context only.
+     *
+     *  @param event What raised the callback. HAL services a pending half
+     *         transfer before a pending transfer complete, the driver
+     *         relies on that order.
+     */
+    void onRxEvent(RxEvent event);
+
+    /**
+     *  Restart reception after a UART error. ISR context only.
+     */
+    void onError();
+
+  private:
+    /**
+     *  Write position of the DMA, from its counter.
+     */
+    [[nodiscard]] size_t dmaPosition() const;
+
+    UART_HandleTypeDef& m_huart;
+    DmaBuffer& m_dmaBuffer;
+    freertos::SpscRing<uint8_t, RING_SIZE> m_ring{};
+
+    /**
+     *  Position in m_dmaBuffer up to which bytes have been handed over.
+     */
+    size_t m_lastPosition{0};
+
+    /**
+     *  Boundaries the position went past whose DMA event has not come in
+     *  yet, CROSSED_HALF and CROSSED_END from UartRx.cpp.
+     */
+    uint8_t m_unreported{0};
+
+    std::atomic<uint32_t> m_overruns{0};
+};
+
+#endif /* CORE_UART_RX_HPP_ */
@@ -0,0 +1,120 @@
+/*
+ * UartTx.hpp
+ *
+ *  DMA driven, zero copy UART transmitter.
+ */
+
+#ifndef CORE_UART_TX_HPP_
+#define CORE_UART_TX_HPP_
+
+#include "stm32f4xx_hal.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <freertos_cpp/TypedQueue.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  Transmit driver that hands caller buffers straight to the UART TX DMA
+ *  stream.
+ *
+ *  write() only queues a pointer and a length, the bytes are never copied.
+ *  While a transfer is running the next buffer is started from the TX
+ *  complete interrupt, so back to back writes go out without the CPU
+ *  touching a single byte. A caller only blocks when the descriptor queue
+ *  is full.
+ *
+ *  @note The buffer passed to write() must stay valid and unmodified until
+ *        it has been sent. String literals and static tables are the
+ *        intended use, otherwise wait with flush().
+ *
+ *  @note onTxComplete() must be called from HAL_UART_TxCpltCallback for the
+ *        UART handle this driver was constructed with.
+ */
+class UartTx {
+  public:
+    static constexpr size_t QUEUE_DEPTH = 16;
+
+    explicit UartTx(UART_HandleTypeDef& huart);
+
+    UartTx(const UartTx&) = delete;
+    UartTx& operator=(const UartTx&) = delete;
+
+    /**
+     *  Queue a buffer for transmission.
+     *
+     *  @param data Bytes to send, must outlive the transfer.
+     *  @param length Number of bytes to send.
+     *  @param Timeout How long to wait for room in the descriptor queue.
+     *  @return true if the whole buffer was queued, false on timeout.
+     */
+    bool write(const uint8_t* data, size_t length, TickType_t Timeout = portMAX_DELAY);
+
+    inline bool write(const char* data, size_t length, TickType_t Timeout = portMAX_DELAY)
+    {
+      return write(reinterpret_cast<const uint8_t*>(data), length, Timeout);
+    }
+
+    /**
+     *  Is the DMA stream idle with nothing left in the queue?
+     */
+    bool isIdle() const;
+
+    /**
+     *  Block until everything written has been sent, woken by the TX
+     *  complete interrupt that leaves the stream idle. One task at a time
+     *  may wait, it takes its task notification.
+     *
+     *  @param Timeout How long to wait.
+     *  @return true if the transmitter is idle, false on timeout.
+     */
+    bool flush(TickType_t Timeout = portMAX_DELAY);
+
+    /**
+     *  Number of buffers dropped because the DMA stream could not be
+     *  started on them.
+     */
+    [[nodiscard]] uint32_t errors() const;
+
+    /**
+     *  Chain the next queued buffer. ISR context only.
+     */
+    void onTxComplete();
+
+  private:
+    struct Descriptor {
+      const uint8_t* data;
+      uint16_t length;
+    };
+
+    /**
+     *  Start the DMA if it is idle and something is queued.
+     */
+    void kick();
+
+    /**
+     *  Give the busy flag back and wake a task waiting in flush(). Pass
+     *  nullptr from a task.
+     */
+    void release(BaseType_t* higherPriorityTaskWoken);
+
+    /**
+     *  Start the DMA on a descriptor. Caller must own the busy flag.
+     *
+     *  @return false if HAL refused the transfer, the descriptor is then
+     *          counted in errors().
+     */
+    bool start(const Descriptor& descriptor);
+
+    UART_HandleTypeDef& m_huart;
+    freertos::TypedQueue<Descriptor, QUEUE_DEPTH> m_pending{};
+    std::atomic<bool> m_busy{false};
+    std::atomic<TaskHandle_t> m_flusher{nullptr};
+    std::atomic<uint32_t> m_errors{0};
+};
+
+#endif /* CORE_UART_TX_HPP_ */
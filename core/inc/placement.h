@@ -0,0 +1,57 @@
+/*
+ * placement.h
+ *
+ *  Attributes placing code and data in specific memories, for C and C++.
+ */
+
+#ifndef CORE_PLACEMENT_H_
+#define CORE_PLACEMENT_H_
+
+/**
+ *  Run the function from SRAM instead of flash. At 180 MHz flash needs
+ *  five wait states and the ART accelerator only hides them on a cache
+ *  hit, code in RAM runs without any.
+ *
+ *      RAMFUNC void filterBlock(const q15_t* in, q15_t* out);
+ *
+ *  The startup code copies the .ramfunc section right after .data,
+ *  before SystemInit(), so nothing in it may run earlier. Calls between
+ *  RAM and flash go through linker generated long branch veneers, keep
+ *  the callees of a hot function in RAM too where it matters. Generated
+ *  code such as the CubeMX interrupt handlers and the kernel port is
+ *  moved by its function section name in the linker scripts instead.
+ *
+ *  Every symbol in .ramfunc and its size is written to
+ *  <target>.ramfunc.txt on each build.
+ */
+#define RAMFUNC __attribute__((section(".ramfunc"), noinline))
+
+/**
+ *  Place a buffer a DMA stream reads or writes in SRAM2. SRAM2 is its
+ *  own slave on the bus matrix, so a stream filling it does not stall
+ *  the CPU on SRAM1, where the linker scripts keep the stacks, the heap
+ *  and all other data.
+ *
+ *      DMA_BUFFER static std::array<uint8_t, 64> uart_rx_dma;
+ *      DMA_BUFFER_CHECK(uart_rx_dma);
+ *
+ *  The section is cleared at startup like .bss, initialisers are not
+ *  applied. SRAM2 holds 16K.
+ */
+#define DMA_BUFFER __attribute__((section(".dma_buffers"), aligned(4)))
+
+#define PLACEMENT_CONCAT_(a, b) a##b
+#define PLACEMENT_CONCAT(a, b) PLACEMENT_CONCAT_(a, b)
+
+/**
+ *  Record the address of a DMA buffer in the non allocated .dma_check
+ *  section. After linking the build fails if any recorded address is
+ *  outside SRAM2, which catches buffers that lost their DMA_BUFFER
+ *  attribute (GCC drops it on template static members) as well as ones
+ *  that never had it, such as a buffer inside a larger object.
+ */
+#define DMA_BUFFER_CHECK(object) \
+  __attribute__((section(".dma_check"), used)) \
+  static const void* const PLACEMENT_CONCAT(placement_dma_check_, __LINE__) = &(object)
+
+#endif /* CORE_PLACEMENT_H_ */
@@ -0,0 +1,154 @@
+/*
+ * LowPower.cpp
+ *
+ *  Tickless idle on SysTick, with the HAL time base on TIM6 and the run
+ *  time statistics clock held back while the core sleeps.
+ */
+
+#include "main.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <freertos_cpp/Stats.hpp>
+#include <freertos_cpp/TicklessIdle.hpp>
+
+extern TIM_HandleTypeDef htim6;
+
+namespace {
+
+  /**
+   *  SysTick runs from the core clock here, as set up by the port.
+   */
+  struct SysTickTimebase {
+    static uint32_t countsPerTick()
+    {
+      return configCPU_CLOCK_HZ / configTICK_RATE_HZ;
+    }
+
+    static uint32_t maxSleepCounts()
+    {
+      return SysTick_LOAD_RELOAD_Msk;
+    }
+
+    /**
+     *  Core cycles SysTick misses each time it is stopped and started
+     *  again, the stock port's estimate.
+     */
+    static uint32_t stoppedCompensation()
+    {
+      return 45;
+    }
+
+    static uint32_t stopTick()
+    {
+      SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+      HAL_SuspendTick();
+      const uint32_t untilTick = SysTick->VAL;
+
+      // TIM6 ends its period just after SysTick. Stopped in between, the
+      // kernel has counted the tick but uwTick has not, and startTick()
+      // drops that update, so it owes uwTick the tick.
+      const uint32_t halPeriod = __HAL_TIM_GET_AUTORELOAD(&htim6) + 1;
+      const uint32_t untilHalTick = halPeriod - __HAL_TIM_GET_COUNTER(&htim6);
+      s_halTickOwed = untilTick > countsPerTick() / 2
+                      && (__HAL_TIM_GET_FLAG(&htim6, TIM_FLAG_UPDATE) != RESET || untilHalTick < halPeriod / 2);
+      return untilTick;
+    }
+
+    static void startWakeup(uint32_t counts)
+    {
+      s_wakeupCounts = counts;
+      s_wakeupTimestamp = freertos::Stats::timestamp();
+      SysTick->LOAD = counts - 1;
+      SysTick->VAL = 0;
+      SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    }
+
+    static uint32_t stopWakeup(bool& expired)
+    {
+      // Reading CTRL clears COUNTFLAG, read it once.
+      const uint32_t control = SysTick->CTRL;
+      SysTick->CTRL = control & ~SysTick_CTRL_ENABLE_Msk;
+
+      const uint32_t counted = (s_wakeupCounts - 1) - SysTick->VAL;
+      expired = (control & SysTick_CTRL_COUNTFLAG_Msk) != 0;
+      const uint32_t elapsed = expired ? s_wakeupCounts + counted : counted;
+
+      // SysTick and the DWT cycle counter both run from the core clock,
+      // but only SysTick kept counting in WFI. Give the stats clock what
+      // it missed, or the sleep is charged to nobody.
+      const uint32_t seen = freertos::Stats::timestamp() - s_wakeupTimestamp;
+      if (elapsed > seen) {
+        freertos::Stats::advance(elapsed - seen);
+      }
+      return elapsed;
+    }
+
+    static void startTick(uint32_t counts, TickType_t slept)
+    {
+      // TIM6 restarts its period to end with the first SysTick period, at
+      // least one of its counts away. Left on its own phase it gains or
+      // loses a tick against the kernel on many sleeps, and that adds up.
+      const uint32_t halPeriod = __HAL_TIM_GET_AUTORELOAD(&htim6) + 1;
+      uint32_t halCounts = static_cast<uint32_t>(
+          (uint64_t{counts} * halPeriod + countsPerTick() - 1) / countsPerTick());
+      if (halCounts == 0) {
+        halCounts = 1;
+      }
+
+      // The first period is counts long, LOAD is only reloaded at the
+      // next underflow, so it can be set back straight away. No counts
+      // left means the tick interrupt is already pending.
+      if (counts == 0) {
+        counts = countsPerTick();
+      }
+      SysTick->LOAD = counts - 1;
+      SysTick->VAL = 0;
+      SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+      SysTick->LOAD = countsPerTick() - 1;
+
+      // TIM6 kept counting without its interrupt, drop the update it
+      // flagged meanwhile and account the time in one go.
+      uwTick += (slept + (s_halTickOwed ? 1 : 0)) * portTICK_PERIOD_MS;
+      __HAL_TIM_SET_COUNTER(&htim6, halPeriod - halCounts);
+      __HAL_TIM_CLEAR_IT(&htim6, TIM_IT_UPDATE);
+      HAL_ResumeTick();
+    }
+
+    static void disableInterrupts()
+    {
+      __disable_irq();
+      __DSB();
+      __ISB();
+    }
+
+    static void enableInterrupts()
+    {
+      __enable_irq();
+      __ISB();
+    }
+
+    static void waitForInterrupt()
+    {
+      __DSB();
+      __WFI();
+      __ISB();
+    }
+
+    static inline uint32_t s_wakeupCounts = 0;
+    static inline uint32_t s_wakeupTimestamp = 0;
+    static inline bool s_halTickOwed = false;
+  };
+
+  using Idle = freertos::TicklessIdle<SysTickTimebase, freertos::TicklessKernel>;
+
+} // namespace
+
+/**
+ *  Replaces the port's version, configUSE_TICKLESS_IDLE is 2.
+ */
+extern "C" void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+  Idle::sleep(xExpectedIdleTime);
+}
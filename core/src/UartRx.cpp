@@ -0,0 +1,126 @@
+/*
+ * UartRx.cpp
+ *
+ *  Circular DMA UART receiver with idle line detection.
+ */
+
+#include "UartRx.hpp"
+
+#include <freertos_cpp/Task.hpp>
+
+#include <span>
+
+namespace {
+
+  constexpr size_t HALF_POSITION = UartRx::DMA_BUFFER_SIZE / 2;
+
+  constexpr uint8_t CROSSED_HALF = 1U << 0;
+  constexpr uint8_t CROSSED_END = 1U << 1;
+
+  /**
+   *  Bytes the DMA writes from one position until it goes past another,
+   *  a full buffer when they are the same.
+   */
+  constexpr size_t distance(size_t from, size_t to)
+  {
+    return (to + UartRx::DMA_BUFFER_SIZE - from - 1) % UartRx::DMA_BUFFER_SIZE + 1;
+  }
+
+} // namespace
+
+UartRx::UartRx(UART_HandleTypeDef& huart, DmaBuffer& dmaBuffer)
+    :m_huart(huart), m_dmaBuffer(dmaBuffer)
+{
+}
+
+bool UartRx::start()
+{
+  m_lastPosition = 0;
+  m_unreported = 0;
+
+  // In circular mode HAL raises HAL_UARTEx_RxEventCallback on the half
+  // transfer, transfer complete and idle line events.
+  return HAL_UARTEx_ReceiveToIdle_DMA(&m_huart, m_dmaBuffer.data(), DMA_BUFFER_SIZE) == HAL_OK;
+}
+
+size_t UartRx::read(uint8_t* data, size_t length, TickType_t ticksToWait)
+{
+  return m_ring.receive(std::span<uint8_t>(data, length), ticksToWait);
+}
+
+uint32_t UartRx::overruns() const
+{
+  return m_overruns.load(std::memory_order_relaxed);
+}
+
+size_t UartRx::dmaPosition() const
+{
+  // The counter runs down from the buffer size and reloads on the wrap.
+  const auto remaining = static_cast<size_t>(__HAL_DMA_GET_COUNTER(m_huart.hdmarx));
+  return remaining >= DMA_BUFFER_SIZE ? 0 : DMA_BUFFER_SIZE - remaining;
+}
+
+void UartRx::onRxEvent(RxEvent event)
+{
+  const size_t position = dmaPosition();
+  const size_t moved = (position + DMA_BUFFER_SIZE - m_lastPosition) % DMA_BUFFER_SIZE;
+
+  // Boundaries passed on the way, their events may still be pending: the
+  // idle line reads the counter before a waiting half transfer is
+  // serviced, a half transfer before the transfer complete behind it.
+  if (distance(m_lastPosition, HALF_POSITION) <= moved) {
+    m_unreported = static_cast<uint8_t>(m_unreported | CROSSED_HALF);
+  }
+  if (distance(m_lastPosition, 0) <= moved) {
+    m_unreported = static_cast<uint8_t>(m_unreported | CROSSED_END);
+  }
+
+  if (event != RxEvent::Idle) {
+    const uint8_t crossed = event == RxEvent::HalfTransfer ? CROSSED_HALF : CROSSED_END;
+    if ((m_unreported & crossed) != 0) {
+      m_unreported = static_cast<uint8_t>(m_unreported & ~crossed);
+    } else {
+      // The DMA went past this boundary once more than the position
+      // shows, a full turn since the last event: the bytes it lapped are
+      // gone and the ones left are only the newest. The turn went past the
+      // end too, a half transfer has its transfer complete right behind.
+      m_overruns.fetch_add(static_cast<uint32_t>(DMA_BUFFER_SIZE), std::memory_order_relaxed);
+      if (event == RxEvent::HalfTransfer) {
+        m_unreported = static_cast<uint8_t>(m_unreported | CROSSED_END);
+      }
+    }
+  }
+
+  if (moved == 0) {
+    return;
+  }
+
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+  // Up to the end of the buffer first when the DMA wrapped.
+  if (position < m_lastPosition) {
+    const size_t tail = DMA_BUFFER_SIZE - m_lastPosition;
+    const size_t pushed = m_ring.pushFromISR(
+        std::span<const uint8_t>(&m_dmaBuffer[m_lastPosition], tail), &higherPriorityTaskWoken);
+    m_overruns.fetch_add(static_cast<uint32_t>(tail - pushed), std::memory_order_relaxed);
+    m_lastPosition = 0;
+  }
+
+  const size_t count = position - m_lastPosition;
+  const size_t pushed = m_ring.pushFromISR(
+      std::span<const uint8_t>(&m_dmaBuffer[m_lastPosition], count), &higherPriorityTaskWoken);
+  m_overruns.fetch_add(static_cast<uint32_t>(count - pushed), std::memory_order_relaxed);
+
+  m_lastPosition = position;
+
+  freertos::Task::yieldFromISR(higherPriorityTaskWoken);
+}
+
+void UartRx::onError()
+{
+  // Blocking errors (overrun, DMA error) make HAL abort the reception,
+  // noise and framing errors leave it running.
+  if (m_huart.RxState == HAL_UART_STATE_READY) {
+    (void) start();
+  }
+}
@@ -0,0 +1,135 @@
+/*
+ * UartTx.cpp
+ *
+ *  DMA driven, zero copy UART transmitter.
+ */
+
+#include "UartTx.hpp"
+
+#include <freertos_cpp/Critical.hpp>
+#include <freertos_cpp/Task.hpp>
+
+UartTx::UartTx(UART_HandleTypeDef& huart)
+    :m_huart(huart)
+{
+}
+
+bool UartTx::write(const uint8_t* data, size_t length, TickType_t Timeout)
+{
+  // HAL transfers are limited to 16 bit lengths, larger buffers are
+  // split into several descriptors pointing into the same memory.
+  while (length > 0) {
+    const uint16_t chunk = length > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(length);
+
+    if (!m_pending.enqueue({data, chunk}, Timeout)) {
+      return false;
+    }
+
+    data += chunk;
+    length -= chunk;
+
+    kick();
+  }
+
+  return true;
+}
+
+bool UartTx::isIdle() const
+{
+  return !m_busy.load(std::memory_order_acquire) && m_pending.isEmpty();
+}
+
+bool UartTx::flush(TickType_t Timeout)
+{
+  TimeOut_t timeOut;
+  vTaskSetTimeOutState(&timeOut);
+
+  // A completion that saw the handle just before it was cleared still
+  // notifies, a wakeup can be left over and only means look again.
+  while (!isIdle()) {
+    m_flusher.store(xTaskGetCurrentTaskHandle(), std::memory_order_seq_cst);
+
+    // Re-check after publishing ourselves, the last transfer may have
+    // finished before the interrupt could see the handle.
+    if (!isIdle()) {
+      (void) ulTaskNotifyTake(pdTRUE, Timeout);
+    }
+
+    m_flusher.store(nullptr, std::memory_order_seq_cst);
+    if (xTaskCheckForTimeOut(&timeOut, &Timeout) != pdFALSE) {
+      break;
+    }
+  }
+  return isIdle();
+}
+
+uint32_t UartTx::errors() const
+{
+  return m_errors.load(std::memory_order_relaxed);
+}
+
+void UartTx::onTxComplete()
+{
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  Descriptor next{};
+
+  bool started = false;
+  while (!started && m_pending.dequeueFromISR(next, &higherPriorityTaskWoken)) {
+    started = start(next);
+  }
+  if (!started) {
+    release(&higherPriorityTaskWoken);
+  }
+
+  freertos::Task::yieldFromISR(higherPriorityTaskWoken);
+}
+
+void UartTx::kick()
+{
+  // Whoever flips the flag owns the idle DMA stream. The TX complete ISR
+  // only runs while a transfer is active, so it never competes for the
+  // flag and the queue is drained outside any critical section. A writer
+  // that loses the race leaves its descriptor to the owner, which
+  // re-checks the queue after giving the flag back.
+  bool idle = false;
+  while (!m_pending.isEmpty() && m_busy.compare_exchange_strong(idle, true, std::memory_order_acq_rel)) {
+    Descriptor next{};
+    if (m_pending.dequeue(next, 0)) {
+      // HAL locks the handle while it starts the transfer, an RX error
+      // interrupt landing in there could not restart reception.
+      freertos::CriticalSection::enter();
+      const bool started = start(next);
+      freertos::CriticalSection::exit();
+      if (started) {
+        return;
+      }
+    }
+    release(nullptr);
+    idle = false;
+  }
+}
+
+void UartTx::release(BaseType_t* higherPriorityTaskWoken)
+{
+  m_busy.store(false, std::memory_order_seq_cst);
+
+  TaskHandle_t flusher = m_flusher.load(std::memory_order_seq_cst);
+  if (flusher == nullptr) {
+    return;
+  }
+  if (higherPriorityTaskWoken != nullptr) {
+    vTaskNotifyGiveFromISR(flusher, higherPriorityTaskWoken);
+  } else {
+    (void) xTaskNotifyGive(flusher);
+  }
+}
+
+bool UartTx::start(const Descriptor& descriptor)
+{
+  // HAL takes a non const pointer but only reads from it for transmit.
+  if (HAL_UART_Transmit_DMA(&m_huart, const_cast<uint8_t*>(descriptor.data), descriptor.length) != HAL_OK) {
+    m_errors.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
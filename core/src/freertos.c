@@ -82,6 +82,19 @@ void vApplicationMallocFailedHook(void)
 }
 /* USER CODE END 5 */
 
+/* USER CODE BEGIN PREPOSTSLEEP */
+__weak void PreSleepProcessing(uint32_t *ulExpectedIdleTime)
+{
+/* place for user code, set *ulExpectedIdleTime to 0 if this function
+   already waited for an interrupt */
+}
+
+__weak void PostSleepProcessing(uint32_t *ulExpectedIdleTime)
+{
+/* place for user code */
+}
+/* USER CODE END PREPOSTSLEEP */
+
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
 
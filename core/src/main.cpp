@@ -21,9 +21,19 @@
 #include "main.h"
 #include "cmsis_os.h"
 
+#include <freertos_cpp/FlightRecorder.hpp>
+#include <freertos_cpp/Mutex.hpp>
 #include <freertos_cpp/Task.hpp>
 #include <freertos_cpp/Queue.hpp>
+#include <freertos_cpp/Stats.hpp>
+#include <freertos_cpp/System.hpp>
+#include <freertos_cpp/Trace.hpp>
+#include <logging/Log.hpp>
+#include "UartRx.hpp"
+#include "UartTx.hpp"
+#include "placement.h"
 #include <cstring>
+#include <unistd.h>
 #include "../outcome/result.hpp"
 #include <NamedType/named_type.hpp>
 
@@ -72,6 +82,28 @@ class Rectangle {
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
+
+DMA_BUFFER static UartRx::DmaBuffer uart_rx_dma;
+DMA_BUFFER_CHECK(uart_rx_dma);
+
+/* Chunks the UART TX DMA stream and the log ring are filled from, in SRAM2
+   with the receive buffer, see LogTask and StatsTask::sendTrace() */
+DMA_BUFFER static std::array<uint8_t, 64> log_tx_chunk;
+DMA_BUFFER_CHECK(log_tx_chunk);
+DMA_BUFFER static std::array<uint8_t, 128> trace_chunk;
+DMA_BUFFER_CHECK(trace_chunk);
+
+/* The ring behind uart_rx has a single consumer, it is only read through
+   stdin, see _read() */
+UartRx uart_rx{huart2, uart_rx_dma};
+freertos::Mutex stdin_lock{};
+UartTx uart_tx{huart2};
+
+/* Flight recorder session from before the last reset, dumped by StatsTask */
+freertos::FlightLog previous_flight{};
+bool flight_recovered = false;
 
 /* Definitions for defaultTask */
 //osThreadId_t defaultTaskHandle;
@@ -111,16 +143,18 @@ result<int, MyError> test_val(int i)
 }
 
 constexpr uint16_t TASK_STACK_SIZES = 128;
-class BlinkyTask : public freertos::Task {
-  private:
-    std::array<StackType_t, TASK_STACK_SIZES> printy_stack{0};
 
+/**
+ * The stats task formats long LOG() records and walks the flight log and
+ * the task table, it needs more than the others. The 's' command prints
+ * its high-water mark with everyone else's, and it warns on its own when
+ * it comes within STACK_MARGIN words of the end.
+ */
+constexpr uint16_t STATS_STACK_SIZE = 256;
+
+class BlinkyTask : public freertos::Task {
   public:
-//    using Task::Task;
-    BlinkyTask()
-    : freertos::Task("Blinky", printy_stack.data(), TASK_STACK_SIZES)
-    {
-    }
+    using Task::Task;
 
     [[noreturn]] void run() override
     {
@@ -135,38 +169,26 @@ class PrintyTask : public freertos::Task {
   public:
     using Task::Task;
 
-    const char* message = "hello from printy task\n\r";
-    const size_t msg_len = strlen(message);
-
-    const char* pass_message = "value passed\n\r";
-    const size_t pass_msg_len = strlen(pass_message);
-
-    const char* fail_high_message = "value too high\n\r";
-    const size_t fail_high_msg_len = strlen(fail_high_message);
-
-    const char* fail_low_message = "value too low\n\r";
-    const size_t fail_low_msg_len = strlen(fail_low_message);
-
     [[noreturn]] void run() override
     {
 
-      HAL_UART_Transmit(&huart2, (uint8_t*) message, msg_len, 0xFFFF);
+      LOG("hello from printy task");
 
       loop {
 
         for (int i = 0; i < 15; ++i) {
           auto ret = within_range(i);
           if (ret.has_value()) {
-            HAL_UART_Transmit(&huart2, (uint8_t*) pass_message, pass_msg_len, 0xFFFF);
+            LOG("value %d passed", i);
             continue;
           }
 
           switch (ret.error()) {
             case MyError::too_low:
-              HAL_UART_Transmit(&huart2, (uint8_t*) fail_low_message, fail_low_msg_len, 0xFFFF);
+              LOG("value %d too low", i);
               break;
             case MyError::too_high:
-              HAL_UART_Transmit(&huart2, (uint8_t*) fail_high_message, fail_high_msg_len, 0xFFFF);
+              LOG("value %d too high", i);
               break;
             case MyError::not_a_number:
               break;
@@ -178,14 +200,249 @@ class PrintyTask : public freertos::Task {
     }
 };
 
+/**
+ * Low priority task shipping binary log records out of the UART.
+ * Decode the stream with tools/log_decode.py.
+ */
+class LogTask : public freertos::Task {
+  public:
+    using Task::Task;
+
+    [[noreturn]] void run() override
+    {
+      loop {
+        const size_t length = logging::drain(log_tx_chunk.data(), log_tx_chunk.size(), portMAX_DELAY);
+        if (length == 0) {
+          continue;
+        }
+
+        uart_tx.write(log_tx_chunk.data(), length);
+
+        // The transmitter does not copy, hold on to the chunk until it is out.
+        (void) uart_tx.flush();
+      }
+    }
+};
+
+
+/**
+ * Task name padded with spaces to 8 characters. The binary logger has no
+ * %s, names are sent as characters.
+ */
+static std::array<char, 8> padded_name(const char* name)
+{
+  std::array<char, 8> padded{};
+  padded.fill(' ');
+  for (size_t i = 0; i < padded.size() && name[i] != '\0'; ++i) {
+    padded[i] = name[i];
+  }
+  return padded;
+}
+
+/**
+ * Sends a run time statistics snapshot through the log stream each time
+ * an 's' is read from stdin, the UART. Every line covers the time since the
+ * previous request.
+ *
+ * A 't' records a kernel trace window and sends it as "trace" blobs,
+ * tools/trace_convert.py turns the capture into a Chrome trace.
+ *
+ * On start it first dumps the flight recorder session from before the
+ * last reset, if there is one.
+ */
+class StatsTask : public freertos::Task {
+  public:
+    using Task::Task;
+
+    [[noreturn]] void run() override
+    {
+      if (flight_recovered) {
+        dumpFlightLog(previous_flight);
+      }
+
+      loop {
+        uint8_t command = 0;
+        if (read(STDIN_FILENO, &command, 1) != 1) {
+          continue;
+        }
+
+        if (command == 's') {
+          sendStats();
+        } else if (command == 't') {
+          sendTrace();
+        }
+        checkStack();
+      }
+    }
+
+  private:
+    static constexpr size_t MAX_TASKS = 8;
+
+    /**
+     * Unused stack words below which STATS_STACK_SIZE needs raising.
+     */
+    static constexpr UBaseType_t STACK_MARGIN = 32;
+
+    /**
+     * Free log ring bytes to wait for before each dump line, more than the
+     * longest one takes.
+     */
+    static constexpr size_t FLIGHT_LINE_ROOM = 32;
+
+    /**
+     * Length of a trace capture. The trace is sent after the window, at
+     * 9600 baud sending it while recording would fill it with the UART
+     * transmitting its own records.
+     */
+    static constexpr uint32_t TRACE_WINDOW_MS = 500;
+
+    freertos::StatsSnapshot<MAX_TASKS> snapshot{};
+    std::array<TaskStatus_t, MAX_TASKS> flightTasks{};
+
+    static void waitForLogRoom(size_t room = FLIGHT_LINE_ROOM)
+    {
+      while (logging::space() < room) {
+        freertos::Task::delay_ms(10);
+      }
+    }
+
+    static void checkStack()
+    {
+      const UBaseType_t unused = uxTaskGetStackHighWaterMark(nullptr);
+      if (unused < STACK_MARGIN) {
+        waitForLogRoom();
+        LOG("stats: %u of %u stack words left, raise STATS_STACK_SIZE", unused, STATS_STACK_SIZE);
+      }
+    }
+
+    void sendStats()
+    {
+      if (!snapshot.sample()) {
+        LOG("stats: more than %u tasks", MAX_TASKS);
+        return;
+      }
+
+      const freertos::SystemStats& system = snapshot.system();
+      LOG("stats: %u tasks, %u switches, %u ISRs, ISR load %u.%u%%",
+          system.taskCount, system.contextSwitches, system.isrCount,
+          system.isrPermille / 10U, system.isrPermille % 10U);
+
+      for (const freertos::TaskStats& task : snapshot.tasks()) {
+        const std::array<char, 8> name = padded_name(task.name);
+        LOG("stats: %c%c%c%c%c%c%c%c prio %u cpu %u.%u%% stack %u words, %u switches",
+            name[0], name[1], name[2], name[3], name[4], name[5], name[6], name[7],
+            task.priority, task.cpuPermille / 10U, task.cpuPermille % 10U,
+            task.stackHighWaterMark, task.contextSwitches);
+      }
+    }
+
+    /**
+     * Records a trace window, then drains it through the log stream,
+     * waiting for room in the log ring so no part of it is lost.
+     */
+    void sendTrace()
+    {
+      freertos::Trace::start();
+      freertos::Task::delay_ms(TRACE_WINDOW_MS);
+      freertos::Trace::stop();
+
+      size_t length = 0;
+      while ((length = freertos::Trace::drain(trace_chunk.data(), trace_chunk.size())) != 0) {
+        waitForLogRoom(logging::FRAME_OVERHEAD + length);
+        (void) LOG_BLOB("trace", trace_chunk.data(), length);
+      }
 
-BlinkyTask blinky_task{};
+      waitForLogRoom();
+      LOG("trace: done, %u records dropped", freertos::Trace::dropped());
+    }
 
-std::array<StackType_t, TASK_STACK_SIZES> printy_stack{0};
-PrintyTask printy_task{"printy", printy_stack.data(), TASK_STACK_SIZES};
+    /**
+     * Sends a flight recorder session through the log stream, waiting for
+     * room in the log ring rather than losing lines. Task handles are
+     * listed with the names of the tasks running now, this firmware
+     * creates them at the same addresses on every boot.
+     */
+    void dumpFlightLog(const freertos::FlightLog& log)
+    {
+      using freertos::FlightEvent;
+      using freertos::FlightRecord;
+
+      waitForLogRoom();
+      LOG("flight: session %u, reset flags %x, %u records", log.sessions, log.resetFlags,
+          static_cast<uint32_t>(freertos::FlightRecorder::size(log)));
+
+      if (log.faulted != 0U) {
+        const freertos::FaultRegisters& fault = log.fault;
+        waitForLogRoom();
+        LOG("flight: fault CFSR %x HFSR %x MMFAR %x BFAR %x", fault.cfsr, fault.hfsr, fault.mmfar, fault.bfar);
+        waitForLogRoom();
+        LOG("flight: fault PC %x LR %x PSR %x SP %x EXC_RETURN %x", fault.pc, fault.lr, fault.psr, fault.sp,
+            fault.excReturn);
+        waitForLogRoom();
+        LOG("flight: fault R0 %x R1 %x R2 %x R3 %x R12 %x", fault.r0, fault.r1, fault.r2, fault.r3, fault.r12);
+      }
 
-std::array<uint32_t, 32> queue_buffer{0};
-auto q = freertos::makeQueue(queue_buffer);
+      const UBaseType_t count = uxTaskGetSystemState(flightTasks.data(), flightTasks.size(), nullptr);
+      for (UBaseType_t i = 0; i < count; ++i) {
+        const auto handle = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(flightTasks[i].xHandle));
+        const std::array<char, 8> name = padded_name(flightTasks[i].pcTaskName);
+        waitForLogRoom();
+        LOG("flight: task %x is %c%c%c%c%c%c%c%c", handle & FlightRecord::PAYLOAD_MASK,
+            name[0], name[1], name[2], name[3], name[4], name[5], name[6], name[7]);
+      }
+
+      // Timestamps are CPU cycles, each line shows the time since the
+      // previous record.
+      uint32_t previous = 0;
+      bool first = true;
+      freertos::FlightRecorder::forEach(log, [&](const FlightRecord& record) {
+        const uint32_t delta = first ? 0U : record.timestamp - previous;
+        previous = record.timestamp;
+        first = false;
+
+        waitForLogRoom();
+        switch (record.event()) {
+          case FlightEvent::TaskSwitch:
+            LOG("flight: +%u switch to task %x", delta, record.payload());
+            break;
+          case FlightEvent::Isr:
+            LOG("flight: +%u ISR, exception %u", delta, record.payload());
+            break;
+          case FlightEvent::Log:
+            LOG("flight: +%u log ID %x", delta, record.payload());
+            break;
+          case FlightEvent::Fault:
+            LOG("flight: +%u fault, CFSR %x", delta, record.payload());
+            break;
+          case FlightEvent::Mark:
+            LOG("flight: +%u mark %x", delta, record.payload());
+            break;
+          case FlightEvent::Empty:
+          default:
+            LOG("flight: +%u torn record %x", delta, record.word);
+            break;
+        }
+      });
+    }
+};
+
+/**
+ * Every task of the firmware, with their stacks. SYSTEM_RAM_BUDGET comes
+ * from CMakeLists.txt, which also hands it to the linker: the scripts
+ * fail the link unless SRAM1 has room for the full budget next to .data,
+ * .bss, the heap and the main stack. The build writes the layout to
+ * stm32_template.ram_map.txt.
+ */
+#ifndef SYSTEM_RAM_BUDGET
+#error "SYSTEM_RAM_BUDGET is set in CMakeLists.txt"
+#endif
+using AppSystem = freertos::System<SYSTEM_RAM_BUDGET,
+    freertos::TaskSpec<"blinky", BlinkyTask, TASK_STACK_SIZES>,
+    freertos::TaskSpec<"printy", PrintyTask, TASK_STACK_SIZES>,
+    freertos::TaskSpec<"log", LogTask, TASK_STACK_SIZES, 1>,
+    freertos::TaskSpec<"stats", StatsTask, STATS_STACK_SIZE, 1>>;
+
+FREERTOS_SYSTEM_DEFINE(AppSystem);
 
 /* USER CODE BEGIN PV */
 
@@ -196,6 +453,8 @@ void SystemClock_Config(void);
 
 static void MX_GPIO_Init(void);
 
+static void MX_DMA_Init(void);
+
 static void MX_USART2_UART_Init(void);
 
 void StartDefaultTask(void* argument);
@@ -220,6 +479,21 @@ namespace __gnu_cxx {
 
 extern "C" {
 
+/**
+ * Route newlib reads (scanf, fgets on stdin, ...) to the USART2 receiver.
+ * Overrides the weak stub in syscalls.c. This is the only consumer of the
+ * receive ring, readers in several tasks take turns on stdin_lock.
+ */
+int _read(int file, char* ptr, int len)
+{
+  (void) file;
+  if (len <= 0) {
+    return 0;
+  }
+  freertos::LockGuard<freertos::Mutex> guard{stdin_lock};
+  return static_cast<int>(uart_rx.read(reinterpret_cast<uint8_t*>(ptr), static_cast<size_t>(len)));
+}
+
 void __cxa_pure_virtual()
 {
   while (true) {
@@ -262,11 +536,12 @@ int main()
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-
+  flight_recovered = freertos::FlightRecorder::start(previous_flight);
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
 
@@ -294,8 +569,8 @@ int main()
   /* Create the thread(s) */
   /* creation of defaultTask */
 //  defaultTaskHandle = osThreadNew(StartDefaultTask, NULL, &defaultTask_attributes);
-  blinky_task.start(nullptr);
-  printy_task.start(nullptr);
+  AppSystem::startTasks();
+  freertos::Stats::start();
 
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
@@ -394,10 +669,29 @@ static void MX_USART2_UART_Init()
     Error_Handler();
   }
   /* USER CODE BEGIN USART2_Init 2 */
-
+  if (!uart_rx.start()) {
+    Error_Handler();
+  }
   /* USER CODE END USART2_Init 2 */
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init()
+{
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Stream5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+  /* DMA1_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -485,6 +779,53 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim)
   /* USER CODE END Callback 1 */
 }
 
+/**
+  * @brief  Tx Transfer completed callback
+  * @note   Chains the next queued buffer of the DMA transmitter.
+  * @param  huart : UART handle
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart)
+{
+  if (huart->Instance == USART2) {
+    uart_tx.onTxComplete();
+  }
+}
+
+/**
+  * @brief  Reception Event Callback (Rx event notification)
+  * @note   Raised on DMA half transfer, transfer complete and idle line.
+  * @param  huart : UART handle
+  * @param  Size : Position the DMA has reached in the receive buffer
+  * @retval None
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t Size)
+{
+  if (huart->Instance == USART2) {
+    // The DMA interrupt reports half transfer and transfer complete, the
+    // UART interrupt the idle line. The active exception is IRQn + 16.
+    if (__get_IPSR() != static_cast<uint32_t>(DMA1_Stream5_IRQn) + 16U) {
+      uart_rx.onRxEvent(UartRx::RxEvent::Idle);
+    } else if (Size == UartRx::DMA_BUFFER_SIZE) {
+      uart_rx.onRxEvent(UartRx::RxEvent::TransferComplete);
+    } else {
+      uart_rx.onRxEvent(UartRx::RxEvent::HalfTransfer);
+    }
+  }
+}
+
+/**
+  * @brief  UART error callback
+  * @param  huart : UART handle
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
+{
+  if (huart->Instance == USART2) {
+    uart_rx.onError();
+  }
+}
+
 /**
   * @brief  This function is executed in case of error occurrence.
   * @retval None
@@ -23,6 +23,7 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "FreeRTOS.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -37,7 +38,19 @@
 
 /* Private macro -------------------------------------------------------------*/
 /* USER CODE BEGIN PM */
-
+/**
+  * @brief Entry of the fault handlers, before anything else is pushed:
+  *        passes the exception frame, on whichever stack the fault was
+  *        taken, and EXC_RETURN on to record_fault_and_reset().
+  */
+#define FAULT_ENTRY()                   \
+  __asm volatile(                       \
+      "tst   lr, #4                 \n"  \
+      "ite   eq                     \n"  \
+      "mrseq r0, msp                \n"  \
+      "mrsne r0, psp                \n"  \
+      "mov   r1, lr                 \n"  \
+      "b     record_fault_and_reset \n")
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
@@ -47,15 +60,39 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
-
+void record_fault_and_reset(const uint32_t *frame, uint32_t exc_return) __attribute__((used, noreturn));
+void HardFault_Handler(void) __attribute__((naked));
+void MemManage_Handler(void) __attribute__((naked));
+void BusFault_Handler(void) __attribute__((naked));
+void UsageFault_Handler(void) __attribute__((naked));
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-
+/**
+  * @brief Store the fault registers in the flight recorder and reset, the
+  *        next boot dumps them. Stays here while a debugger is attached,
+  *        FAULT_ENTRY() branches in and there is nothing to return to.
+  * @param frame Exception frame stacked by the fault.
+  * @param exc_return EXC_RETURN value the fault handler was entered with.
+  */
+void record_fault_and_reset(const uint32_t *frame, uint32_t exc_return)
+{
+  freertos_flight_fault(frame, exc_return);
+  if ((CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk) == 0U)
+  {
+    NVIC_SystemReset();
+  }
+  while (1)
+  {
+  }
+}
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
+extern DMA_HandleTypeDef hdma_usart2_rx;
+extern DMA_HandleTypeDef hdma_usart2_tx;
+extern UART_HandleTypeDef huart2;
 extern TIM_HandleTypeDef htim6;
 
 /* USER CODE BEGIN EV */
@@ -86,7 +123,7 @@ void NMI_Handler(void)
 void HardFault_Handler(void)
 {
   /* USER CODE BEGIN HardFault_IRQn 0 */
-
+  FAULT_ENTRY();
   /* USER CODE END HardFault_IRQn 0 */
   while (1)
   {
@@ -101,7 +138,7 @@ void HardFault_Handler(void)
 void MemManage_Handler(void)
 {
   /* USER CODE BEGIN MemoryManagement_IRQn 0 */
-
+  FAULT_ENTRY();
   /* USER CODE END MemoryManagement_IRQn 0 */
   while (1)
   {
@@ -116,7 +153,7 @@ void MemManage_Handler(void)
 void BusFault_Handler(void)
 {
   /* USER CODE BEGIN BusFault_IRQn 0 */
-
+  FAULT_ENTRY();
   /* USER CODE END BusFault_IRQn 0 */
   while (1)
   {
@@ -131,7 +168,7 @@ void BusFault_Handler(void)
 void UsageFault_Handler(void)
 {
   /* USER CODE BEGIN UsageFault_IRQn 0 */
-
+  FAULT_ENTRY();
   /* USER CODE END UsageFault_IRQn 0 */
   while (1)
   {
@@ -160,13 +197,64 @@ void DebugMon_Handler(void)
 /* please refer to the startup file (startup_stm32f4xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles DMA1 stream5 global interrupt.
+  */
+void DMA1_Stream5_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream5_IRQn 0 */
+  const uint32_t isr_start = freertos_stats_isr_enter();
+  freertos_flight_isr();
+  freertos_trace_isr_enter();
+  /* USER CODE END DMA1_Stream5_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart2_rx);
+  /* USER CODE BEGIN DMA1_Stream5_IRQn 1 */
+  freertos_trace_isr_exit();
+  freertos_stats_isr_exit(isr_start);
+  /* USER CODE END DMA1_Stream5_IRQn 1 */
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt.
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream6_IRQn 0 */
+  const uint32_t isr_start = freertos_stats_isr_enter();
+  freertos_flight_isr();
+  freertos_trace_isr_enter();
+  /* USER CODE END DMA1_Stream6_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart2_tx);
+  /* USER CODE BEGIN DMA1_Stream6_IRQn 1 */
+  freertos_trace_isr_exit();
+  freertos_stats_isr_exit(isr_start);
+  /* USER CODE END DMA1_Stream6_IRQn 1 */
+}
+
+/**
+  * @brief This function handles USART2 global interrupt.
+  */
+void USART2_IRQHandler(void)
+{
+  /* USER CODE BEGIN USART2_IRQn 0 */
+  const uint32_t isr_start = freertos_stats_isr_enter();
+  freertos_flight_isr();
+  freertos_trace_isr_enter();
+  /* USER CODE END USART2_IRQn 0 */
+  HAL_UART_IRQHandler(&huart2);
+  /* USER CODE BEGIN USART2_IRQn 1 */
+  freertos_trace_isr_exit();
+  freertos_stats_isr_exit(isr_start);
+  /* USER CODE END USART2_IRQn 1 */
+}
+
 /**
   * @brief This function handles TIM6 global interrupt and DAC1, DAC2 underrun error interrupts.
   */
 void TIM6_DAC_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM6_DAC_IRQn 0 */
-
+  freertos_flight_isr();
   /* USER CODE END TIM6_DAC_IRQn 0 */
   HAL_TIM_IRQHandler(&htim6);
   /* USER CODE BEGIN TIM6_DAC_IRQn 1 */
@@ -0,0 +1,112 @@
+/*
+ * Biquad.cpp
+ *
+ *  Second order section cascades.
+ */
+
+#include "Kernels.hpp"
+
+namespace dsp {
+
+  void biquad(const float* coefficients, size_t stages, float* state,
+      const float* input, float* output, size_t count)
+  {
+    // One section at a time over the whole block keeps its coefficients
+    // and state in registers.
+    const float* source = input;
+    for (size_t stage = 0; stage < stages; ++stage) {
+      const float* c = coefficients + 5 * stage;
+      const float b0 = c[0];
+      const float b1 = c[1];
+      const float b2 = c[2];
+      const float a1 = c[3];
+      const float a2 = c[4];
+      float d1 = state[2 * stage];
+      float d2 = state[2 * stage + 1];
+
+      for (size_t n = 0; n < count; ++n) {
+        const float x = source[n];
+        const float y = b0 * x + d1;
+        d1 = b1 * x - a1 * y + d2;
+        d2 = b2 * x - a2 * y;
+        output[n] = y;
+      }
+
+      state[2 * stage] = d1;
+      state[2 * stage + 1] = d2;
+      source = output;
+    }
+  }
+
+  void biquad(const q15_t* coefficients, size_t stages, uint8_t postShift, q15_t* state,
+      const q15_t* input, q15_t* output, size_t count)
+  {
+    using namespace simd;
+
+    const int shift = 15 - postShift;
+    const q15_t* source = input;
+    for (size_t stage = 0; stage < stages; ++stage) {
+      const q15_t* c = coefficients + 5 * stage;
+      q15_t* s = state + 4 * stage;
+      const int32_t b0 = c[0];
+      const int32_t b12 = read2(c + 1);
+      const int32_t a12 = read2(c + 3);
+      // {x1, x2} and {y1, y2} packed, one dual MAC each.
+      int32_t xs = read2(s);
+      int32_t ys = read2(s + 2);
+
+      for (size_t n = 0; n < count; ++n) {
+        const int32_t x = source[n];
+        int64_t acc = b0 * x;
+        acc = smlald(xs, b12, acc);
+        acc = smlald(ys, a12, acc);
+        const int32_t y = ssat<16>(static_cast<int32_t>(acc >> shift));
+        xs = pack(x, xs);
+        ys = pack(y, ys);
+        output[n] = static_cast<q15_t>(y);
+      }
+
+      write2(s, xs);
+      write2(s + 2, ys);
+      source = output;
+    }
+  }
+
+  void biquad(const q31_t* coefficients, size_t stages, uint8_t postShift, q31_t* state,
+      const q31_t* input, q31_t* output, size_t count)
+  {
+    const int shift = 31 - postShift;
+    const q31_t* source = input;
+    for (size_t stage = 0; stage < stages; ++stage) {
+      const q31_t* c = coefficients + 5 * stage;
+      q31_t* s = state + 4 * stage;
+      const int64_t b0 = c[0];
+      const int64_t b1 = c[1];
+      const int64_t b2 = c[2];
+      const int64_t a1 = c[3];
+      const int64_t a2 = c[4];
+      q31_t x1 = s[0];
+      q31_t x2 = s[1];
+      q31_t y1 = s[2];
+      q31_t y2 = s[3];
+
+      for (size_t n = 0; n < count; ++n) {
+        const q31_t x = source[n];
+        const int64_t acc = b0 * x + b1 * x1 + b2 * x2 + a1 * y1 + a2 * y2;
+        const q31_t y = simd::saturate31(acc >> shift);
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        output[n] = y;
+      }
+
+      s[0] = x1;
+      s[1] = x2;
+      s[2] = y1;
+      s[3] = y2;
+      source = output;
+    }
+  }
+
+} // namespace dsp
@@ -0,0 +1,101 @@
+/*
+ * Biquad.hpp
+ *
+ *  Cascades of second order IIR sections in float, Q15 and Q31.
+ */
+
+#ifndef LIB_DSP_BIQUAD_HPP_
+#define LIB_DSP_BIQUAD_HPP_
+
+#include "Kernels.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace dsp {
+
+  /**
+   *  Stages second order sections in series, each
+   *
+   *      y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+   *
+   *  with coefficients {b0, b1, b2, a1, a2} as filter design tools give
+   *  them, a0 normalised to 1.
+   *
+   *  Fixed point coefficients beyond [-1, 1) are scaled down by
+   *  2^postShift, the accumulator is shifted back before saturating. An
+   *  a1 or a2 of exactly -1 << postShift becomes the largest positive
+   *  value once negated.
+   *
+   *      BiquadCascade<q15_t, 2> notch{{{...}, {...}}, 1};
+   *      notch.process(block.data(), block.data(), block.size());
+   */
+  template<typename Sample, size_t Stages>
+  class BiquadCascade {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using Section = std::array<Sample, 5>;
+
+      explicit BiquadCascade(const std::array<Section, Stages>& sections, uint8_t postShift = 0)
+          :m_postShift(postShift)
+      {
+        for (size_t stage = 0; stage < Stages; ++stage) {
+          for (size_t i = 0; i < 5; ++i) {
+            m_coefficients[5 * stage + i] = i < 3 ? sections[stage][i] : negateForKernel(sections[stage][i]);
+          }
+        }
+      }
+
+      /**
+       *  Filter count samples, input and output may be the same buffer.
+       */
+      void process(const Sample* input, Sample* output, size_t count)
+      {
+        if constexpr (std::is_floating_point_v<Sample>) {
+          biquad(m_coefficients.data(), Stages, m_state.data(), input, output, count);
+        } else {
+          biquad(m_coefficients.data(), Stages, m_postShift, m_state.data(), input, output, count);
+        }
+      }
+
+      void reset()
+      {
+        m_state.fill(Sample{});
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      // Float sections keep a1 and a2, fixed point ones multiply
+      // accumulate -a1 and -a2.
+      static Sample negateForKernel(Sample a)
+      {
+        if constexpr (std::is_floating_point_v<Sample>) {
+          return a;
+        } else if constexpr (sizeof(Sample) == sizeof(q15_t)) {
+          return static_cast<Sample>(simd::ssat<16>(-a));
+        } else {
+          return simd::saturate31(-static_cast<int64_t>(a));
+        }
+      }
+
+      static constexpr size_t STATE = std::is_floating_point_v<Sample> ? 2 : 4;
+
+      std::array<Sample, 5 * Stages> m_coefficients{};
+      std::array<Sample, STATE * Stages> m_state{};
+      uint8_t m_postShift;
+  };
+
+} // namespace dsp
+
+#endif /* LIB_DSP_BIQUAD_HPP_ */
@@ -0,0 +1,258 @@
+/*
+ * Fft.cpp
+ *
+ *  Real FFT: a radix 2 complex FFT of n / 2 points over the packed even
+ *  and odd samples, then one split pass to the n / 2 + 1 real spectrum
+ *  bins.
+ */
+
+#include "Kernels.hpp"
+
+namespace dsp {
+
+  namespace {
+
+    /**
+     *  Complex arithmetic per sample type. Fixed point halves every
+     *  butterfly, so values never outgrow the format.
+     */
+    template<typename Sample>
+    struct Arithmetic;
+
+    template<>
+    struct Arithmetic<float> {
+      struct Value {
+        float re;
+        float im;
+      };
+
+      static Value load(const float* z, size_t index)
+      {
+        return {z[2 * index], z[2 * index + 1]};
+      }
+
+      static void store(float* z, size_t index, Value value)
+      {
+        z[2 * index] = value.re;
+        z[2 * index + 1] = value.im;
+      }
+
+      static Value input(const float* x, size_t index)
+      {
+        return load(x, index);
+      }
+
+      static Value multiply(Value v, Value w)
+      {
+        return {v.re * w.re - v.im * w.im, v.re * w.im + v.im * w.re};
+      }
+
+      static void butterfly(Value& a, Value& b, Value w)
+      {
+        const Value t = multiply(b, w);
+        b = {a.re - t.re, a.im - t.im};
+        a = {a.re + t.re, a.im + t.im};
+      }
+
+      static void split(Value& zk, Value& zc, Value w)
+      {
+        const Value e{0.5F * (zk.re + zc.re), 0.5F * (zk.im - zc.im)};
+        const Value o = multiply({0.5F * (zk.im + zc.im), 0.5F * (zc.re - zk.re)}, w);
+        zk = {e.re + o.re, e.im + o.im};
+        zc = {e.re - o.re, o.im - e.im};
+      }
+
+      static void edges(Value z0, Value& x0, Value& xm)
+      {
+        x0 = {z0.re + z0.im, 0.0F};
+        xm = {z0.re - z0.im, 0.0F};
+      }
+    };
+
+    /**
+     *  Q15 complex values stay packed in one register, real part low.
+     */
+    template<>
+    struct Arithmetic<q15_t> {
+      using Value = int32_t;
+
+      static Value load(const q15_t* z, size_t index)
+      {
+        return simd::read2(z + 2 * index);
+      }
+
+      static void store(q15_t* z, size_t index, Value value)
+      {
+        simd::write2(z + 2 * index, value);
+      }
+
+      static Value input(const q15_t* x, size_t index)
+      {
+        // Halved so the packed pairs stay within unit magnitude.
+        return simd::shadd16(load(x, index), 0);
+      }
+
+      static Value multiply(Value v, Value w)
+      {
+        return simd::pack(simd::smusd(v, w) >> 15, simd::smuadx(v, w) >> 15);
+      }
+
+      static void butterfly(Value& a, Value& b, Value w)
+      {
+        const Value t = multiply(b, w);
+        b = simd::shsub16(a, t);
+        a = simd::shadd16(a, t);
+      }
+
+      static void split(Value& zk, Value& zc, Value w)
+      {
+        using namespace simd;
+        const Value sum = shadd16(zk, zc);
+        const Value e = pack(low(sum), high(shsub16(zk, zc)));
+        const Value o = multiply(pack(high(sum), low(shsub16(zc, zk))), w);
+        zk = qadd16(e, o);
+        zc = pack(low(qsub16(e, o)), high(qsub16(o, e)));
+      }
+
+      static void edges(Value z0, Value& x0, Value& xm)
+      {
+        using namespace simd;
+        x0 = pack(ssat<16>(low(z0) + high(z0)), 0);
+        xm = pack(ssat<16>(low(z0) - high(z0)), 0);
+      }
+    };
+
+    template<>
+    struct Arithmetic<q31_t> {
+      struct Value {
+        q31_t re;
+        q31_t im;
+      };
+
+      static Value load(const q31_t* z, size_t index)
+      {
+        return {z[2 * index], z[2 * index + 1]};
+      }
+
+      static void store(q31_t* z, size_t index, Value value)
+      {
+        z[2 * index] = value.re;
+        z[2 * index + 1] = value.im;
+      }
+
+      static Value input(const q31_t* x, size_t index)
+      {
+        return {x[2 * index] >> 1, x[2 * index + 1] >> 1};
+      }
+
+      static q31_t half(int64_t value)
+      {
+        return static_cast<q31_t>(value >> 1);
+      }
+
+      static Value multiply(Value v, Value w)
+      {
+        const int64_t re = static_cast<int64_t>(v.re) * w.re - static_cast<int64_t>(v.im) * w.im;
+        const int64_t im = static_cast<int64_t>(v.re) * w.im + static_cast<int64_t>(v.im) * w.re;
+        return {static_cast<q31_t>(re >> 31), static_cast<q31_t>(im >> 31)};
+      }
+
+      static void butterfly(Value& a, Value& b, Value w)
+      {
+        const Value t = multiply(b, w);
+        b = {half(static_cast<int64_t>(a.re) - t.re), half(static_cast<int64_t>(a.im) - t.im)};
+        a = {half(static_cast<int64_t>(a.re) + t.re), half(static_cast<int64_t>(a.im) + t.im)};
+      }
+
+      static void split(Value& zk, Value& zc, Value w)
+      {
+        const Value e{half(static_cast<int64_t>(zk.re) + zc.re), half(static_cast<int64_t>(zk.im) - zc.im)};
+        const Value o = multiply({half(static_cast<int64_t>(zk.im) + zc.im),
+            half(static_cast<int64_t>(zc.re) - zk.re)}, w);
+        zk = {simd::saturate31(static_cast<int64_t>(e.re) + o.re), simd::saturate31(static_cast<int64_t>(e.im) + o.im)};
+        zc = {simd::saturate31(static_cast<int64_t>(e.re) - o.re), simd::saturate31(static_cast<int64_t>(o.im) - e.im)};
+      }
+
+      static void edges(Value z0, Value& x0, Value& xm)
+      {
+        x0 = {simd::saturate31(static_cast<int64_t>(z0.re) + z0.im), 0};
+        xm = {simd::saturate31(static_cast<int64_t>(z0.re) - z0.im), 0};
+      }
+    };
+
+    inline size_t reverse(size_t index, size_t bits)
+    {
+      size_t reversed = 0;
+      for (size_t bit = 0; bit < bits; ++bit) {
+        reversed = (reversed << 1) | ((index >> bit) & 1U);
+      }
+      return reversed;
+    }
+
+    template<typename Sample>
+    void transform(const Sample* input, Sample* z, size_t n, const Sample* twiddles)
+    {
+      using Ops = Arithmetic<Sample>;
+      using Value = typename Ops::Value;
+
+      const size_t m = n / 2;
+      size_t bits = 0;
+      while ((size_t{1} << bits) < m) {
+        ++bits;
+      }
+
+      for (size_t i = 0; i < m; ++i) {
+        Ops::store(z, reverse(i, bits), Ops::input(input, i));
+      }
+
+      // Twiddle outermost, so each is loaded once per stage. The n point
+      // table serves the n / 2 point transform at twice the stride.
+      for (size_t size = 2; size <= m; size *= 2) {
+        const size_t half = size / 2;
+        const size_t stride = n / size;
+        for (size_t j = 0; j < half; ++j) {
+          const Value w = Ops::load(twiddles, j * stride);
+          for (size_t start = j; start < m; start += size) {
+            Value a = Ops::load(z, start);
+            Value b = Ops::load(z, start + half);
+            Ops::butterfly(a, b, w);
+            Ops::store(z, start, a);
+            Ops::store(z, start + half, b);
+          }
+        }
+      }
+
+      Value x0;
+      Value xm;
+      Ops::edges(Ops::load(z, 0), x0, xm);
+      Ops::store(z, 0, x0);
+      Ops::store(z, m, xm);
+
+      for (size_t k = 1; k <= m / 2; ++k) {
+        Value zk = Ops::load(z, k);
+        Value zc = Ops::load(z, m - k);
+        Ops::split(zk, zc, Ops::load(twiddles, k));
+        // At k == m / 2 both are the same bin, zk is the one kept.
+        Ops::store(z, m - k, zc);
+        Ops::store(z, k, zk);
+      }
+    }
+
+  } // namespace
+
+  void rfft(const float* input, float* spectrum, size_t n, const float* twiddles)
+  {
+    transform(input, spectrum, n, twiddles);
+  }
+
+  void rfft(const q15_t* input, q15_t* spectrum, size_t n, const q15_t* twiddles)
+  {
+    transform(input, spectrum, n, twiddles);
+  }
+
+  void rfft(const q31_t* input, q31_t* spectrum, size_t n, const q31_t* twiddles)
+  {
+    transform(input, spectrum, n, twiddles);
+  }
+
+} // namespace dsp
@@ -0,0 +1,141 @@
+/*
+ * Fft.hpp
+ *
+ *  Real input FFT in float, Q15 and Q31 with twiddle tables computed at
+ *  compile time.
+ */
+
+#ifndef LIB_DSP_FFT_HPP_
+#define LIB_DSP_FFT_HPP_
+
+#include "Kernels.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace dsp {
+
+  namespace detail {
+
+    constexpr double PI = 3.14159265358979323846;
+
+    /**
+     *  Taylor series, exact to double precision for |x| <= pi / 4.
+     */
+    constexpr double sinSeries(double x)
+    {
+      double term = x;
+      double sum = x;
+      for (int i = 1; i < 12; ++i) {
+        term *= -x * x / ((2.0 * i) * (2.0 * i + 1.0));
+        sum += term;
+      }
+      return sum;
+    }
+
+    constexpr double cosSeries(double x)
+    {
+      double term = 1.0;
+      double sum = 1.0;
+      for (int i = 1; i < 12; ++i) {
+        term *= -x * x / ((2.0 * i - 1.0) * (2.0 * i));
+        sum += term;
+      }
+      return sum;
+    }
+
+    /**
+     *  cos and sin of 2 pi k / n, reduced to the nearest quarter turn.
+     */
+    constexpr std::pair<double, double> unit(size_t k, size_t n)
+    {
+      const size_t quadrant = (4 * k + n / 2) / n;
+      const double x = PI / 2.0 * (static_cast<double>(4 * k) - static_cast<double>(quadrant * n)) / static_cast<double>(n);
+      const double s = sinSeries(x);
+      const double c = cosSeries(x);
+      switch (quadrant % 4) {
+        case 0:
+          return {c, s};
+        case 1:
+          return {-s, c};
+        case 2:
+          return {-c, -s};
+        default:
+          return {s, -c};
+      }
+    }
+
+    template<typename Sample>
+    constexpr Sample quantize(double value)
+    {
+      if constexpr (std::is_floating_point_v<Sample>) {
+        return static_cast<Sample>(value);
+      } else {
+        // -1 is left out as well as +1: a twiddle of -1 times a sample
+        // of -1 would overflow the complex multiply.
+        constexpr double scale = sizeof(Sample) == sizeof(q15_t) ? 32768.0 : 2147483648.0;
+        const double scaled = value * scale;
+        const double rounded = scaled >= 0.0 ? scaled + 0.5 : scaled - 0.5;
+        const double limited = rounded > scale - 1.0 ? scale - 1.0 : rounded < 1.0 - scale ? 1.0 - scale : rounded;
+        return static_cast<Sample>(static_cast<int64_t>(limited));
+      }
+    }
+
+    template<typename Sample, size_t N>
+    constexpr std::array<Sample, N> makeTwiddles()
+    {
+      std::array<Sample, N> twiddles{};
+      for (size_t k = 0; k < N / 2; ++k) {
+        const auto [c, s] = unit(k, N);
+        twiddles[2 * k] = quantize<Sample>(c);
+        twiddles[2 * k + 1] = quantize<Sample>(-s);
+      }
+      return twiddles;
+    }
+
+  } // namespace detail
+
+  /**
+   *  Forward FFT of N real samples into N / 2 + 1 complex bins.
+   *
+   *      RealFft<q15_t, 256>::Spectrum spectrum;
+   *      RealFft<q15_t, 256>::forward(samples, spectrum);
+   *      // bin k: spectrum[2 * k] + i spectrum[2 * k + 1]
+   *
+   *  The twiddle table is constexpr and lands in flash. Fixed point bins
+   *  are the true spectrum divided by N.
+   */
+  template<typename Sample, size_t N>
+  class RealFft {
+
+      static_assert(N >= 4 && (N & (N - 1)) == 0, "RealFft size must be a power of two of at least 4");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      static constexpr size_t size = N;
+      static constexpr size_t bins = N / 2 + 1;
+
+      using Input = std::array<Sample, N>;
+      using Spectrum = std::array<Sample, 2 * bins>;
+
+      /**
+       *  N / 2 values of exp(-2 pi i k / N), interleaved.
+       */
+      static constexpr std::array<Sample, N> twiddles = detail::makeTwiddles<Sample, N>();
+
+      static void forward(const Input& input, Spectrum& spectrum)
+      {
+        rfft(input.data(), spectrum.data(), N, twiddles.data());
+      }
+  };
+
+} // namespace dsp
+
+#endif /* LIB_DSP_FFT_HPP_ */
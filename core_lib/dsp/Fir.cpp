@@ -0,0 +1,210 @@
+/*
+ * Fir.cpp
+ *
+ *  FIR and decimating FIR kernels.
+ */
+
+#include "Kernels.hpp"
+
+#include <algorithm>
+
+namespace dsp {
+
+  namespace {
+
+    using simd::read2;
+    using simd::smlald;
+
+    inline float dot(const float* coefficients, const float* x, size_t taps)
+    {
+      // Four independent sums keep the FPU pipeline busy.
+      float sum0 = 0.0F;
+      float sum1 = 0.0F;
+      float sum2 = 0.0F;
+      float sum3 = 0.0F;
+      size_t k = 0;
+      for (; k + 4 <= taps; k += 4) {
+        sum0 += coefficients[k] * x[k];
+        sum1 += coefficients[k + 1] * x[k + 1];
+        sum2 += coefficients[k + 2] * x[k + 2];
+        sum3 += coefficients[k + 3] * x[k + 3];
+      }
+      for (; k < taps; ++k) {
+        sum0 += coefficients[k] * x[k];
+      }
+      return (sum0 + sum1) + (sum2 + sum3);
+    }
+
+    inline int64_t dot(const q15_t* coefficients, const q15_t* x, size_t taps)
+    {
+      int64_t acc = 0;
+      size_t k = 0;
+      for (; k + 4 <= taps; k += 4) {
+        acc = smlald(read2(x + k), read2(coefficients + k), acc);
+        acc = smlald(read2(x + k + 2), read2(coefficients + k + 2), acc);
+      }
+      for (; k < taps; ++k) {
+        acc += coefficients[k] * x[k];
+      }
+      return acc;
+    }
+
+    inline int64_t dot(const q31_t* coefficients, const q31_t* x, size_t taps)
+    {
+      int64_t acc = 0;
+      size_t k = 0;
+      for (; k + 2 <= taps; k += 2) {
+        acc += static_cast<int64_t>(coefficients[k]) * x[k];
+        acc += static_cast<int64_t>(coefficients[k + 1]) * x[k + 1];
+      }
+      if (k < taps) {
+        acc += static_cast<int64_t>(coefficients[k]) * x[k];
+      }
+      return acc;
+    }
+
+    inline q15_t narrow15(int64_t acc)
+    {
+      return static_cast<q15_t>(simd::ssat<16>(static_cast<int32_t>(acc >> 15)));
+    }
+
+    inline q31_t narrow31(int64_t acc)
+    {
+      return simd::saturate31(acc >> 31);
+    }
+
+    template<typename Sample>
+    inline void shiftHistory(Sample* state, size_t taps, size_t count)
+    {
+      std::copy(state + count, state + count + taps - 1, state);
+    }
+
+  } // namespace
+
+  void fir(const float* coefficients, size_t taps, float* state, const float* input, float* output, size_t count)
+  {
+    std::copy(input, input + count, state + taps - 1);
+
+    // Four outputs per pass share every coefficient load, the samples
+    // slide through registers.
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+      const float* x = state + n;
+      float acc0 = 0.0F;
+      float acc1 = 0.0F;
+      float acc2 = 0.0F;
+      float acc3 = 0.0F;
+      float x0 = x[0];
+      float x1 = x[1];
+      float x2 = x[2];
+      for (size_t k = 0; k < taps; ++k) {
+        const float c = coefficients[k];
+        const float x3 = x[k + 3];
+        acc0 += c * x0;
+        acc1 += c * x1;
+        acc2 += c * x2;
+        acc3 += c * x3;
+        x0 = x1;
+        x1 = x2;
+        x2 = x3;
+      }
+      output[n] = acc0;
+      output[n + 1] = acc1;
+      output[n + 2] = acc2;
+      output[n + 3] = acc3;
+    }
+    for (; n < count; ++n) {
+      output[n] = dot(coefficients, state + n, taps);
+    }
+
+    shiftHistory(state, taps, count);
+  }
+
+  void fir(const q15_t* coefficients, size_t taps, q15_t* state, const q15_t* input, q15_t* output, size_t count)
+  {
+    std::copy(input, input + count, state + taps - 1);
+
+    // Two outputs per pass, each coefficient pair feeds two dual MACs.
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+      const q15_t* x = state + n;
+      int64_t acc0 = 0;
+      int64_t acc1 = 0;
+      size_t k = 0;
+      for (; k + 2 <= taps; k += 2) {
+        const int32_t c = read2(coefficients + k);
+        acc0 = smlald(read2(x + k), c, acc0);
+        acc1 = smlald(read2(x + k + 1), c, acc1);
+      }
+      if (k < taps) {
+        acc0 += coefficients[k] * x[k];
+        acc1 += coefficients[k] * x[k + 1];
+      }
+      output[n] = narrow15(acc0);
+      output[n + 1] = narrow15(acc1);
+    }
+    if (n < count) {
+      output[n] = narrow15(dot(coefficients, state + n, taps));
+    }
+
+    shiftHistory(state, taps, count);
+  }
+
+  void fir(const q31_t* coefficients, size_t taps, q31_t* state, const q31_t* input, q31_t* output, size_t count)
+  {
+    std::copy(input, input + count, state + taps - 1);
+
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+      const q31_t* x = state + n;
+      int64_t acc0 = 0;
+      int64_t acc1 = 0;
+      q31_t x0 = x[0];
+      for (size_t k = 0; k < taps; ++k) {
+        const int64_t c = coefficients[k];
+        const q31_t x1 = x[k + 1];
+        acc0 += c * x0;
+        acc1 += c * x1;
+        x0 = x1;
+      }
+      output[n] = narrow31(acc0);
+      output[n + 1] = narrow31(acc1);
+    }
+    if (n < count) {
+      output[n] = narrow31(dot(coefficients, state + n, taps));
+    }
+
+    shiftHistory(state, taps, count);
+  }
+
+  void firDecimate(const float* coefficients, size_t taps, size_t factor, float* state,
+      const float* input, float* output, size_t count)
+  {
+    std::copy(input, input + count, state + taps - 1);
+    for (size_t m = 0; m < count / factor; ++m) {
+      output[m] = dot(coefficients, state + m * factor + factor - 1, taps);
+    }
+    shiftHistory(state, taps, count);
+  }
+
+  void firDecimate(const q15_t* coefficients, size_t taps, size_t factor, q15_t* state,
+      const q15_t* input, q15_t* output, size_t count)
+  {
+    std::copy(input, input + count, state + taps - 1);
+    for (size_t m = 0; m < count / factor; ++m) {
+      output[m] = narrow15(dot(coefficients, state + m * factor + factor - 1, taps));
+    }
+    shiftHistory(state, taps, count);
+  }
+
+  void firDecimate(const q31_t* coefficients, size_t taps, size_t factor, q31_t* state,
+      const q31_t* input, q31_t* output, size_t count)
+  {
+    std::copy(input, input + count, state + taps - 1);
+    for (size_t m = 0; m < count / factor; ++m) {
+      output[m] = narrow31(dot(coefficients, state + m * factor + factor - 1, taps));
+    }
+    shiftHistory(state, taps, count);
+  }
+
+} // namespace dsp
@@ -0,0 +1,127 @@
+/*
+ * Fir.hpp
+ *
+ *  Block FIR filters and decimators in float, Q15 and Q31.
+ */
+
+#ifndef LIB_DSP_FIR_HPP_
+#define LIB_DSP_FIR_HPP_
+
+#include "Kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace dsp {
+
+  /**
+   *  FIR filter of Taps coefficients, y[n] = sum h[k] x[n - k].
+   *
+   *  process() takes any number of samples and works through them Block
+   *  at a time, the history buffer is Taps - 1 + Block samples.
+   *
+   *      Fir<q15_t, 32> lowPass{coefficients};
+   *      lowPass.process(adc.data(), filtered.data(), adc.size());
+   *
+   *  Fixed point coefficients are in the sample format. Q15 results are
+   *  exact to the last bit and saturate. Q31 inputs need log2(Taps) - 1
+   *  bits of headroom.
+   */
+  template<typename Sample, size_t Taps, size_t Block = 32>
+  class Fir {
+
+      static_assert(Taps > 0 && Block > 0, "Fir needs taps and a block size");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      explicit Fir(const std::array<Sample, Taps>& coefficients)
+      {
+        std::reverse_copy(coefficients.begin(), coefficients.end(), m_coefficients.begin());
+      }
+
+      void process(const Sample* input, Sample* output, size_t count)
+      {
+        while (count > 0) {
+          const size_t chunk = std::min(count, Block);
+          fir(m_coefficients.data(), Taps, m_state.data(), input, output, chunk);
+          input += chunk;
+          output += chunk;
+          count -= chunk;
+        }
+      }
+
+      void reset()
+      {
+        m_state.fill(Sample{});
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      std::array<Sample, Taps> m_coefficients{};
+      std::array<Sample, Taps - 1 + Block> m_state{};
+  };
+
+  /**
+   *  FIR filter keeping one output in Factor, computing only those.
+   *
+   *  process() takes a multiple of Factor samples and returns the number
+   *  of outputs written. The coefficients should band limit to the output
+   *  rate, as for Fir.
+   */
+  template<typename Sample, size_t Taps, size_t Factor, size_t Block = 32>
+  class FirDecimator {
+
+      static_assert(Factor > 0 && Block % Factor == 0, "FirDecimator Block must be a multiple of Factor");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      explicit FirDecimator(const std::array<Sample, Taps>& coefficients)
+      {
+        std::reverse_copy(coefficients.begin(), coefficients.end(), m_coefficients.begin());
+      }
+
+      size_t process(const Sample* input, Sample* output, size_t count)
+      {
+        count -= count % Factor;
+        const size_t outputs = count / Factor;
+        while (count > 0) {
+          const size_t chunk = std::min(count, Block);
+          firDecimate(m_coefficients.data(), Taps, Factor, m_state.data(), input, output, chunk);
+          input += chunk;
+          output += chunk / Factor;
+          count -= chunk;
+        }
+        return outputs;
+      }
+
+      void reset()
+      {
+        m_state.fill(Sample{});
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      std::array<Sample, Taps> m_coefficients{};
+      std::array<Sample, Taps - 1 + Block> m_state{};
+  };
+
+} // namespace dsp
+
+#endif /* LIB_DSP_FIR_HPP_ */
@@ -0,0 +1,258 @@
+/*
+ * Fixed.hpp
+ *
+ *  Saturating fixed point numbers with the Q format in the type.
+ */
+
+#ifndef LIB_DSP_FIXED_HPP_
+#define LIB_DSP_FIXED_HPP_
+
+#include "Simd.hpp"
+
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+
+namespace dsp {
+
+  /**
+   *  Signed fixed point number of Fraction fractional bits stored in a
+   *  16 or 32 bit integer, Q(bits - 1 - Fraction).Fraction.
+   *
+   *  Arithmetic saturates instead of wrapping: additions map to SSAT and
+   *  QADD on the M4, products round to nearest. Conversions from floating
+   *  point are constexpr, so constants cost nothing at run time and code
+   *  using only Fixed never touches the FPU, no lazy stacking of FPU
+   *  registers in an ISR and no soft float on cores without one.
+   *
+   *      constexpr Q15 gain{0.25};
+   *      Q15 y = gain * x + offset;
+   *
+   *  Fixed is a plain value type with the usual operators, so it serves
+   *  as the underlying type of a fluent::NamedType. The Q format then
+   *  becomes part of the unit:
+   *
+   *      // +-8 V at 1/4096 V resolution
+   *      using Volts = fluent::NamedType<Fixed<int16_t, 12>, struct VoltsTag,
+   *          fluent::Addable, fluent::Subtractable, fluent::Comparable>;
+   *      // +-16 A at 1/2048 A
+   *      using Amps = fluent::NamedType<Fixed<int16_t, 11>, struct AmpsTag,
+   *          fluent::Addable, fluent::Comparable>;
+   *
+   *      constexpr Volts limit{Fixed<int16_t, 12>{3.3}};
+   *      Fixed<int32_t, 20> watts = multiply<Fixed<int32_t, 20>>(volts.get(), amps.get());
+   */
+  template<typename Storage, int Fraction>
+  class Fixed {
+
+      static_assert(std::is_same_v<Storage, int16_t> || std::is_same_v<Storage, int32_t>,
+          "Fixed is stored in int16_t or int32_t");
+      static_assert(Fraction >= 0 && Fraction < static_cast<int>(8 * sizeof(Storage)),
+          "Fixed needs a sign bit besides the fraction");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using Raw = Storage;
+
+      static constexpr int bits = static_cast<int>(8 * sizeof(Storage));
+      static constexpr int fraction = Fraction;
+      static constexpr int integer = bits - 1 - Fraction;
+
+      constexpr Fixed() = default;
+
+      /**
+       *  Nearest representable value, saturated to the format's range.
+       */
+      template<std::floating_point Real>
+      explicit constexpr Fixed(Real value)
+          :m_raw(fromReal(value))
+      {
+      }
+
+      /**
+       *  The same value in another format, rounded and saturated.
+       */
+      template<typename OtherStorage, int OtherFraction>
+      explicit constexpr Fixed(Fixed<OtherStorage, OtherFraction> other)
+          :m_raw(saturate(rescale(other.raw(), OtherFraction, Fraction)))
+      {
+      }
+
+      static constexpr Fixed fromRaw(Storage raw)
+      {
+        Fixed value;
+        value.m_raw = raw;
+        return value;
+      }
+
+      static constexpr Fixed max()
+      {
+        return fromRaw(MAX);
+      }
+
+      static constexpr Fixed min()
+      {
+        return fromRaw(MIN);
+      }
+
+      static constexpr Fixed epsilon()
+      {
+        return fromRaw(1);
+      }
+
+      [[nodiscard]] constexpr Storage raw() const
+      {
+        return m_raw;
+      }
+
+      template<std::floating_point Real>
+      explicit constexpr operator Real() const
+      {
+        return static_cast<Real>(m_raw) / static_cast<Real>(int64_t{1} << Fraction);
+      }
+
+      constexpr Fixed& operator+=(Fixed other)
+      {
+        m_raw = add(m_raw, other.m_raw);
+        return *this;
+      }
+
+      constexpr Fixed& operator-=(Fixed other)
+      {
+        m_raw = subtract(m_raw, other.m_raw);
+        return *this;
+      }
+
+      constexpr Fixed& operator*=(Fixed other)
+      {
+        m_raw = saturate(rescale(static_cast<int64_t>(m_raw) * other.m_raw, 2 * Fraction, Fraction));
+        return *this;
+      }
+
+      friend constexpr Fixed operator+(Fixed a, Fixed b)
+      {
+        return a += b;
+      }
+
+      friend constexpr Fixed operator-(Fixed a, Fixed b)
+      {
+        return a -= b;
+      }
+
+      friend constexpr Fixed operator*(Fixed a, Fixed b)
+      {
+        return a *= b;
+      }
+
+      /**
+       *  Negating the most negative value gives the largest positive one.
+       */
+      constexpr Fixed operator-() const
+      {
+        return fromRaw(subtract(0, m_raw));
+      }
+
+      constexpr Fixed operator+() const
+      {
+        return *this;
+      }
+
+      friend constexpr bool operator==(Fixed a, Fixed b) = default;
+      friend constexpr std::strong_ordering operator<=>(Fixed a, Fixed b) = default;
+
+      /**
+       *  Round a value with from fractional bits to one with to fractional
+       *  bits, to nearest with ties away from zero when narrowing.
+       */
+      static constexpr int64_t rescale(int64_t value, int from, int to)
+      {
+        if (from > to) {
+          const int shift = from - to;
+          const int64_t half = int64_t{1} << (shift - 1);
+          return value >= 0 ? (value + half) >> shift : -((-value + half) >> shift);
+        }
+        if (from < to) {
+          // Anything that would lose bits is out of range anyway.
+          const int shift = to - from;
+          const int64_t limit = INT64_MAX >> shift;
+          return value > limit ? limit : value < -limit ? -limit : value * (int64_t{1} << shift);
+        }
+        return value;
+      }
+
+      static constexpr Storage saturate(int64_t value)
+      {
+        return value > MAX ? MAX : value < MIN ? MIN : static_cast<Storage>(value);
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      static constexpr Storage MAX = std::is_same_v<Storage, int16_t> ? INT16_MAX : INT32_MAX;
+      static constexpr Storage MIN = std::is_same_v<Storage, int16_t> ? INT16_MIN : INT32_MIN;
+
+      template<std::floating_point Real>
+      static constexpr Storage fromReal(Real value)
+      {
+        const double scaled = static_cast<double>(value) * static_cast<double>(int64_t{1} << Fraction);
+        if (scaled >= static_cast<double>(MAX)) {
+          return MAX;
+        }
+        if (scaled <= static_cast<double>(MIN)) {
+          return MIN;
+        }
+        return static_cast<Storage>(static_cast<int64_t>(scaled >= 0.0 ? scaled + 0.5 : scaled - 0.5));
+      }
+
+      static constexpr Storage add(Storage a, Storage b)
+      {
+        if (!std::is_constant_evaluated()) {
+          if constexpr (std::is_same_v<Storage, int16_t>) {
+            return static_cast<Storage>(simd::ssat<16>(a + b));
+          } else {
+            return simd::qadd(a, b);
+          }
+        }
+        return saturate(static_cast<int64_t>(a) + b);
+      }
+
+      static constexpr Storage subtract(Storage a, Storage b)
+      {
+        if (!std::is_constant_evaluated()) {
+          if constexpr (std::is_same_v<Storage, int16_t>) {
+            return static_cast<Storage>(simd::ssat<16>(a - b));
+          } else {
+            return simd::qsub(a, b);
+          }
+        }
+        return saturate(static_cast<int64_t>(a) - b);
+      }
+
+      Storage m_raw{0};
+  };
+
+  /**
+   *  Product of two values of any formats, rounded and saturated to
+   *  Result's format.
+   */
+  template<typename Result, typename SA, int FA, typename SB, int FB>
+  constexpr Result multiply(Fixed<SA, FA> a, Fixed<SB, FB> b)
+  {
+    const int64_t product = static_cast<int64_t>(a.raw()) * b.raw();
+    return Result::fromRaw(Result::saturate(Result::rescale(product, FA + FB, Result::fraction)));
+  }
+
+  using Q15 = Fixed<int16_t, 15>;
+  using Q31 = Fixed<int32_t, 31>;
+
+} // namespace dsp
+
+#endif /* LIB_DSP_FIXED_HPP_ */
@@ -0,0 +1,80 @@
+/*
+ * Kernels.hpp
+ *
+ *  Block processing kernels behind Fir, FirDecimator, BiquadCascade and
+ *  RealFft. Prefer those classes, they own the state and table layouts
+ *  these functions expect.
+ */
+
+#ifndef LIB_DSP_KERNELS_HPP_
+#define LIB_DSP_KERNELS_HPP_
+
+#include "Simd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dsp {
+
+  /**
+   *  FIR filter over count samples.
+   *
+   *  @param coefficients taps coefficients, time reversed.
+   *  @param state taps - 1 samples of history followed by room for count
+   *         samples. The history is updated on return.
+   *
+   *  Q15 accumulates exactly in 64 bits and saturates the result. Q31
+   *  accumulates 2.62 products in 64 bits, inputs must leave
+   *  log2(taps) - 1 bits of headroom.
+   */
+  void fir(const float* coefficients, size_t taps, float* state, const float* input, float* output, size_t count);
+  void fir(const q15_t* coefficients, size_t taps, q15_t* state, const q15_t* input, q15_t* output, size_t count);
+  void fir(const q31_t* coefficients, size_t taps, q31_t* state, const q31_t* input, q31_t* output, size_t count);
+
+  /**
+   *  FIR filter computing only every factor-th output.
+   *
+   *  @param count Input samples, a multiple of factor. count / factor
+   *         outputs are written.
+   */
+  void firDecimate(const float* coefficients, size_t taps, size_t factor, float* state,
+      const float* input, float* output, size_t count);
+  void firDecimate(const q15_t* coefficients, size_t taps, size_t factor, q15_t* state,
+      const q15_t* input, q15_t* output, size_t count);
+  void firDecimate(const q31_t* coefficients, size_t taps, size_t factor, q31_t* state,
+      const q31_t* input, q31_t* output, size_t count);
+
+  /**
+   *  Cascade of second order sections, in place if input == output.
+   *
+   *  Float sections are direct form II transposed, coefficients
+   *  {b0, b1, b2, a1, a2} and two state values per section.
+   *
+   *  Fixed point sections are direct form I, coefficients
+   *  {b0, b1, b2, -a1, -a2} in Q(15 - postShift) or Q(31 - postShift)
+   *  and state {x1, x2, y1, y2} per section.
+   */
+  void biquad(const float* coefficients, size_t stages, float* state,
+      const float* input, float* output, size_t count);
+  void biquad(const q15_t* coefficients, size_t stages, uint8_t postShift, q15_t* state,
+      const q15_t* input, q15_t* output, size_t count);
+  void biquad(const q31_t* coefficients, size_t stages, uint8_t postShift, q31_t* state,
+      const q31_t* input, q31_t* output, size_t count);
+
+  /**
+   *  Forward FFT of n real samples, n a power of two of at least 4.
+   *
+   *  @param twiddles n / 2 complex exp(-2 pi i k / n), interleaved.
+   *  @param spectrum n + 2 values: bins 0 to n / 2, interleaved real and
+   *         imaginary parts. Also the work area.
+   *
+   *  Float bins are unscaled. Fixed point bins are scaled by 1 / n,
+   *  which keeps every stage free of overflow.
+   */
+  void rfft(const float* input, float* spectrum, size_t n, const float* twiddles);
+  void rfft(const q15_t* input, q15_t* spectrum, size_t n, const q15_t* twiddles);
+  void rfft(const q31_t* input, q31_t* spectrum, size_t n, const q31_t* twiddles);
+
+} // namespace dsp
+
+#endif /* LIB_DSP_KERNELS_HPP_ */
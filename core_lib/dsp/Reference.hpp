@@ -0,0 +1,213 @@
+/*
+ * Reference.hpp
+ *
+ *  Plain, portable implementations the optimised kernels are checked
+ *  against: no packing, no unrolling, one sample at a time.
+ */
+
+#ifndef LIB_DSP_REFERENCE_HPP_
+#define LIB_DSP_REFERENCE_HPP_
+
+#include "Simd.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace dsp::reference {
+
+  namespace detail {
+
+    template<typename Sample>
+    constexpr int FRACTION = sizeof(Sample) == sizeof(q15_t) ? 15 : 31;
+
+    template<typename Sample>
+    inline Sample saturate(int64_t value)
+    {
+      constexpr int64_t max = (int64_t{1} << FRACTION<Sample>) - 1;
+      return static_cast<Sample>(value > max ? max : value < -max - 1 ? -max - 1 : value);
+    }
+
+  } // namespace detail
+
+  /**
+   *  y[n] = sum h[k] x[n - k] from zero history. Float accumulates in
+   *  double, fixed point in 64 bits like the kernels.
+   */
+  template<typename Sample>
+  void fir(const Sample* h, size_t taps, const Sample* x, Sample* y, size_t count)
+  {
+    for (size_t n = 0; n < count; ++n) {
+      if constexpr (std::is_floating_point_v<Sample>) {
+        double sum = 0.0;
+        for (size_t k = 0; k < taps && k <= n; ++k) {
+          sum += static_cast<double>(h[k]) * static_cast<double>(x[n - k]);
+        }
+        y[n] = static_cast<Sample>(sum);
+      } else {
+        int64_t sum = 0;
+        for (size_t k = 0; k < taps && k <= n; ++k) {
+          sum += static_cast<int64_t>(h[k]) * x[n - k];
+        }
+        y[n] = detail::saturate<Sample>(sum >> detail::FRACTION<Sample>);
+      }
+    }
+  }
+
+  /**
+   *  Every factor-th output of fir(), starting with output factor - 1.
+   */
+  template<typename Sample>
+  void firDecimate(const Sample* h, size_t taps, size_t factor, const Sample* x, Sample* y, size_t count)
+  {
+    for (size_t m = 0; m < count / factor; ++m) {
+      const size_t n = m * factor + factor - 1;
+      if constexpr (std::is_floating_point_v<Sample>) {
+        double sum = 0.0;
+        for (size_t k = 0; k < taps && k <= n; ++k) {
+          sum += static_cast<double>(h[k]) * static_cast<double>(x[n - k]);
+        }
+        y[m] = static_cast<Sample>(sum);
+      } else {
+        int64_t sum = 0;
+        for (size_t k = 0; k < taps && k <= n; ++k) {
+          sum += static_cast<int64_t>(h[k]) * x[n - k];
+        }
+        y[m] = detail::saturate<Sample>(sum >> detail::FRACTION<Sample>);
+      }
+    }
+  }
+
+  /**
+   *  Direct form I cascade of sections {b0, b1, b2, a1, a2}, from zero
+   *  state. Float runs in double.
+   */
+  template<typename Sample>
+  void biquad(const Sample* sections, size_t stages, uint8_t postShift, const Sample* x, Sample* y, size_t count)
+  {
+    for (size_t n = 0; n < count; ++n) {
+      y[n] = x[n];
+    }
+    for (size_t stage = 0; stage < stages; ++stage) {
+      const Sample* c = sections + 5 * stage;
+      if constexpr (std::is_floating_point_v<Sample>) {
+        double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+        for (size_t n = 0; n < count; ++n) {
+          const double in = y[n];
+          const double out = static_cast<double>(c[0]) * in + static_cast<double>(c[1]) * x1
+              + static_cast<double>(c[2]) * x2 - static_cast<double>(c[3]) * y1 - static_cast<double>(c[4]) * y2;
+          x2 = x1;
+          x1 = in;
+          y2 = y1;
+          y1 = out;
+          y[n] = static_cast<Sample>(out);
+        }
+      } else {
+        int64_t x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+        for (size_t n = 0; n < count; ++n) {
+          const int64_t in = y[n];
+          const int64_t sum = c[0] * in + c[1] * x1 + c[2] * x2 - c[3] * y1 - c[4] * y2;
+          const Sample out = detail::saturate<Sample>(sum >> (detail::FRACTION<Sample> - postShift));
+          x2 = x1;
+          x1 = in;
+          y2 = y1;
+          y1 = out;
+          y[n] = out;
+        }
+      }
+    }
+  }
+
+  namespace detail {
+
+    template<typename Sample>
+    struct Complex {
+      int64_t re;
+      int64_t im;
+    };
+
+    template<typename Sample>
+    inline Complex<Sample> multiply(Complex<Sample> v, Complex<Sample> w)
+    {
+      // Truncated to the sample width like the packed kernel.
+      return {static_cast<Sample>((v.re * w.re - v.im * w.im) >> FRACTION<Sample>),
+              static_cast<Sample>((v.re * w.im + v.im * w.re) >> FRACTION<Sample>)};
+    }
+
+    template<typename Sample>
+    void fft(const Sample* x, size_t stride, Complex<Sample>* out, size_t m, size_t n, const Sample* twiddles)
+    {
+      if (m == 1) {
+        out[0] = {x[0] >> 1, x[1] >> 1};
+        return;
+      }
+      fft(x, 2 * stride, out, m / 2, n, twiddles);
+      fft(x + 2 * stride, 2 * stride, out + m / 2, m / 2, n, twiddles);
+      for (size_t j = 0; j < m / 2; ++j) {
+        const size_t k = j * (n / (2 * m)) * 2;
+        const Complex<Sample> t = multiply<Sample>(out[j + m / 2], {twiddles[2 * k], twiddles[2 * k + 1]});
+        const Complex<Sample> a = out[j];
+        out[j] = {(a.re + t.re) >> 1, (a.im + t.im) >> 1};
+        out[j + m / 2] = {(a.re - t.re) >> 1, (a.im - t.im) >> 1};
+      }
+    }
+
+  } // namespace detail
+
+  /**
+   *  Fixed point real FFT by recursion, bins scaled by 1 / n as from
+   *  rfft(). scratch holds n / 2 + 1 values.
+   */
+  template<typename Sample>
+  void rfft(const Sample* x, Sample* spectrum, size_t n, const Sample* twiddles, detail::Complex<Sample>* scratch)
+  {
+    using detail::saturate;
+    using Value = detail::Complex<Sample>;
+
+    const size_t m = n / 2;
+    detail::fft(x, 1, scratch, m, n, twiddles);
+
+    const Value z0 = scratch[0];
+    scratch[m] = {saturate<Sample>(z0.re - z0.im), 0};
+    scratch[0] = {saturate<Sample>(z0.re + z0.im), 0};
+
+    for (size_t k = 1; k <= m / 2; ++k) {
+      const Value zk = scratch[k];
+      const Value zc = scratch[m - k];
+      const Value e{(zk.re + zc.re) >> 1, (zk.im - zc.im) >> 1};
+      const Value o = detail::multiply<Sample>({(zk.im + zc.im) >> 1, (zc.re - zk.re) >> 1},
+          {twiddles[2 * k], twiddles[2 * k + 1]});
+      scratch[m - k] = {saturate<Sample>(e.re - o.re), saturate<Sample>(o.im - e.im)};
+      scratch[k] = {saturate<Sample>(e.re + o.re), saturate<Sample>(e.im + o.im)};
+    }
+
+    for (size_t k = 0; k <= m; ++k) {
+      spectrum[2 * k] = static_cast<Sample>(scratch[k].re);
+      spectrum[2 * k + 1] = static_cast<Sample>(scratch[k].im);
+    }
+  }
+
+  /**
+   *  Direct DFT in double, bins 0 to n / 2 interleaved. O(n^2), for
+   *  checking accuracy only.
+   */
+  inline void dft(const double* x, double* spectrum, size_t n)
+  {
+    constexpr double TWO_PI = 6.283185307179586476925;
+    for (size_t k = 0; k <= n / 2; ++k) {
+      double re = 0.0;
+      double im = 0.0;
+      for (size_t i = 0; i < n; ++i) {
+        const double angle = TWO_PI * static_cast<double>((k * i) % n) / static_cast<double>(n);
+        re += x[i] * std::cos(angle);
+        im -= x[i] * std::sin(angle);
+      }
+      spectrum[2 * k] = re;
+      spectrum[2 * k + 1] = im;
+    }
+  }
+
+} // namespace dsp::reference
+
+#endif /* LIB_DSP_REFERENCE_HPP_ */
@@ -0,0 +1,218 @@
+/*
+ * Simd.hpp
+ *
+ *  Cortex-M4 DSP extension intrinsics, with portable equivalents for
+ *  cores and hosts without them.
+ */
+
+#ifndef LIB_DSP_SIMD_HPP_
+#define LIB_DSP_SIMD_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "cmsis_compiler.h"
+#define DSP_USE_INTRINSICS 1
+#else
+#define DSP_USE_INTRINSICS 0
+#endif
+
+namespace dsp {
+
+  /**
+   *  Fixed point samples: 1.15 and 1.31, full scale [-1, 1).
+   */
+  using q15_t = int16_t;
+  using q31_t = int32_t;
+
+  /**
+   *  Packed pairs of q15_t, the low halfword first in memory. Complex
+   *  values are packed with the real part low.
+   */
+  namespace simd {
+
+    inline int32_t read2(const q15_t* p)
+    {
+      // One LDR on the M4, which allows unaligned word loads.
+      int32_t value;
+      std::memcpy(&value, p, sizeof(value));
+      return value;
+    }
+
+    inline void write2(q15_t* p, int32_t value)
+    {
+      std::memcpy(p, &value, sizeof(value));
+    }
+
+    inline int32_t pack(int32_t lo, int32_t hi)
+    {
+      return static_cast<int32_t>((static_cast<uint32_t>(hi) << 16) | (static_cast<uint32_t>(lo) & 0xFFFFU));
+    }
+
+    inline int32_t low(int32_t value)
+    {
+      return static_cast<q15_t>(value);
+    }
+
+    inline int32_t high(int32_t value)
+    {
+      return value >> 16;
+    }
+
+    /**
+     *  Saturate to a Bits wide signed value.
+     */
+    template<unsigned Bits>
+    inline int32_t ssat(int32_t value)
+    {
+      static_assert(Bits >= 1 && Bits <= 32, "ssat width is 1 to 32 bits");
+#if DSP_USE_INTRINSICS
+      return __SSAT(value, Bits);
+#else
+      if constexpr (Bits == 32) {
+        return value;
+      } else {
+        constexpr int32_t max = static_cast<int32_t>((1U << (Bits - 1)) - 1);
+        return value > max ? max : value < -max - 1 ? -max - 1 : value;
+      }
+#endif
+    }
+
+    /**
+     *  Saturate a 64 bit value to q31_t.
+     */
+    inline int32_t saturate31(int64_t value)
+    {
+      return value > INT32_MAX ? INT32_MAX : value < INT32_MIN ? INT32_MIN : static_cast<int32_t>(value);
+    }
+
+#if DSP_USE_INTRINSICS
+
+    inline uint32_t u(int32_t value)
+    {
+      return static_cast<uint32_t>(value);
+    }
+
+    inline int32_t s(uint32_t value)
+    {
+      return static_cast<int32_t>(value);
+    }
+
+    /**
+     *  acc + x.low * y.low + x.high * y.high
+     */
+    inline int64_t smlald(int32_t x, int32_t y, int64_t acc)
+    {
+      return static_cast<int64_t>(__SMLALD(u(x), u(y), static_cast<uint64_t>(acc)));
+    }
+
+    /**
+     *  x.low * y.low - x.high * y.high, the real part of x * y.
+     */
+    inline int32_t smusd(int32_t x, int32_t y)
+    {
+      return s(__SMUSD(u(x), u(y)));
+    }
+
+    /**
+     *  x.low * y.high + x.high * y.low, the imaginary part of x * y.
+     */
+    inline int32_t smuadx(int32_t x, int32_t y)
+    {
+      return s(__SMUADX(u(x), u(y)));
+    }
+
+    /**
+     *  Halving add and subtract of both halves, (x + y) >> 1.
+     */
+    inline int32_t shadd16(int32_t x, int32_t y)
+    {
+      return s(__SHADD16(u(x), u(y)));
+    }
+
+    inline int32_t shsub16(int32_t x, int32_t y)
+    {
+      return s(__SHSUB16(u(x), u(y)));
+    }
+
+    /**
+     *  Saturating add and subtract of both halves.
+     */
+    inline int32_t qadd16(int32_t x, int32_t y)
+    {
+      return s(__QADD16(u(x), u(y)));
+    }
+
+    inline int32_t qsub16(int32_t x, int32_t y)
+    {
+      return s(__QSUB16(u(x), u(y)));
+    }
+
+    /**
+     *  Saturating 32 bit add and subtract.
+     */
+    inline int32_t qadd(int32_t x, int32_t y)
+    {
+      return __QADD(x, y);
+    }
+
+    inline int32_t qsub(int32_t x, int32_t y)
+    {
+      return __QSUB(x, y);
+    }
+
+#else
+
+    inline int64_t smlald(int32_t x, int32_t y, int64_t acc)
+    {
+      return acc + static_cast<int64_t>(low(x) * low(y)) + static_cast<int64_t>(high(x) * high(y));
+    }
+
+    inline int32_t smusd(int32_t x, int32_t y)
+    {
+      return low(x) * low(y) - high(x) * high(y);
+    }
+
+    inline int32_t smuadx(int32_t x, int32_t y)
+    {
+      return low(x) * high(y) + high(x) * low(y);
+    }
+
+    inline int32_t shadd16(int32_t x, int32_t y)
+    {
+      return pack((low(x) + low(y)) >> 1, (high(x) + high(y)) >> 1);
+    }
+
+    inline int32_t shsub16(int32_t x, int32_t y)
+    {
+      return pack((low(x) - low(y)) >> 1, (high(x) - high(y)) >> 1);
+    }
+
+    inline int32_t qadd16(int32_t x, int32_t y)
+    {
+      return pack(ssat<16>(low(x) + low(y)), ssat<16>(high(x) + high(y)));
+    }
+
+    inline int32_t qsub16(int32_t x, int32_t y)
+    {
+      return pack(ssat<16>(low(x) - low(y)), ssat<16>(high(x) - high(y)));
+    }
+
+    inline int32_t qadd(int32_t x, int32_t y)
+    {
+      return saturate31(static_cast<int64_t>(x) + y);
+    }
+
+    inline int32_t qsub(int32_t x, int32_t y)
+    {
+      return saturate31(static_cast<int64_t>(x) - y);
+    }
+
+#endif
+
+  } // namespace simd
+
+} // namespace dsp
+
+#endif /* LIB_DSP_SIMD_HPP_ */
@@ -0,0 +1,410 @@
+/*
+ * ActiveObject.hpp
+ *
+ *  Event driven state machines sharing event queues and threads.
+ */
+
+#ifndef LIB_FREERTOS_CPP_ACTIVEOBJECT_HPP_
+#define LIB_FREERTOS_CPP_ACTIVEOBJECT_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Queue.hpp"
+#include "SharedEvent.hpp"
+#include "Task.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace freertos {
+
+  template<typename Message>
+  class ActiveThread;
+
+  /**
+   *  Something that receives events on an ActiveThread.
+   *
+   *  Events are posted as SharedEvent references: posting copies a
+   *  pointer into the thread's queue and takes a reference, dispatching
+   *  drops it. The event itself is never copied.
+   *
+   *  Application objects derive from Active rather than from this.
+   */
+  template<typename Message>
+  class ActiveObject {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using Event = SharedEvent<Message>;
+
+      ActiveObject(const ActiveObject&) = delete;
+      ActiveObject& operator=(const ActiveObject&) = delete;
+
+      /**
+       *  Queue an event for this object.
+       *
+       *  @param Timeout How long to wait for room if the queue is full.
+       *  @return true if queued, false if the queue stayed full.
+       */
+      bool post(const Event& event, TickType_t Timeout = 0);
+
+      /**
+       *  Queue an event for this object from ISR context.
+       *
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       *  @return true if queued, false if the queue is full.
+       */
+      bool postFromISR(const Event& event, BaseType_t* pxHigherPriorityTaskWoken);
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Protected API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    protected:
+      explicit ActiveObject(ActiveThread<Message>& thread)
+          :m_thread(thread)
+      {
+        thread.attach(*this);
+      }
+
+      virtual ~ActiveObject() = default;
+
+      /**
+       *  Called once on the thread, before the first event is dispatched.
+       */
+      virtual void start() = 0;
+
+      /**
+       *  Called on the thread for every event posted to this object.
+       */
+      virtual void dispatch(const Message& message) = 0;
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      friend class ActiveThread<Message>;
+
+      ActiveThread<Message>& m_thread;
+      ActiveObject* m_next{nullptr};
+  };
+
+  /**
+   *  An ActiveObject running a state machine.
+   *
+   *  Machine only needs start() and receive(const Message&), which is the
+   *  interface of ETL's etl::fsm and etl::hfsm with Message being
+   *  etl::imessage:
+   *
+   *      struct Press : etl::message<PRESS> {};
+   *
+   *      class Idle : public etl::fsm_state<Button, Idle, IDLE, Press> {
+   *        public:
+   *          etl::fsm_state_id_t on_event(const Press&) { return PRESSED; }
+   *          etl::fsm_state_id_t on_event_unknown(const etl::imessage&) { return STATE_ID; }
+   *      };
+   *
+   *      class Button : public etl::hfsm {
+   *        public:
+   *          Button() :etl::hfsm(BUTTON) { set_states(states, 2); }
+   *        ...
+   *      };
+   *
+   *      EventPool<etl::imessage, 16, 8> events;
+   *      StaticActiveThread<etl::imessage, 8, 256> ui{"ui", 3};
+   *      Active<Button, etl::imessage> button{ui};
+   *
+   *      ui.start(nullptr);
+   *      button.postFromISR(events.makeFromISR<Press>(), &woken);
+   *
+   *  The machine's states see the event by const reference, valid until
+   *  receive() returns. To keep it longer, keep the SharedEvent.
+   */
+  template<typename Machine, typename Message>
+  class Active : public ActiveObject<Message> {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      /**
+       *  @param thread Thread the machine runs on, shared with every other
+       *         object of the same priority.
+       *  @param args Forwarded to the Machine constructor.
+       */
+      template<typename... Args>
+      explicit Active(ActiveThread<Message>& thread, Args&&... args)
+          :ActiveObject<Message>(thread), m_machine(std::forward<Args>(args)...)
+      {
+      }
+
+      Machine& machine()
+      {
+        return m_machine;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Protected API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    protected:
+      void start() override
+      {
+        m_machine.start();
+      }
+
+      void dispatch(const Message& message) override
+      {
+        m_machine.receive(message);
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      Machine m_machine;
+  };
+
+  /**
+   *  A task and one event queue serving every ActiveObject attached to
+   *  it, in posting order. The task blocks on the queue while there is
+   *  nothing to dispatch.
+   *
+   *  Objects attach when constructed and are started, in construction
+   *  order, when the thread starts. Events posted before that wait in the
+   *  queue.
+   */
+  template<typename Message>
+  class ActiveThread : public Task {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using Event = SharedEvent<Message>;
+
+      /**
+       *  Queue an event for one of the attached objects.
+       */
+      bool post(ActiveObject<Message>& target, const Event& event, TickType_t Timeout = 0)
+      {
+        configASSERT(&target.m_thread == this && event);
+        Envelope envelope{&target, Event{event}.detach()};
+        if (!m_queue.enqueue(&envelope, Timeout)) {
+          envelope.block->release();
+          return false;
+        }
+        return true;
+      }
+
+      bool postFromISR(ActiveObject<Message>& target, const Event& event, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        configASSERT(&target.m_thread == this && event);
+        Envelope envelope{&target, Event{event}.detach()};
+        if (!m_queue.enqueueFromISR(&envelope, pxHigherPriorityTaskWoken)) {
+          envelope.block->release();
+          return false;
+        }
+        return true;
+      }
+
+      /**
+       *  Events waiting to be dispatched.
+       */
+      UBaseType_t pending()
+      {
+        return m_queue.numItems();
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Protected API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    protected:
+      struct Envelope {
+        ActiveObject<Message>* target;
+        EventBlock* block;
+      };
+
+      #if(configSUPPORT_STATIC_ALLOCATION == 1)
+      ActiveThread(const char* name, StackType_t* stack, uint16_t stackWords, uint8_t priority,
+          UBaseType_t depth, uint8_t* storage)
+          :Task(name, stack, stackWords, priority), m_queue(depth, sizeof(Envelope), storage)
+      {
+      }
+      #else
+      ActiveThread(const char* name, uint16_t stackWords, uint8_t priority, UBaseType_t depth)
+          :Task(name, stackWords, priority), m_queue(depth, sizeof(Envelope))
+      {
+      }
+      #endif
+
+      void run() override
+      {
+        for (ActiveObject<Message>* object = m_objects; object != nullptr; object = object->m_next) {
+          object->start();
+        }
+
+        loop {
+          Envelope envelope{};
+          (void) m_queue.dequeue(&envelope);
+
+          // Adopting drops the queue's reference once dispatched.
+          const Event event = Event::adopt(envelope.block);
+          envelope.target->dispatch(*event);
+        }
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      friend class ActiveObject<Message>;
+
+      void attach(ActiveObject<Message>& object)
+      {
+        *m_tail = &object;
+        m_tail = &object.m_next;
+      }
+
+      Queue m_queue;
+      ActiveObject<Message>* m_objects{nullptr};
+      ActiveObject<Message>** m_tail{&m_objects};
+  };
+
+  /**
+   *  ActiveThread with its stack and queue storage.
+   *
+   *  @tparam Depth Events the queue holds.
+   *  @tparam StackWords Stack of the thread, sized for the deepest
+   *          dispatch of any attached object.
+   */
+  template<typename Message, size_t Depth, uint16_t StackWords>
+  class StaticActiveThread : public ActiveThread<Message> {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      #if(configSUPPORT_STATIC_ALLOCATION == 1)
+      StaticActiveThread(const char* name, uint8_t priority)
+          :ActiveThread<Message>(name, m_stack.data(), StackWords, priority, Depth, m_storage.data())
+      {
+      }
+      #else
+      StaticActiveThread(const char* name, uint8_t priority)
+          :ActiveThread<Message>(name, StackWords, priority, Depth)
+      {
+      }
+      #endif
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      #if(configSUPPORT_STATIC_ALLOCATION == 1)
+      // Both are handed out before they are constructed, neither may be
+      // initialised here.
+      std::array<StackType_t, StackWords> m_stack;
+      std::array<uint8_t, Depth * sizeof(typename ActiveThread<Message>::Envelope)> m_storage;
+      #endif
+  };
+
+  /**
+   *  Objects subscribed to one kind of event. Publishing posts one
+   *  reference to every subscriber, the event is allocated once however
+   *  many receive it.
+   */
+  template<typename Message, size_t Capacity>
+  class Subscribers {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      void subscribe(ActiveObject<Message>& object)
+      {
+        if (m_count == Capacity) {
+          configASSERT(!"Subscribers full");
+          return;
+        }
+        m_objects[m_count++] = &object;
+      }
+
+      /**
+       *  @return Subscribers the event was queued for.
+       */
+      size_t publish(const SharedEvent<Message>& event, TickType_t Timeout = 0)
+      {
+        size_t delivered = 0;
+        for (size_t i = 0; i < m_count; ++i) {
+          if (m_objects[i]->post(event, Timeout)) {
+            ++delivered;
+          }
+        }
+        return delivered;
+      }
+
+      size_t publishFromISR(const SharedEvent<Message>& event, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        size_t delivered = 0;
+        for (size_t i = 0; i < m_count; ++i) {
+          if (m_objects[i]->postFromISR(event, pxHigherPriorityTaskWoken)) {
+            ++delivered;
+          }
+        }
+        return delivered;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      std::array<ActiveObject<Message>*, Capacity> m_objects{};
+      size_t m_count{0};
+  };
+
+  template<typename Message>
+  bool ActiveObject<Message>::post(const Event& event, TickType_t Timeout)
+  {
+    return m_thread.post(*this, event, Timeout);
+  }
+
+  template<typename Message>
+  bool ActiveObject<Message>::postFromISR(const Event& event, BaseType_t* pxHigherPriorityTaskWoken)
+  {
+    return m_thread.postFromISR(*this, event, pxHigherPriorityTaskWoken);
+  }
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_ACTIVEOBJECT_HPP_ */
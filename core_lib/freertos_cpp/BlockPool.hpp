@@ -0,0 +1,250 @@
+/*
+ * BlockPool.hpp
+ *
+ *  Fixed block memory pool with constant time allocate and free.
+ */
+
+#ifndef LIB_FREERTOS_CPP_BLOCKPOOL_HPP_
+#define LIB_FREERTOS_CPP_BLOCKPOOL_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Critical.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace freertos {
+
+  /**
+   *  Usage counters of a BlockPool.
+   */
+  struct BlockPoolStats {
+    /**
+     *  Blocks currently handed out.
+     */
+    size_t inUse;
+
+    /**
+     *  Largest inUse value seen since construction.
+     */
+    size_t highWaterMark;
+
+    /**
+     *  Number of allocations that failed because the pool was empty.
+     */
+    uint32_t exhaustions;
+  };
+
+  /**
+   *  Ownership of a pool block as a plain value, small enough to go
+   *  through a Queue or TypedQueue instead of the payload itself.
+   *
+   *  The receiver is responsible for handing the block back with
+   *  BlockPool::release().
+   */
+  struct PoolMessage {
+    void* block;
+    size_t length;
+  };
+
+  /**
+   *  Pool of Count blocks of BlockSize bytes.
+   *
+   *  Free blocks are kept on an intrusive singly linked list, so allocate
+   *  and free are a pointer swap inside a short critical section and take
+   *  the same time whatever the pool state. Unlike heap_4 there is no
+   *  search and no coalescing.
+   *
+   *  Every block is aligned for any fundamental type.
+   */
+  template<size_t BlockSize, size_t Count>
+  class BlockPool {
+
+      static_assert(Count > 0, "BlockPool needs at least one block");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      static constexpr size_t blockSize = BlockSize;
+      static constexpr size_t blockCount = Count;
+
+      BlockPool()
+      {
+        for (size_t i = 0; i < Count; ++i) {
+          auto* node = reinterpret_cast<Node*>(&m_storage[i * STRIDE]);
+          node->next = i + 1 < Count ? reinterpret_cast<Node*>(&m_storage[(i + 1) * STRIDE]) : nullptr;
+        }
+        m_free = reinterpret_cast<Node*>(m_storage.data());
+      }
+
+      BlockPool(const BlockPool&) = delete;
+      BlockPool& operator=(const BlockPool&) = delete;
+
+      /**
+       *  Take a block from the pool.
+       *
+       *  @return The block, or nullptr if the pool is exhausted.
+       */
+      void* allocate()
+      {
+        CriticalSection::enter();
+        void* block = pop();
+        CriticalSection::exit();
+        return block;
+      }
+
+      /**
+       *  Take a block from the pool in ISR context.
+       *
+       *  @return The block, or nullptr if the pool is exhausted.
+       */
+      void* allocateFromISR()
+      {
+        const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+        void* block = pop();
+        CriticalSection::exitFromISR(savedInterruptStatus);
+        return block;
+      }
+
+      /**
+       *  Give a block back to the pool.
+       *
+       *  @param block A block obtained from this pool, or nullptr.
+       */
+      void free(void* block)
+      {
+        if (block == nullptr) {
+          return;
+        }
+        configASSERT(owns(block));
+
+        CriticalSection::enter();
+        push(block);
+        CriticalSection::exit();
+      }
+
+      /**
+       *  Give a block back to the pool in ISR context.
+       *
+       *  @param block A block obtained from this pool, or nullptr.
+       */
+      void freeFromISR(void* block)
+      {
+        if (block == nullptr) {
+          return;
+        }
+        configASSERT(owns(block));
+
+        const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+        push(block);
+        CriticalSection::exitFromISR(savedInterruptStatus);
+      }
+
+      /**
+       *  Allocate a block wrapped in a PoolMessage.
+       *
+       *  @param length Number of payload bytes the producer intends to
+       *         write, must not exceed BlockSize.
+       *  @return The message, with block == nullptr if the pool is exhausted.
+       */
+      PoolMessage allocateMessage(size_t length)
+      {
+        configASSERT(length <= BlockSize);
+        return {allocate(), length};
+      }
+
+      PoolMessage allocateMessageFromISR(size_t length)
+      {
+        configASSERT(length <= BlockSize);
+        return {allocateFromISR(), length};
+      }
+
+      /**
+       *  Return the block carried by a PoolMessage.
+       */
+      inline void release(const PoolMessage& message)
+      {
+        free(message.block);
+      }
+
+      inline void releaseFromISR(const PoolMessage& message)
+      {
+        freeFromISR(message.block);
+      }
+
+      /**
+       *  Does this block belong to this pool?
+       */
+      bool owns(const void* block) const
+      {
+        const auto* byte = static_cast<const uint8_t*>(block);
+        if (byte < m_storage.data() || byte >= m_storage.data() + m_storage.size()) {
+          return false;
+        }
+        return static_cast<size_t>(byte - m_storage.data()) % STRIDE == 0;
+      }
+
+      /**
+       *  Snapshot of the usage counters.
+       */
+      BlockPoolStats stats() const
+      {
+        const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+        BlockPoolStats snapshot{m_inUse, m_highWaterMark, m_exhaustions};
+        CriticalSection::exitFromISR(savedInterruptStatus);
+        return snapshot;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      struct Node {
+        Node* next;
+      };
+
+      static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+      static constexpr size_t STRIDE =
+          ((BlockSize < sizeof(Node) ? sizeof(Node) : BlockSize) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+      inline void* pop()
+      {
+        Node* node = m_free;
+        if (node == nullptr) {
+          ++m_exhaustions;
+          return nullptr;
+        }
+
+        m_free = node->next;
+        if (++m_inUse > m_highWaterMark) {
+          m_highWaterMark = m_inUse;
+        }
+        return node;
+      }
+
+      inline void push(void* block)
+      {
+        auto* node = static_cast<Node*>(block);
+        node->next = m_free;
+        m_free = node;
+        --m_inUse;
+      }
+
+      alignas(ALIGNMENT) std::array<uint8_t, STRIDE * Count> m_storage{};
+      Node* m_free{nullptr};
+      size_t m_inUse{0};
+      size_t m_highWaterMark{0};
+      uint32_t m_exhaustions{0};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_BLOCKPOOL_HPP_ */
@@ -0,0 +1,261 @@
+/*
+ * Channel.hpp
+ *
+ *  Zero copy message channel with pool owned payloads.
+ */
+
+#ifndef LIB_FREERTOS_CPP_CHANNEL_HPP_
+#define LIB_FREERTOS_CPP_CHANNEL_HPP_
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+#include "BlockPool.hpp"
+#include "TypedQueue.hpp"
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace freertos {
+
+  /**
+   *  Channel moving objects of type T between tasks without copying them.
+   *
+   *  Payloads live in a BlockPool owned by the channel. A producer
+   *  acquires a Message, fills it in place and sends it; only the pointer
+   *  travels through the underlying queue, so the cost per message does
+   *  not depend on sizeof(T). The receiving Message returns the block to
+   *  the pool when it goes out of scope.
+   *
+   *  @tparam T Payload type.
+   *  @tparam Depth How many messages can be queued.
+   *  @tparam PoolCount How many payloads exist in total, queued or held by
+   *          producers and consumers.
+   */
+  template<typename T, size_t Depth, size_t PoolCount = Depth + 2>
+  class Channel {
+
+      static_assert(PoolCount >= Depth, "Channel pool must be able to fill the queue");
+      static_assert(alignof(T) <= alignof(std::max_align_t), "BlockPool blocks are only max_align_t aligned");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      /**
+       *  Unique owner of one payload. Move only, an empty Message owns
+       *  nothing and converts to false.
+       */
+      class Message {
+        public:
+          Message() = default;
+
+          Message(Message&& other) noexcept
+              :m_channel(std::exchange(other.m_channel, nullptr)),
+               m_payload(std::exchange(other.m_payload, nullptr))
+          {
+          }
+
+          Message& operator=(Message&& other) noexcept
+          {
+            if (this != &other) {
+              reset();
+              m_channel = std::exchange(other.m_channel, nullptr);
+              m_payload = std::exchange(other.m_payload, nullptr);
+            }
+            return *this;
+          }
+
+          Message(const Message&) = delete;
+          Message& operator=(const Message&) = delete;
+
+          ~Message()
+          {
+            reset();
+          }
+
+          explicit operator bool() const
+          {
+            return m_payload != nullptr;
+          }
+
+          T& operator*() const
+          {
+            return *m_payload;
+          }
+
+          T* operator->() const
+          {
+            return m_payload;
+          }
+
+          T* get() const
+          {
+            return m_payload;
+          }
+
+          /**
+           *  Destroy the payload and return it to the pool now.
+           */
+          void reset()
+          {
+            if (m_payload != nullptr) {
+              m_payload->~T();
+              m_channel->m_pool.free(m_payload);
+              m_payload = nullptr;
+            }
+          }
+
+          /**
+           *  Destroy the payload and return it to the pool from ISR context.
+           *  A Message dropped in an ISR must be released this way.
+           */
+          void resetFromISR()
+          {
+            if (m_payload != nullptr) {
+              m_payload->~T();
+              m_channel->m_pool.freeFromISR(m_payload);
+              m_payload = nullptr;
+            }
+          }
+
+        private:
+          friend class Channel;
+
+          Message(Channel* channel, T* payload)
+              :m_channel(channel), m_payload(payload)
+          {
+          }
+
+          T* release()
+          {
+            return std::exchange(m_payload, nullptr);
+          }
+
+          Channel* m_channel{nullptr};
+          T* m_payload{nullptr};
+      };
+
+      Channel() = default;
+
+      Channel(const Channel&) = delete;
+      Channel& operator=(const Channel&) = delete;
+
+      /**
+       *  Take a payload from the pool and construct it in place. Without
+       *  arguments the payload is default initialised, so a trivial frame
+       *  is not cleared before the producer fills it.
+       *
+       *  @return The message, empty if the pool is exhausted.
+       */
+      template<typename... Args>
+      Message acquire(Args&& ... args)
+      {
+        void* block = m_pool.allocate();
+        if (block == nullptr) {
+          return {};
+        }
+        return {this, construct(block, std::forward<Args>(args)...)};
+      }
+
+      template<typename... Args>
+      Message acquireFromISR(Args&& ... args)
+      {
+        void* block = m_pool.allocateFromISR();
+        if (block == nullptr) {
+          return {};
+        }
+        return {this, construct(block, std::forward<Args>(args)...)};
+      }
+
+      /**
+       *  Send a message. On success ownership passes to the receiver and
+       *  message is left empty, on failure message still owns the payload.
+       *
+       *  @param message A non empty message acquired from this channel.
+       *  @param Timeout How long to wait if the queue is full.
+       *  @return true if the message was queued.
+       */
+      bool send(Message& message, TickType_t Timeout = portMAX_DELAY)
+      {
+        configASSERT(message.m_channel == this || !message);
+        if (!message || !m_queue.enqueue(message.get(), Timeout)) {
+          return false;
+        }
+        (void) message.release();
+        return true;
+      }
+
+      bool sendFromISR(Message& message, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        configASSERT(message.m_channel == this || !message);
+        if (!message || !m_queue.enqueueFromISR(message.get(), pxHigherPriorityTaskWoken)) {
+          return false;
+        }
+        (void) message.release();
+        return true;
+      }
+
+      /**
+       *  Receive the next message.
+       *
+       *  @param Timeout How long to wait if the queue is empty.
+       *  @return The message, empty on timeout.
+       */
+      Message receive(TickType_t Timeout = portMAX_DELAY)
+      {
+        T* payload = nullptr;
+        if (!m_queue.dequeue(payload, Timeout)) {
+          return {};
+        }
+        return {this, payload};
+      }
+
+      Message receiveFromISR(BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        T* payload = nullptr;
+        if (!m_queue.dequeueFromISR(payload, pxHigherPriorityTaskWoken)) {
+          return {};
+        }
+        return {this, payload};
+      }
+
+      [[nodiscard]] inline UBaseType_t numItems() const
+      {
+        return m_queue.numItems();
+      }
+
+      /**
+       *  Usage counters of the payload pool.
+       */
+      inline BlockPoolStats poolStats() const
+      {
+        return m_pool.stats();
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      template<typename... Args>
+      static inline T* construct(void* block, Args&& ... args)
+      {
+        if constexpr (sizeof...(Args) == 0) {
+          return new(block) T;
+        } else {
+          return new(block) T(std::forward<Args>(args)...);
+        }
+      }
+
+      BlockPool<sizeof(T), PoolCount> m_pool{};
+      TypedQueue<T*, Depth> m_queue{};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_CHANNEL_HPP_ */
@@ -0,0 +1,199 @@
+/*
+ * Coroutine.cpp
+ *
+ *  C++20 coroutines scheduled inside one task, frames taken from a
+ *  fixed pool.
+ */
+
+#include "Coroutine.hpp"
+
+namespace freertos {
+
+  namespace {
+
+    inline bool reached(TickType_t now, TickType_t deadline)
+    {
+      return static_cast<int32_t>(now - deadline) >= 0;
+    }
+
+  } // namespace
+
+  bool Executor::spawn(Job&& job)
+  {
+    if (!job) {
+      return false;
+    }
+
+    Job::Handle handle = std::exchange(job.m_handle, nullptr);
+    Job::promise_type& promise = handle.promise();
+    configASSERT(promise.executor == this);
+
+    promise.spawned = true;
+    promise.waiter.handle = handle;
+    ++m_jobs;
+    pushReady(promise.waiter);
+    return true;
+  }
+
+  void Executor::run()
+  {
+    m_task.store(xTaskGetCurrentTaskHandle(), std::memory_order_seq_cst);
+
+    while (m_jobs > 0) {
+      runReady();
+
+      // Jobs waiting for bits would starve while others keep yielding,
+      // collect what arrived without blocking.
+      collectBits();
+
+      TickType_t now = xTaskGetTickCount();
+      expireDelays(now);
+      pollWaiters(now);
+
+      if (m_readyHead == nullptr && m_jobs > 0) {
+        // A notification may be left over from bits collected above, the
+        // wait then returns early and the loop goes round once more.
+        (void) xTaskNotifyWait(0, UINT32_MAX, nullptr, blockTime(now));
+        collectBits();
+        now = xTaskGetTickCount();
+        expireDelays(now);
+        pollWaiters(now);
+      }
+    }
+
+    m_task.store(nullptr, std::memory_order_seq_cst);
+  }
+
+  void Executor::collectBits()
+  {
+    m_bits |= m_pendingBits.exchange(0, std::memory_order_seq_cst);
+  }
+
+  void* Executor::allocateFrame(size_t size)
+  {
+    void* block = allocate(size + FRAME_HEADER);
+    if (block == nullptr) {
+      return nullptr;
+    }
+    *static_cast<Executor**>(block) = this;
+    return static_cast<uint8_t*>(block) + FRAME_HEADER;
+  }
+
+  void Executor::freeFrame(void* frame)
+  {
+    void* block = static_cast<uint8_t*>(frame) - FRAME_HEADER;
+    (*static_cast<Executor**>(block))->release(block);
+  }
+
+  void Executor::finished()
+  {
+    --m_jobs;
+  }
+
+  void Executor::pushReady(Waiter& waiter)
+  {
+    waiter.next = nullptr;
+    if (m_readyTail != nullptr) {
+      m_readyTail->next = &waiter;
+    } else {
+      m_readyHead = &waiter;
+    }
+    m_readyTail = &waiter;
+  }
+
+  void Executor::insertDelay(Waiter& waiter, TickType_t ticks)
+  {
+    waiter.deadline = xTaskGetTickCount() + ticks;
+
+    Waiter** link = &m_delays;
+    while (*link != nullptr && static_cast<int32_t>((*link)->deadline - waiter.deadline) <= 0) {
+      link = &(*link)->next;
+    }
+    waiter.next = *link;
+    *link = &waiter;
+  }
+
+  void Executor::pushPoller(Waiter& waiter)
+  {
+    waiter.next = nullptr;
+    if (m_pollersTail != nullptr) {
+      m_pollersTail->next = &waiter;
+    } else {
+      m_pollersHead = &waiter;
+    }
+    m_pollersTail = &waiter;
+  }
+
+  void Executor::runReady()
+  {
+    // Only the jobs ready now, those they make ready run next round.
+    Waiter* waiter = std::exchange(m_readyHead, nullptr);
+    m_readyTail = nullptr;
+
+    while (waiter != nullptr) {
+      // The waiter is gone once its job runs.
+      Waiter* next = waiter->next;
+      waiter->handle.resume();
+      waiter = next;
+    }
+  }
+
+  void Executor::expireDelays(TickType_t now)
+  {
+    while (m_delays != nullptr && reached(now, m_delays->deadline)) {
+      Waiter* waiter = m_delays;
+      m_delays = waiter->next;
+      pushReady(*waiter);
+    }
+  }
+
+  void Executor::pollWaiters(TickType_t now)
+  {
+    Waiter* previous = nullptr;
+    Waiter* waiter = m_pollersHead;
+
+    while (waiter != nullptr) {
+      Waiter* next = waiter->next;
+
+      if (waiter->poll(*this, *waiter) || (waiter->timed && reached(now, waiter->deadline))) {
+        if (previous != nullptr) {
+          previous->next = next;
+        } else {
+          m_pollersHead = next;
+        }
+        if (m_pollersTail == waiter) {
+          m_pollersTail = previous;
+        }
+        pushReady(*waiter);
+      } else {
+        previous = waiter;
+      }
+
+      waiter = next;
+    }
+  }
+
+  TickType_t Executor::blockTime(TickType_t now) const
+  {
+    // Called right after expireDelays() and pollWaiters() with the same
+    // now, no deadline left is in the past. Jobs on kernel objects wait
+    // for wake(), they add no timeout of their own.
+    TickType_t timeout = portMAX_DELAY;
+
+    if (m_delays != nullptr) {
+      const TickType_t remaining = m_delays->deadline - now;
+      if (remaining < timeout) {
+        timeout = remaining;
+      }
+    }
+
+    for (const Waiter* waiter = m_pollersHead; waiter != nullptr; waiter = waiter->next) {
+      if (waiter->timed && waiter->deadline - now < timeout) {
+        timeout = waiter->deadline - now;
+      }
+    }
+
+    return timeout;
+  }
+
+} // namespace freertos
@@ -0,0 +1,747 @@
+/*
+ * Coroutine.hpp
+ *
+ *  C++20 coroutines scheduled inside one task, frames taken from a
+ *  fixed pool.
+ */
+
+#ifndef LIB_FREERTOS_CPP_COROUTINE_HPP_
+#define LIB_FREERTOS_CPP_COROUTINE_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "BlockPool.hpp"
+#include "Queue.hpp"
+#include "Semaphore.hpp"
+#include "StreamBuffer.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/**
+ *  GCC lowers every coroutine body to a switch without a default label,
+ *  which -Wswitch-default reports at the coroutine. Put these around each
+ *  coroutine definition to silence it there and nowhere else:
+ *
+ *      FREERTOS_COROUTINE_BEGIN
+ *      Job blink(Executor& executor, Led& led)
+ *      {
+ *        ...
+ *      }
+ *      FREERTOS_COROUTINE_END
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#define FREERTOS_COROUTINE_BEGIN \
+  _Pragma("GCC diagnostic push") \
+  _Pragma("GCC diagnostic ignored \"-Wswitch-default\"")
+#define FREERTOS_COROUTINE_END _Pragma("GCC diagnostic pop")
+#else
+#define FREERTOS_COROUTINE_BEGIN
+#define FREERTOS_COROUTINE_END
+#endif
+
+namespace freertos {
+
+  class Executor;
+
+  /**
+   *  A coroutine run by an Executor.
+   *
+   *  A Job coroutine must take the Executor that runs it as one of its
+   *  parameters, its frame is allocated from that executor's pool:
+   *
+   *      Job blink(Executor& executor, Led& led)
+   *      {
+   *        loop {
+   *          led.toggle();
+   *          co_await executor.delay(pdMS_TO_TICKS(500));
+   *        }
+   *      }
+   *
+   *      executor.spawn(blink(executor, led));
+   *
+   *  Calling the coroutine only creates it, it starts running once
+   *  spawned. A Job that is never spawned frees its frame when the Job
+   *  object is destroyed. An empty Job, converting to false, means the
+   *  pool had no frame large enough.
+   */
+  class Job {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      struct promise_type;
+      using Handle = std::coroutine_handle<promise_type>;
+
+      Job() = default;
+
+      Job(Job&& other) noexcept
+          :m_handle(std::exchange(other.m_handle, nullptr))
+      {
+      }
+
+      Job& operator=(Job&& other) noexcept
+      {
+        if (this != &other) {
+          destroy();
+          m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+      }
+
+      ~Job()
+      {
+        destroy();
+      }
+
+      explicit operator bool() const
+      {
+        return static_cast<bool>(m_handle);
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      friend class Executor;
+
+      explicit Job(Handle handle)
+          :m_handle(handle)
+      {
+      }
+
+      void destroy()
+      {
+        if (m_handle) {
+          m_handle.destroy();
+          m_handle = nullptr;
+        }
+      }
+
+      Handle m_handle{};
+  };
+
+  /**
+   *  Runs Job coroutines inside the task that calls run().
+   *
+   *  Every job shares that task's stack, a suspended job only keeps its
+   *  coroutine frame, which holds the locals that live across a
+   *  co_await. Switching jobs is a function return and an indirect call,
+   *  no kernel context switch.
+   *
+   *  Jobs wait with co_await on the awaitables below. Delays and the
+   *  executor's own notification bits are exact. Kernel objects cannot
+   *  call back into the executor, so jobs waiting on a Queue, StreamBuffer
+   *  or Semaphore are polled whenever the executor wakes up, and a
+   *  producer outside the executor must call wake() or wakeFromISR()
+   *  after sending. Nothing polls on a timer: a blocked executor sleeps
+   *  until its next delay or timeout, which leaves tickless idle free to
+   *  stop the tick. Those awaits take their timeout explicitly, so every
+   *  call site decides between a bound and relying on wake().
+   *
+   *  The executor state is only touched from the executor task, apart
+   *  from notify(), wake() and their FromISR flavours which may be called
+   *  from anywhere, at any time. The executor task's notification value
+   *  belongs to the executor, the task must not wait on it otherwise.
+   */
+  class Executor {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      /**
+       *  A suspended job on one of the executor lists. Lives inside the
+       *  awaiter, so inside the job's own frame.
+       */
+      struct Waiter {
+        Waiter* next{nullptr};
+        std::coroutine_handle<> handle{};
+
+        /**
+         *  The awaiter the waiter is part of, for poll.
+         */
+        void* awaiter{nullptr};
+        bool (*poll)(Executor& executor, Waiter& waiter){nullptr};
+        TickType_t deadline{0};
+        bool timed{false};
+      };
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      Executor() = default;
+
+      virtual ~Executor() = default;
+
+      Executor(const Executor&) = delete;
+      Executor& operator=(const Executor&) = delete;
+
+      /**
+       *  Hand a job to the executor, it runs at the next opportunity.
+       *
+       *  @return false if the job is empty because its frame could not be
+       *          allocated.
+       */
+      bool spawn(Job&& job);
+
+      /**
+       *  Run jobs until all of them have finished, from the executor task.
+       *  Blocks the task while every job is waiting.
+       */
+      void run();
+
+      /**
+       *  Hand bits to jobs waiting on them with waitBits(). Bits sent
+       *  while run() is not active, before the executor task got to it or
+       *  after the last job finished, are kept for the next run().
+       */
+      void notify(uint32_t bits)
+      {
+        // Published before the handle is read, and run() sets the handle
+        // before collecting, so either the bits are collected or the task
+        // is woken to collect them.
+        (void) m_pendingBits.fetch_or(bits, std::memory_order_seq_cst);
+        TaskHandle_t task = m_task.load(std::memory_order_seq_cst);
+        if (task != nullptr) {
+          (void) xTaskNotify(task, 0, eSetBits);
+        }
+      }
+
+      /**
+       *  notify() in ISR context.
+       *
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       */
+      void notifyFromISR(uint32_t bits, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        (void) m_pendingBits.fetch_or(bits, std::memory_order_seq_cst);
+        TaskHandle_t task = m_task.load(std::memory_order_seq_cst);
+        if (task != nullptr) {
+          (void) xTaskNotifyFromISR(task, 0, eSetBits, pxHigherPriorityTaskWoken);
+        }
+      }
+
+      /**
+       *  Poll the jobs waiting on kernel objects, after sending to one of
+       *  them from outside the executor.
+       */
+      inline void wake()
+      {
+        notify(0);
+      }
+
+      /**
+       *  wake() in ISR context.
+       *
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       */
+      inline void wakeFromISR(BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        notifyFromISR(0, pxHigherPriorityTaskWoken);
+      }
+
+      /**
+       *  Number of jobs spawned and not finished yet.
+       */
+      [[nodiscard]] size_t jobs() const
+      {
+        return m_jobs;
+      }
+
+      /**
+       *  co_await yield(): let every other ready job run first.
+       */
+      class YieldAwaiter {
+        public:
+          bool await_ready() const noexcept
+          {
+            return false;
+          }
+
+          void await_suspend(std::coroutine_handle<> handle) noexcept
+          {
+            m_waiter.handle = handle;
+            m_executor.pushReady(m_waiter);
+          }
+
+          void await_resume() const noexcept
+          {
+          }
+
+        private:
+          friend class Executor;
+
+          explicit YieldAwaiter(Executor& executor)
+              :m_executor(executor)
+          {
+          }
+
+          Executor& m_executor;
+          Waiter m_waiter{};
+      };
+
+      [[nodiscard]] YieldAwaiter yield()
+      {
+        return YieldAwaiter{*this};
+      }
+
+      /**
+       *  co_await delay(ticks): resume once ticks have passed.
+       */
+      class DelayAwaiter {
+        public:
+          bool await_ready() const noexcept
+          {
+            return false;
+          }
+
+          void await_suspend(std::coroutine_handle<> handle) noexcept
+          {
+            m_waiter.handle = handle;
+            m_executor.insertDelay(m_waiter, m_ticks);
+          }
+
+          void await_resume() const noexcept
+          {
+          }
+
+        private:
+          friend class Executor;
+
+          DelayAwaiter(Executor& executor, TickType_t ticks)
+              :m_executor(executor), m_ticks(ticks)
+          {
+          }
+
+          Executor& m_executor;
+          TickType_t m_ticks;
+          Waiter m_waiter{};
+      };
+
+      [[nodiscard]] DelayAwaiter delay(TickType_t ticks)
+      {
+        return DelayAwaiter{*this, ticks};
+      }
+
+      /**
+       *  Waits until try() succeeds or the timeout passes. Result is what
+       *  try() reports, the empty Result on timeout.
+       */
+      template<typename Derived, typename Result>
+      class PollAwaiter {
+        public:
+          bool await_ready() noexcept
+          {
+            return static_cast<Derived*>(this)->attempt();
+          }
+
+          void await_suspend(std::coroutine_handle<> handle) noexcept
+          {
+            m_waiter.handle = handle;
+            m_waiter.awaiter = this;
+            m_waiter.poll = [](Executor&, Waiter& waiter) {
+              return static_cast<Derived*>(static_cast<PollAwaiter*>(waiter.awaiter))->attempt();
+            };
+            m_waiter.timed = m_timeout != portMAX_DELAY;
+            m_waiter.deadline = xTaskGetTickCount() + m_timeout;
+            m_executor.pushPoller(m_waiter);
+          }
+
+          Result await_resume() const noexcept
+          {
+            return m_result;
+          }
+
+        protected:
+          PollAwaiter(Executor& executor, TickType_t timeout)
+              :m_executor(executor), m_timeout(timeout)
+          {
+          }
+
+          Executor& m_executor;
+          TickType_t m_timeout;
+          Result m_result{};
+
+        private:
+          Waiter m_waiter{};
+      };
+
+      /**
+       *  co_await receive(queue, &item, timeout): bool, true if an item
+       *  was received before the timeout.
+       *
+       *  The queue is only looked at when the executor wakes up. A task or
+       *  ISR sending to it must call wake() or wakeFromISR() afterwards,
+       *  which is why there is no default timeout: portMAX_DELAY without
+       *  a waking producer never returns.
+       */
+      class QueueAwaiter : public PollAwaiter<QueueAwaiter, bool> {
+        private:
+          friend class Executor;
+          friend class PollAwaiter<QueueAwaiter, bool>;
+
+          QueueAwaiter(Executor& executor, Queue& queue, void* item, TickType_t timeout)
+              :PollAwaiter(executor, timeout), m_queue(queue), m_item(item)
+          {
+          }
+
+          bool attempt()
+          {
+            m_result = m_queue.dequeue(m_item, 0);
+            return m_result;
+          }
+
+          Queue& m_queue;
+          void* m_item;
+      };
+
+      [[nodiscard]] QueueAwaiter receive(Queue& queue, void* item, TickType_t timeout)
+      {
+        return QueueAwaiter{*this, queue, item, timeout};
+      }
+
+      /**
+       *  co_await receive(streamBuffer, data, length, timeout): size_t,
+       *  the bytes received, 0 on timeout. Senders wake() the executor, as
+       *  for a queue.
+       */
+      class StreamBufferAwaiter : public PollAwaiter<StreamBufferAwaiter, size_t> {
+        private:
+          friend class Executor;
+          friend class PollAwaiter<StreamBufferAwaiter, size_t>;
+
+          StreamBufferAwaiter(Executor& executor, StreamBuffer& buffer, void* data, size_t length,
+              TickType_t timeout)
+              :PollAwaiter(executor, timeout), m_buffer(buffer), m_data(data), m_length(length)
+          {
+          }
+
+          bool attempt()
+          {
+            m_result = m_buffer.receive(m_data, m_length, 0);
+            return m_result > 0;
+          }
+
+          StreamBuffer& m_buffer;
+          void* m_data;
+          size_t m_length;
+      };
+
+      [[nodiscard]] StreamBufferAwaiter receive(StreamBuffer& buffer, void* data, size_t length,
+          TickType_t timeout)
+      {
+        return StreamBufferAwaiter{*this, buffer, data, length, timeout};
+      }
+
+      /**
+       *  co_await take(semaphore, timeout): bool, true if taken before the
+       *  timeout. Givers wake() the executor, as for a queue.
+       */
+      class SemaphoreAwaiter : public PollAwaiter<SemaphoreAwaiter, bool> {
+        private:
+          friend class Executor;
+          friend class PollAwaiter<SemaphoreAwaiter, bool>;
+
+          SemaphoreAwaiter(Executor& executor, Semaphore& semaphore, TickType_t timeout)
+              :PollAwaiter(executor, timeout), m_semaphore(semaphore)
+          {
+          }
+
+          bool attempt()
+          {
+            m_result = m_semaphore.take(0);
+            return m_result;
+          }
+
+          Semaphore& m_semaphore;
+      };
+
+      [[nodiscard]] SemaphoreAwaiter take(Semaphore& semaphore, TickType_t timeout)
+      {
+        return SemaphoreAwaiter{*this, semaphore, timeout};
+      }
+
+      /**
+       *  co_await waitBits(mask): uint32_t, the bits of mask that were
+       *  notified, cleared for other waiters, 0 on timeout.
+       */
+      class BitsAwaiter {
+        public:
+          bool await_ready() noexcept
+          {
+            m_waiter.awaiter = this;
+            return attempt(m_executor, m_waiter);
+          }
+
+          void await_suspend(std::coroutine_handle<> handle) noexcept
+          {
+            m_waiter.handle = handle;
+            m_waiter.poll = &BitsAwaiter::attempt;
+            m_waiter.timed = m_timeout != portMAX_DELAY;
+            m_waiter.deadline = xTaskGetTickCount() + m_timeout;
+            m_executor.pushPoller(m_waiter);
+          }
+
+          uint32_t await_resume() const noexcept
+          {
+            return m_bits;
+          }
+
+        private:
+          friend class Executor;
+
+          BitsAwaiter(Executor& executor, uint32_t mask, TickType_t timeout)
+              :m_executor(executor), m_mask(mask), m_timeout(timeout)
+          {
+          }
+
+          static bool attempt(Executor& executor, Waiter& waiter)
+          {
+            auto* self = static_cast<BitsAwaiter*>(waiter.awaiter);
+            self->m_bits = executor.m_bits & self->m_mask;
+            executor.m_bits &= ~self->m_bits;
+            return self->m_bits != 0;
+          }
+
+          Executor& m_executor;
+          uint32_t m_mask;
+          TickType_t m_timeout;
+          uint32_t m_bits{0};
+          Waiter m_waiter{};
+      };
+
+      [[nodiscard]] BitsAwaiter waitBits(uint32_t mask, TickType_t timeout = portMAX_DELAY)
+      {
+        return BitsAwaiter{*this, mask, timeout};
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Protected API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    protected:
+      /**
+       *  Storage for one coroutine frame of size bytes, aligned for any
+       *  fundamental type, or nullptr.
+       */
+      virtual void* allocate(size_t size) = 0;
+      virtual void release(void* block) = 0;
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      friend struct Job::promise_type;
+
+      /**
+       *  Each frame is preceded by the executor it came from, so it can be
+       *  given back without one.
+       */
+      static constexpr size_t FRAME_HEADER = alignof(std::max_align_t);
+
+      void* allocateFrame(size_t size);
+      static void freeFrame(void* frame);
+      void finished();
+
+      void pushReady(Waiter& waiter);
+      void insertDelay(Waiter& waiter, TickType_t ticks);
+      void pushPoller(Waiter& waiter);
+
+      void runReady();
+      void expireDelays(TickType_t now);
+      void pollWaiters(TickType_t now);
+      TickType_t blockTime(TickType_t now) const;
+
+      void collectBits();
+
+      /**
+       *  The task inside run(), nullptr outside it.
+       */
+      std::atomic<TaskHandle_t> m_task{nullptr};
+      size_t m_jobs{0};
+
+      /**
+       *  Bits from notify() not collected by the executor task yet, the
+       *  task notification itself only wakes it.
+       */
+      std::atomic<uint32_t> m_pendingBits{0};
+
+      /**
+       *  Notification bits collected and not handed to a waiter yet.
+       */
+      uint32_t m_bits{0};
+
+      Waiter* m_readyHead{nullptr};
+      Waiter* m_readyTail{nullptr};
+
+      /**
+       *  Sorted by deadline.
+       */
+      Waiter* m_delays{nullptr};
+
+      Waiter* m_pollersHead{nullptr};
+      Waiter* m_pollersTail{nullptr};
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      /**
+       *  The executor among a coroutine's parameters.
+       */
+      template<typename First, typename... Rest>
+      static Executor& of(First& first, Rest&... rest)
+      {
+        if constexpr (std::is_base_of_v<Executor, std::remove_cvref_t<First>>) {
+          return first;
+        } else {
+          return of(rest...);
+        }
+      }
+  };
+
+  struct Job::promise_type {
+      template<typename... Args>
+      static void* operator new(size_t size, Args&... args) noexcept
+      {
+        static_assert((std::is_base_of_v<Executor, std::remove_cvref_t<Args>> || ...),
+            "A Job coroutine takes the Executor that runs it as a parameter");
+        return Executor::of(args...).allocateFrame(size);
+      }
+
+      static void operator delete(void* frame) noexcept
+      {
+        Executor::freeFrame(frame);
+      }
+
+      template<typename... Args>
+      explicit promise_type(Args&... args)
+          :executor(&Executor::of(args...))
+      {
+      }
+
+      ~promise_type()
+      {
+        if (spawned) {
+          executor->finished();
+        }
+      }
+
+      static Job get_return_object_on_allocation_failure()
+      {
+        return Job{};
+      }
+
+      Job get_return_object()
+      {
+        return Job{Handle::from_promise(*this)};
+      }
+
+      std::suspend_always initial_suspend() const noexcept
+      {
+        return {};
+      }
+
+      std::suspend_never final_suspend() const noexcept
+      {
+        return {};
+      }
+
+      void return_void() const
+      {
+      }
+
+      void unhandled_exception() const
+      {
+        configASSERT(!"Job coroutine threw");
+      }
+
+      Executor* executor;
+      Executor::Waiter waiter{};
+      bool spawned{false};
+  };
+
+  /**
+   *  Executor with Frames coroutine frames of up to FrameSize bytes each
+   *  in a BlockPool. A job whose frame is larger fails to spawn, the
+   *  largest frame requested so far tells how big FrameSize must be.
+   */
+  template<size_t FrameSize, size_t Frames>
+  class StaticExecutor : public Executor {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using Executor::Executor;
+
+      [[nodiscard]] BlockPoolStats frameStats() const
+      {
+        return m_frames.stats();
+      }
+
+      /**
+       *  Largest frame a coroutine asked for, header included.
+       */
+      [[nodiscard]] size_t largestFrame() const
+      {
+        return m_largestFrame;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Protected API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    protected:
+      void* allocate(size_t size) override
+      {
+        if (size > m_largestFrame) {
+          m_largestFrame = size;
+        }
+        return size <= m_frames.blockSize ? m_frames.allocate() : nullptr;
+      }
+
+      void release(void* block) override
+      {
+        m_frames.free(block);
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      BlockPool<FrameSize + alignof(std::max_align_t), Frames> m_frames{};
+      size_t m_largestFrame{0};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_COROUTINE_HPP_ */
@@ -0,0 +1,183 @@
+/*
+ * FlightRecorder.cpp
+ *
+ *  Event ring in memory that survives a reset: context switches, ISR
+ *  entries, log IDs and the fault registers of the last crash.
+ */
+
+#include "FlightRecorder.hpp"
+
+#include "Stats.hpp"
+
+#include "placement.h"
+
+#if defined(__arm__)
+#include CMSIS_device_header
+#endif
+
+namespace freertos {
+
+  namespace {
+
+#if defined(__arm__)
+    /**
+     *  In the .backup_sram section, never cleared by the startup code.
+     */
+    __attribute__((section(".backup_sram"))) FlightLog backupLog;
+#else
+    FlightLog backupLog;
+#endif
+
+    FlightRecorder systemRecorder{backupLog};
+
+    TaskHandle_t lastTask = nullptr;
+
+  } // namespace
+
+  FlightRecorder& FlightRecorder::system()
+  {
+    return systemRecorder;
+  }
+
+  bool FlightRecorder::start(FlightLog& previous)
+  {
+    uint32_t resetFlags = 0;
+#if defined(__arm__)
+    // Backup domain write access, then the backup SRAM clock. The read
+    // backs make sure each enable has taken effect before the next step.
+    RCC->APB1ENR = RCC->APB1ENR | RCC_APB1ENR_PWREN;
+    (void) RCC->APB1ENR;
+    PWR->CR = PWR->CR | PWR_CR_DBP;
+    RCC->AHB1ENR = RCC->AHB1ENR | RCC_AHB1ENR_BKPSRAMEN;
+    (void) RCC->AHB1ENR;
+
+    resetFlags = RCC->CSR;
+    RCC->CSR = RCC->CSR | RCC_CSR_RMVF;
+#endif
+    return systemRecorder.begin(previous, resetFlags);
+  }
+
+  bool FlightRecorder::begin(FlightLog& previous, uint32_t resetFlags)
+  {
+    m_recording.store(false, std::memory_order_relaxed);
+
+    const bool recovered = isValid(m_log);
+    previous.magic = 0;
+    if (recovered) {
+      previous.magic = m_log.magic;
+      previous.sessions = m_log.sessions;
+      previous.resetFlags = m_log.resetFlags;
+      previous.faulted = m_log.faulted;
+      previous.fault = m_log.fault;
+      previous.head.store(m_log.head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      previous.records = m_log.records;
+    }
+
+    m_log.sessions = recovered ? m_log.sessions + 1 : 1;
+    m_log.resetFlags = resetFlags;
+    m_log.faulted = 0;
+    m_log.fault = {};
+    m_log.head.store(0, std::memory_order_relaxed);
+    m_log.records.fill({});
+    m_log.magic = FlightLog::MAGIC;
+
+    m_recording.store(true, std::memory_order_release);
+    return recovered;
+  }
+
+  void FlightRecorder::stop()
+  {
+    m_recording.store(false, std::memory_order_relaxed);
+  }
+
+  bool FlightRecorder::isRecording() const
+  {
+    return m_recording.load(std::memory_order_relaxed);
+  }
+
+  RAMFUNC void FlightRecorder::record(FlightEvent event, uint32_t payload)
+  {
+    if (!m_recording.load(std::memory_order_acquire)) {
+      return;
+    }
+
+    // Claiming the slot is the only shared step, an ISR preempting the
+    // two stores below writes a slot of its own.
+    const uint32_t index = m_log.head.fetch_add(1, std::memory_order_relaxed);
+    FlightRecord& slot = m_log.records[index & (FlightLog::CAPACITY - 1)];
+    slot.timestamp = Stats::timestamp();
+    slot.word = (static_cast<uint32_t>(event) << FlightRecord::PAYLOAD_BITS) | (payload & FlightRecord::PAYLOAD_MASK);
+  }
+
+  void FlightRecorder::recordFault(const FaultRegisters& registers)
+  {
+    if (!m_recording.load(std::memory_order_acquire)) {
+      return;
+    }
+    m_log.fault = registers;
+    m_log.faulted = 1;
+    record(FlightEvent::Fault, registers.cfsr);
+  }
+
+  bool FlightRecorder::isValid(const FlightLog& log)
+  {
+    return log.magic == FlightLog::MAGIC && log.sessions != 0;
+  }
+
+} // namespace freertos
+
+using namespace freertos;
+
+/**
+ *  Runs inside vTaskSwitchContext() next to the statistics hook, records
+ *  actual task changes only.
+ */
+RAMFUNC void freertos_flight_task_switched_in(void)
+{
+  TaskHandle_t current = xTaskGetCurrentTaskHandle();
+  if (current == lastTask) {
+    return;
+  }
+  lastTask = current;
+  systemRecorder.record(FlightEvent::TaskSwitch, static_cast<uint32_t>(reinterpret_cast<uintptr_t>(current)));
+}
+
+RAMFUNC void freertos_flight_isr(void)
+{
+#if defined(__arm__)
+  systemRecorder.record(FlightEvent::Isr, __get_IPSR());
+#else
+  systemRecorder.record(FlightEvent::Isr, 0);
+#endif
+}
+
+void freertos_flight_fault(const uint32_t* frame, uint32_t excReturn)
+{
+#if defined(__arm__)
+  // Stacking faults leave no usable frame, reading it would fault again.
+  constexpr uint32_t STACKING_ERRORS = SCB_CFSR_MSTKERR_Msk | SCB_CFSR_STKERR_Msk;
+
+  FaultRegisters registers{};
+  registers.cfsr = SCB->CFSR;
+  registers.hfsr = SCB->HFSR;
+  registers.mmfar = SCB->MMFAR;
+  registers.bfar = SCB->BFAR;
+  registers.excReturn = excReturn;
+
+  registers.sp = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(frame));
+  if ((registers.cfsr & STACKING_ERRORS) == 0U) {
+    registers.r0 = frame[0];
+    registers.r1 = frame[1];
+    registers.r2 = frame[2];
+    registers.r3 = frame[3];
+    registers.r12 = frame[4];
+    registers.lr = frame[5];
+    registers.pc = frame[6];
+    registers.psr = frame[7];
+  }
+  systemRecorder.recordFault(registers);
+#else
+  (void) frame;
+  (void) excReturn;
+#endif
+}
@@ -0,0 +1,269 @@
+/*
+ * FlightRecorder.hpp
+ *
+ *  Event ring in memory that survives a reset: context switches, ISR
+ *  entries, log IDs and the fault registers of the last crash.
+ */
+
+#ifndef LIB_FREERTOS_CPP_FLIGHT_RECORDER_HPP_
+#define LIB_FREERTOS_CPP_FLIGHT_RECORDER_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  Kernel and interrupt hooks, declared and wired up in FreeRTOSConfig.h:
+ *
+ *    traceTASK_SWITCHED_IN()  freertos_flight_task_switched_in()
+ *
+ *  C interrupt handlers call freertos_flight_isr() on entry and the fault
+ *  handlers freertos_flight_fault() with the stacked exception frame and
+ *  their EXC_RETURN value. Every LOG() record is entered with its message
+ *  ID.
+ */
+
+namespace freertos {
+
+  enum class FlightEvent : uint8_t {
+    Empty = 0,
+
+    /**
+     *  Payload is the low 28 bits of the task handle switched in.
+     */
+    TaskSwitch,
+
+    /**
+     *  Payload is the active exception number, IRQn + 16.
+     */
+    Isr,
+
+    /**
+     *  Payload is the LOG() message ID.
+     */
+    Log,
+
+    /**
+     *  Payload is the low 28 bits of CFSR, the registers are in the
+     *  FlightLog.
+     */
+    Fault,
+
+    /**
+     *  Payload is up to the application.
+     */
+    Mark,
+  };
+
+  /**
+   *  One event, 8 bytes.
+   */
+  struct FlightRecord {
+    static constexpr uint32_t PAYLOAD_BITS = 28;
+    static constexpr uint32_t PAYLOAD_MASK = (1U << PAYLOAD_BITS) - 1U;
+
+    /**
+     *  Raw Stats::timestamp(), CPU cycles on target.
+     */
+    uint32_t timestamp;
+
+    /**
+     *  Event in the top 4 bits, payload in the rest.
+     */
+    uint32_t word;
+
+    [[nodiscard]] FlightEvent event() const
+    {
+      return static_cast<FlightEvent>(word >> PAYLOAD_BITS);
+    }
+
+    [[nodiscard]] uint32_t payload() const
+    {
+      return word & PAYLOAD_MASK;
+    }
+  };
+
+  /**
+   *  Fault status registers and the exception frame stacked by the
+   *  fault, from either stack. sp is where the frame was stacked. A
+   *  stacking error leaves the frame zero.
+   */
+  struct FaultRegisters {
+    uint32_t cfsr;
+    uint32_t hfsr;
+    uint32_t mmfar;
+    uint32_t bfar;
+    uint32_t excReturn;
+    uint32_t sp;
+    uint32_t r0;
+    uint32_t r1;
+    uint32_t r2;
+    uint32_t r3;
+    uint32_t r12;
+    uint32_t lr;
+    uint32_t pc;
+    uint32_t psr;
+  };
+
+  /**
+   *  Memory layout of a recording. A trivial aggregate so an instance in
+   *  a NOLOAD section is neither cleared nor constructed at startup.
+   */
+  struct FlightLog {
+    static constexpr size_t CAPACITY = 256;
+    static constexpr uint32_t MAGIC = 0x464C5431; // "FLT1"
+
+    uint32_t magic;
+
+    /**
+     *  Recordings started in this memory, the current one included.
+     */
+    uint32_t sessions;
+
+    /**
+     *  Reset cause read when the session started, RCC CSR on target.
+     */
+    uint32_t resetFlags;
+
+    /**
+     *  Non zero once fault holds registers.
+     */
+    uint32_t faulted;
+
+    FaultRegisters fault;
+
+    /**
+     *  Records ever written, the next one goes to head % CAPACITY.
+     */
+    std::atomic<uint32_t> head;
+
+    std::array<FlightRecord, CAPACITY> records;
+  };
+
+  static_assert((FlightLog::CAPACITY & (FlightLog::CAPACITY - 1)) == 0, "FlightLog capacity must be a power of two");
+  static_assert(sizeof(FlightLog) <= 4096, "FlightLog must fit the 4K backup SRAM");
+
+  /**
+   *  Flight recorder writing into a FlightLog that outlives the program,
+   *  the 4K backup SRAM on target.
+   *
+   *  Recording an event is a timestamp read, an atomic increment and two
+   *  stores, safe from tasks and ISRs at any priority. The oldest events
+   *  are overwritten, the log always holds the last CAPACITY ones.
+   *
+   *  At boot begin() checks whether the memory holds the session that
+   *  was running before the reset, copies it out for dumping and starts a
+   *  new one in place:
+   *
+   *      FlightLog previous;
+   *      if (FlightRecorder::start(previous)) {
+   *        FlightRecorder::forEach(previous, [](const FlightRecord& record) { ... });
+   *      }
+   *
+   *  Records are not synchronised with a reset, the last one may be torn
+   *  if the reset hit while it was being written.
+   */
+  class FlightRecorder {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      explicit constexpr FlightRecorder(FlightLog& log)
+          :m_log(log)
+      {
+      }
+
+      FlightRecorder(const FlightRecorder&) = delete;
+      FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+      /**
+       *  The recorder the kernel, interrupt and log hooks write to, in the
+       *  backup SRAM on target and in a plain buffer on the host.
+       */
+      static FlightRecorder& system();
+
+      /**
+       *  Power the backup SRAM, read and clear the reset cause and begin()
+       *  the system() recorder. Call once at boot, before the scheduler
+       *  starts and before interrupts using the hooks are enabled.
+       *
+       *  @param previous Receives the session from before the reset.
+       *  @return true if previous holds a session.
+       */
+      static bool start(FlightLog& previous);
+
+      /**
+       *  Recover the session left in memory, if any, then start recording
+       *  a new one. Events before begin() are ignored.
+       *
+       *  @param previous Receives the session from before the reset.
+       *  @param resetFlags Stored with the new session.
+       *  @return true if previous holds a session.
+       */
+      bool begin(FlightLog& previous, uint32_t resetFlags = 0);
+
+      /**
+       *  Stop recording, later events are ignored.
+       */
+      void stop();
+
+      [[nodiscard]] bool isRecording() const;
+
+      void record(FlightEvent event, uint32_t payload);
+
+      /**
+       *  Store the fault registers and record a Fault event.
+       */
+      void recordFault(const FaultRegisters& registers);
+
+      [[nodiscard]] const FlightLog& log() const
+      {
+        return m_log;
+      }
+
+      /**
+       *  Does the memory hold a session?
+       */
+      static bool isValid(const FlightLog& log);
+
+      /**
+       *  Number of records forEach() visits.
+       */
+      static size_t size(const FlightLog& log)
+      {
+        const uint32_t head = log.head.load(std::memory_order_relaxed);
+        return head < FlightLog::CAPACITY ? head : FlightLog::CAPACITY;
+      }
+
+      /**
+       *  Visit the records of a session from oldest to newest.
+       */
+      template<typename Function>
+      static void forEach(const FlightLog& log, Function&& function)
+      {
+        const uint32_t head = log.head.load(std::memory_order_relaxed);
+        for (uint32_t i = head - static_cast<uint32_t>(size(log)); i != head; ++i) {
+          function(log.records[i & (FlightLog::CAPACITY - 1)]);
+        }
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      FlightLog& m_log;
+      std::atomic<bool> m_recording{false};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_FLIGHT_RECORDER_HPP_ */
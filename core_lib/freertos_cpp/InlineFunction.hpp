@@ -0,0 +1,106 @@
+/*
+ * InlineFunction.hpp
+ *
+ *  Callable wrapper that stores its target inside the object, never on
+ *  the heap.
+ */
+
+#ifndef LIB_FREERTOS_CPP_INLINEFUNCTION_HPP_
+#define LIB_FREERTOS_CPP_INLINEFUNCTION_HPP_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace freertos {
+
+  template<typename Signature, size_t Capacity = 2 * sizeof(void*)>
+  class InlineFunction;
+
+  /**
+   *  A std::function replacement for callbacks run from ISRs and kernel
+   *  services.
+   *
+   *  The callable is copied into Capacity bytes of inline storage and
+   *  called through a single function pointer, there is no virtual call
+   *  and no allocation. Only trivially copyable and trivially destructible
+   *  callables are accepted, which covers function pointers and lambdas
+   *  capturing pointers, references and plain values, so copying an
+   *  InlineFunction is a plain memory copy.
+   *
+   *  A callable that does not fit fails to compile, raise Capacity or
+   *  capture a pointer to the state instead.
+   */
+  template<typename R, typename... Args, size_t Capacity>
+  class InlineFunction<R(Args...), Capacity> {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      InlineFunction() = default;
+
+      template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineFunction>>>
+      InlineFunction(F&& function)
+      {
+        assign(std::forward<F>(function));
+      }
+
+      template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineFunction>>>
+      InlineFunction& operator=(F&& function)
+      {
+        assign(std::forward<F>(function));
+        return *this;
+      }
+
+      /**
+       *  Call the stored callable, which must be set.
+       */
+      inline R operator()(Args... args) const
+      {
+        return m_invoke(m_storage, std::forward<Args>(args)...);
+      }
+
+      explicit operator bool() const
+      {
+        return m_invoke != nullptr;
+      }
+
+      void reset()
+      {
+        m_invoke = nullptr;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      using Invoker = R (*)(const void*, Args...);
+
+      template<typename F>
+      void assign(F&& function)
+      {
+        using Target = std::decay_t<F>;
+        static_assert(std::is_trivially_copyable_v<Target> && std::is_trivially_destructible_v<Target>,
+            "InlineFunction only stores trivially copyable callables, capture pointers instead of objects");
+        static_assert(sizeof(Target) <= Capacity, "Callable does not fit, raise the InlineFunction Capacity");
+        static_assert(alignof(Target) <= alignof(std::max_align_t), "Callable is over aligned");
+
+        ::new (static_cast<void*>(m_storage)) Target(std::forward<F>(function));
+        m_invoke = [](const void* storage, Args... args) -> R {
+          return (*std::launder(static_cast<const Target*>(storage)))(std::forward<Args>(args)...);
+        };
+      }
+
+      alignas(std::max_align_t) unsigned char m_storage[Capacity]{};
+      Invoker m_invoke{nullptr};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_INLINEFUNCTION_HPP_ */
@@ -8,21 +8,11 @@
 #ifndef LIB_FREERTOS_CPP_MUTEX_HPP_
 #define LIB_FREERTOS_CPP_MUTEX_HPP_
 
-#ifndef UNIT_TEST
-
 #include "FreeRTOS.h"
 #include "semphr.h"
 
-#else
-
-#include "FreertosMock.hpp"
-
-#endif
-
 namespace freertos {
 
-#ifndef UNIT_TEST
-
   /**
    *  Standard usage Mutex.
    *  By default calls to Lock these objects block forever, but this can be
@@ -72,40 +62,6 @@ namespace freertos {
       #endif
   };
 
-#else
-
-  class Mutex {
-
-    /////////////////////////////////////////////////////////////////////////
-    //
-    //  Public API
-    //
-    /////////////////////////////////////////////////////////////////////////
-    public:
-    virtual ~Mutex();
-
-    /**
-     *  Lock the Mutex.
-     *
-     *  @param Timeout How long to wait to get the Lock until giving up.
-     *  @return true if the Lock was acquired, false if it timed out.
-     */
-    bool lock(TickType_t Timeout = portMAX_DELAY) {
-      return true;
-    }
-
-    /**
-     *  Unlock the Mutex.
-     *
-     *  @return true if the Lock was released, false if it failed. (Hint,
-     *           if it fails, did you call Lock() first?)
-     */
-    bool unlock() {
-      return true;
-    }
-  };
-
-#endif
 
 #if (configUSE_RECURSIVE_MUTEXES == 1)
 
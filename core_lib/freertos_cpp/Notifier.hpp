@@ -0,0 +1,195 @@
+/*
+ * Notifier.hpp
+ *
+ *  Semaphore and event flag replacements built on direct to task
+ *  notifications.
+ */
+
+#ifndef LIB_FREERTOS_CPP_NOTIFIER_HPP_
+#define LIB_FREERTOS_CPP_NOTIFIER_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Task.hpp"
+
+#include <cstdint>
+
+namespace freertos {
+
+  /**
+   *  The task a notification based primitive signals. Binding to a Task
+   *  object looks its handle up on every use, so the primitive can be
+   *  created before the task is started.
+   *
+   *  FreeRTOS 10.3 has a single notification value per task. A task may
+   *  wait on only one of these primitives, and not on them together with
+   *  anything else using its notification value such as SpscRing::receive().
+   */
+  class NotificationTarget {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      explicit NotificationTarget(Task& task)
+          :m_task(&task), m_handle(nullptr)
+      {
+      }
+
+      explicit NotificationTarget(TaskHandle_t handle)
+          :m_task(nullptr), m_handle(handle)
+      {
+      }
+
+      /**
+       *  Handle of the task being notified, nullptr if that task has not
+       *  been started yet.
+       */
+      inline TaskHandle_t target() const
+      {
+        return m_task != nullptr ? m_task->getHandle() : m_handle;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Protected API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    protected:
+      /**
+       *  Only the bound task may wait on its own notification value.
+       */
+      inline void assertCalledByTarget() const
+      {
+        configASSERT(xTaskGetCurrentTaskHandle() == target());
+      }
+
+    private:
+      Task* m_task;
+      TaskHandle_t m_handle;
+  };
+
+  enum class SemaphoreMode {
+    /**
+     *  take() consumes every give() made since the previous take().
+     */
+    Binary,
+
+    /**
+     *  take() consumes one give(), like a counting semaphore without a
+     *  maximum count.
+     */
+    Counting
+  };
+
+  /**
+   *  Semaphore that only its target task can take.
+   *
+   *  Replaces BinarySemaphore and CountingSemaphore for the common case
+   *  of an ISR or task waking one known task. Giving is a direct write to
+   *  the target's TCB instead of a pass through the queue code, and the
+   *  object holds no kernel storage of its own, only the target binding.
+   */
+  template<SemaphoreMode Mode = SemaphoreMode::Binary>
+  class LightweightSemaphore : public NotificationTarget {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using NotificationTarget::NotificationTarget;
+
+      /**
+       *  Release (give) the semaphore.
+       */
+      inline void give()
+      {
+        (void) xTaskNotifyGive(target());
+      }
+
+      /**
+       *  Release (give) the semaphore from ISR context.
+       *
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       */
+      inline void giveFromISR(BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        vTaskNotifyGiveFromISR(target(), pxHigherPriorityTaskWoken);
+      }
+
+      /**
+       *  Aquire (take) the semaphore, from the target task only.
+       *
+       *  @param Timeout How long to wait until giving up.
+       *  @return true if the semaphore was acquired, false if it timed out.
+       */
+      inline bool take(TickType_t Timeout = portMAX_DELAY)
+      {
+        assertCalledByTarget();
+        return ulTaskNotifyTake(Mode == SemaphoreMode::Binary ? pdTRUE : pdFALSE, Timeout) != 0;
+      }
+  };
+
+  using BinaryNotifier = LightweightSemaphore<SemaphoreMode::Binary>;
+  using CountingNotifier = LightweightSemaphore<SemaphoreMode::Counting>;
+
+  /**
+   *  Event bits delivered to one task, a replacement for an EventGroup
+   *  that has a single waiter.
+   */
+  class Notifier : public NotificationTarget {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using NotificationTarget::NotificationTarget;
+
+      /**
+       *  OR bits into the target's notification value.
+       */
+      inline void set(uint32_t bits)
+      {
+        (void) xTaskNotify(target(), bits, eSetBits);
+      }
+
+      /**
+       *  OR bits into the target's notification value from ISR context.
+       *
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       */
+      inline void setFromISR(uint32_t bits, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        (void) xTaskNotifyFromISR(target(), bits, eSetBits, pxHigherPriorityTaskWoken);
+      }
+
+      /**
+       *  Wait for any bit to be set, from the target task only.
+       *
+       *  @param Timeout How long to wait until giving up.
+       *  @param bitsToClear Bits cleared once the wait returns.
+       *  @return The bits that were set, 0 on timeout.
+       */
+      inline uint32_t wait(TickType_t Timeout = portMAX_DELAY, uint32_t bitsToClear = UINT32_MAX)
+      {
+        assertCalledByTarget();
+        uint32_t bits = 0;
+        if (xTaskNotifyWait(0, bitsToClear, &bits, Timeout) != pdTRUE) {
+          return 0;
+        }
+        return bits;
+      }
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_NOTIFIER_HPP_ */
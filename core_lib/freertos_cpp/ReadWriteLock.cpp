@@ -101,7 +101,7 @@ ReadWriteLockPreferWriter::ReadWriteLockPreferWriter()
   //  Semaphores are not subject to this constraint.
   //
   #if(configSUPPORT_STATIC_ALLOCATION == 1)
-  blockReadersLock   = xSemaphoreCreateBinaryStatic(&readBuffer);
+  blockReadersLock   = xSemaphoreCreateBinaryStatic(&readerBuffer);
   #else
   blockReadersLock = xSemaphoreCreateBinary();
   #endif
@@ -0,0 +1,374 @@
+/*
+ * RwLock.hpp
+ *
+ *  Reader/writer lock on a single kernel object with a lock free
+ *  uncontended path.
+ */
+
+#ifndef LIB_FREERTOS_CPP_RWLOCK_HPP_
+#define LIB_FREERTOS_CPP_RWLOCK_HPP_
+
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#include "task.h"
+
+#include "Critical.hpp"
+
+#include <cstdint>
+
+namespace freertos {
+
+  enum class RwLockPolicy {
+    /**
+     *  Readers enter whenever no writer holds the lock. A steady stream
+     *  of readers can starve a writer.
+     */
+    PreferReader,
+
+    /**
+     *  Readers also wait while a writer is waiting. A steady stream of
+     *  writers can starve readers.
+     */
+    PreferWriter
+  };
+
+  /**
+   *  Reader/writer lock.
+   *
+   *  The lock state is a pair of counters updated inside a short critical
+   *  section, so taking and releasing an uncontended lock makes no kernel
+   *  object call at all. Only a task that has to wait touches the event
+   *  group, and a release only sets a bit when someone is waiting.
+   *
+   *  Waiting writers and waiting readers have a bit each. A waiter clears
+   *  its bit before it checks the state, never after, so a release that
+   *  lands between the check and the wait leaves the bit set. A release
+   *  wakes all waiters of a kind, which then re-check the state in
+   *  priority order; every waiter that leaves passes the wakeup on when
+   *  the lock is still free for someone, so a bit cleared by one waiter
+   *  cannot strand another. This keeps the lock down to one kernel object
+   *  at the price of spurious wakeups when writers contend.
+   *
+   *  Unlike the ReadWriteLock classes this lock supports timeouts, has no
+   *  virtual functions, and the policy is a template parameter. Like them
+   *  it cannot be used from ISR context and does not do priority
+   *  inheritance.
+   */
+  template<RwLockPolicy Policy = RwLockPolicy::PreferReader>
+  class RwLock {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      RwLock()
+      {
+        #if(configSUPPORT_STATIC_ALLOCATION == 1)
+        m_events = xEventGroupCreateStatic(&m_eventsBuffer);
+        #else
+        m_events = xEventGroupCreate();
+        #endif
+
+        if (m_events == nullptr) {
+          configASSERT(!"RwLock Constructor Failed");
+        }
+      }
+
+      ~RwLock()
+      {
+        vEventGroupDelete(m_events);
+      }
+
+      RwLock(const RwLock&) = delete;
+      RwLock& operator=(const RwLock&) = delete;
+
+      /**
+       *  Take the lock as a Reader.
+       *  This allows multiple reader access.
+       *
+       *  @param Timeout How long to wait to get the lock until giving up.
+       *  @return true if the lock was acquired, false if it timed out.
+       */
+      bool readerLock(TickType_t Timeout = portMAX_DELAY)
+      {
+        return acquire(false, Timeout);
+      }
+
+      /**
+       *  Unlock the Reader.
+       */
+      void readerUnlock()
+      {
+        CriticalSection::enter();
+        configASSERT(m_readers > 0);
+        --m_readers;
+        const EventBits_t wake = wakeups();
+        CriticalSection::exit();
+
+        if (wake != 0) {
+          (void) xEventGroupSetBits(m_events, wake);
+        }
+      }
+
+      /**
+       *  Take the lock as a Writer.
+       *  This allows only one thread access.
+       *
+       *  @param Timeout How long to wait to get the lock until giving up.
+       *  @return true if the lock was acquired, false if it timed out.
+       */
+      bool writerLock(TickType_t Timeout = portMAX_DELAY)
+      {
+        return acquire(true, Timeout);
+      }
+
+      /**
+       *  Unlock the Writer.
+       */
+      void writerUnlock()
+      {
+        CriticalSection::enter();
+        configASSERT(m_writer);
+        m_writer = false;
+        const EventBits_t wake = wakeups();
+        CriticalSection::exit();
+
+        if (wake != 0) {
+          (void) xEventGroupSetBits(m_events, wake);
+        }
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      static constexpr EventBits_t WRITER_READY = 1 << 0;
+      static constexpr EventBits_t READERS_READY = 1 << 1;
+
+      /**
+       *  Must be called inside the critical section.
+       */
+      inline bool writerCanEnter() const
+      {
+        return !m_writer && m_readers == 0;
+      }
+
+      /**
+       *  Must be called inside the critical section.
+       */
+      inline bool readerCanEnter() const
+      {
+        return !m_writer && (Policy == RwLockPolicy::PreferReader || m_writersWaiting == 0);
+      }
+
+      /**
+       *  The bits to set for the waiters that could take the lock now.
+       *  Must be called inside the critical section, the bits are set
+       *  after leaving it.
+       */
+      inline EventBits_t wakeups() const
+      {
+        EventBits_t bits = 0;
+        if (m_writersWaiting > 0 && writerCanEnter()) {
+          bits |= WRITER_READY;
+        }
+        if (m_readersWaiting > 0 && readerCanEnter()) {
+          bits |= READERS_READY;
+        }
+        return bits;
+      }
+
+      /**
+       *  Must be called inside the critical section. A waiting writer is
+       *  counted in m_writersWaiting, which only holds readers back.
+       */
+      inline bool tryAcquire(bool writer)
+      {
+        if (writer) {
+          if (!writerCanEnter()) {
+            return false;
+          }
+          m_writer = true;
+          return true;
+        }
+
+        if (!readerCanEnter()) {
+          return false;
+        }
+        ++m_readers;
+        return true;
+      }
+
+      bool acquire(bool writer, TickType_t Timeout)
+      {
+        CriticalSection::enter();
+        if (tryAcquire(writer)) {
+          CriticalSection::exit();
+          return true;
+        }
+        if (Timeout == 0) {
+          CriticalSection::exit();
+          return false;
+        }
+
+        uint16_t& waiting = writer ? m_writersWaiting : m_readersWaiting;
+        const EventBits_t ready = writer ? WRITER_READY : READERS_READY;
+        ++waiting;
+        CriticalSection::exit();
+
+        TimeOut_t timeOut;
+        vTaskSetTimeOutState(&timeOut);
+
+        bool acquired = false;
+        for (;;) {
+          // Clear the bit before looking at the state, a release after
+          // this point sets it again and the wait returns at once.
+          (void) xEventGroupClearBits(m_events, ready);
+
+          CriticalSection::enter();
+          acquired = tryAcquire(writer);
+          if (acquired) {
+            break;
+          }
+          CriticalSection::exit();
+
+          if (xTaskCheckForTimeOut(&timeOut, &Timeout) == pdTRUE) {
+            CriticalSection::enter();
+            break;
+          }
+          (void) xEventGroupWaitBits(m_events, ready, pdFALSE, pdFALSE, Timeout);
+        }
+
+        --waiting;
+        // Pass on a wakeup this task's clear may have swallowed, and one
+        // for readers held back by a writer that gave up.
+        const EventBits_t wake = wakeups();
+        CriticalSection::exit();
+
+        if (wake != 0) {
+          (void) xEventGroupSetBits(m_events, wake);
+        }
+        return acquired;
+      }
+
+      EventGroupHandle_t m_events;
+
+      #if(configSUPPORT_STATIC_ALLOCATION == 1)
+      StaticEventGroup_t m_eventsBuffer{};
+      #endif
+
+      uint16_t m_readers{0};
+      uint16_t m_readersWaiting{0};
+      uint16_t m_writersWaiting{0};
+      bool m_writer{false};
+  };
+
+  /**
+   *  RAII reader lock, the read counterpart of LockGuard.
+   */
+  template<class lock_class>
+  class ReadGuard {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      /**
+       * Create a ReadGuard on a specific lock.
+       * @param l: The lock will be taken as a reader.
+       * @param Timeout: How long to wait to get the Lock until giving up.
+       */
+      explicit ReadGuard(lock_class& l, TickType_t Timeout = portMAX_DELAY)
+          :m_lock(l)
+      {
+        lock_acquired = l.readerLock(Timeout);
+      }
+
+      ~ReadGuard()
+      {
+        if (lock_acquired) {
+          m_lock.readerUnlock();
+        }
+      }
+
+      ReadGuard(const ReadGuard&) = delete;
+      ReadGuard& operator=(const ReadGuard&) = delete;
+
+      /**
+       * @return states if lock was acquired
+       */
+      bool lockAcquired() const
+      {
+        return lock_acquired;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      lock_class& m_lock;
+      bool lock_acquired = false;
+  };
+
+  /**
+   *  RAII writer lock, the write counterpart of LockGuard.
+   */
+  template<class lock_class>
+  class WriteGuard {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      /**
+       * Create a WriteGuard on a specific lock.
+       * @param l: The lock will be taken as a writer.
+       * @param Timeout: How long to wait to get the Lock until giving up.
+       */
+      explicit WriteGuard(lock_class& l, TickType_t Timeout = portMAX_DELAY)
+          :m_lock(l)
+      {
+        lock_acquired = l.writerLock(Timeout);
+      }
+
+      ~WriteGuard()
+      {
+        if (lock_acquired) {
+          m_lock.writerUnlock();
+        }
+      }
+
+      WriteGuard(const WriteGuard&) = delete;
+      WriteGuard& operator=(const WriteGuard&) = delete;
+
+      /**
+       * @return states if lock was acquired
+       */
+      bool lockAcquired() const
+      {
+        return lock_acquired;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      lock_class& m_lock;
+      bool lock_acquired = false;
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_RWLOCK_HPP_ */
@@ -0,0 +1,151 @@
+/*
+ * SeqLock.hpp
+ *
+ *  Sequence lock for publishing small values from one writer to any
+ *  number of readers.
+ */
+
+#ifndef LIB_FREERTOS_CPP_SEQLOCK_HPP_
+#define LIB_FREERTOS_CPP_SEQLOCK_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace freertos {
+
+  /**
+   *  Latest value of T, written by a single writer (an ISR or one task)
+   *  and read by any number of tasks.
+   *
+   *  The writer never blocks and never waits for readers, it bumps a
+   *  sequence counter to odd, stores the value and bumps it back to even.
+   *  Readers copy the value and retry if the counter was odd or changed
+   *  in the meantime. Neither side disables interrupts or calls the
+   *  kernel.
+   *
+   *  The value is kept as relaxed atomic words, so a torn read is a retry
+   *  and never undefined behaviour.
+   *
+   *  @note read() spins until it gets a consistent copy. That is only
+   *        safe when the writer can preempt the reader, the usual ISR to
+   *        task direction. A reader that can preempt the writer, such as
+   *        an ISR reading what a task writes, must use tryRead().
+   */
+  template<typename T>
+  class SeqLock {
+
+      static_assert(std::is_trivially_copyable_v<T>, "SeqLock copies T word by word");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using value_type = T;
+
+      SeqLock() = default;
+
+      explicit SeqLock(const T& initial)
+      {
+        write(initial);
+      }
+
+      SeqLock(const SeqLock&) = delete;
+      SeqLock& operator=(const SeqLock&) = delete;
+
+      /**
+       *  Publish a new value. Only one context may write.
+       */
+      void write(const T& value)
+      {
+        std::array<uint32_t, WORDS> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WORDS; ++i) {
+          m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        m_sequence.store(sequence + 2, std::memory_order_release);
+      }
+
+      /**
+       *  Copy the value if no write is in progress or interferes.
+       *
+       *  @param value Where the value is copied to, only on success.
+       *  @return true if value holds a consistent copy.
+       */
+      bool tryRead(T& value) const
+      {
+        const uint32_t before = m_sequence.load(std::memory_order_acquire);
+        if ((before & 1U) != 0) {
+          return false;
+        }
+
+        std::array<uint32_t, WORDS> words;
+        for (size_t i = 0; i < WORDS; ++i) {
+          words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) != before) {
+          return false;
+        }
+
+        std::memcpy(&value, words.data(), sizeof(T));
+        return true;
+      }
+
+      /**
+       *  Copy the value, retrying until the copy is consistent.
+       */
+      T read() const
+      {
+        T value;
+        while (!tryRead(value)) {
+          m_retries.fetch_add(1, std::memory_order_relaxed);
+        }
+        return value;
+      }
+
+      /**
+       *  Even number that changes with every write, lets a reader tell
+       *  whether there is anything new.
+       */
+      [[nodiscard]] inline uint32_t sequence() const
+      {
+        return m_sequence.load(std::memory_order_acquire) & ~1U;
+      }
+
+      /**
+       *  Number of times read() had to retry.
+       */
+      [[nodiscard]] inline uint32_t retries() const
+      {
+        return m_retries.load(std::memory_order_relaxed);
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+      std::atomic<uint32_t> m_sequence{0};
+      std::array<std::atomic<uint32_t>, WORDS> m_words{};
+      mutable std::atomic<uint32_t> m_retries{0};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_SEQLOCK_HPP_ */
@@ -0,0 +1,271 @@
+/*
+ * SharedEvent.hpp
+ *
+ *  Reference counted events allocated from a fixed pool.
+ */
+
+#ifndef LIB_FREERTOS_CPP_SHAREDEVENT_HPP_
+#define LIB_FREERTOS_CPP_SHAREDEVENT_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "BlockPool.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace freertos {
+
+  /**
+   *  Control block in front of every pooled event: the reference count
+   *  and how to destroy the event once the last reference is gone.
+   */
+  class EventBlock {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      /**
+       *  Bytes in front of the payload, keeping it max_align_t aligned.
+       */
+      static constexpr size_t HEADER = (sizeof(std::atomic<uint32_t>) + 3 * sizeof(void*)
+          + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+      EventBlock(const EventBlock&) = delete;
+      EventBlock& operator=(const EventBlock&) = delete;
+
+      inline void retain()
+      {
+        m_references.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      /**
+       *  Drop a reference, destroying the event with the last one. Safe
+       *  from tasks and ISRs.
+       */
+      inline void release()
+      {
+        if (m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          m_destroy(this);
+        }
+      }
+
+      [[nodiscard]] inline uint32_t references() const
+      {
+        return m_references.load(std::memory_order_relaxed);
+      }
+
+      /**
+       *  The event, as the message base it was created for.
+       */
+      [[nodiscard]] inline const void* message() const
+      {
+        return m_message;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      template<typename Message, size_t PayloadSize, size_t Count>
+      friend class EventPool;
+
+      using Destroy = void (*)(EventBlock* block);
+
+      EventBlock(Destroy destroy, void* pool)
+          :m_destroy(destroy), m_pool(pool)
+      {
+      }
+
+      inline void* payload()
+      {
+        return reinterpret_cast<uint8_t*>(this) + HEADER;
+      }
+
+      std::atomic<uint32_t> m_references{1};
+      Destroy m_destroy;
+      void* m_pool;
+      const void* m_message{nullptr};
+  };
+
+  /**
+   *  Shared, read only reference to a pooled event, seen through the
+   *  event's base class Message. Copying a SharedEvent copies the
+   *  reference, never the event, so one event can be posted to any
+   *  number of receivers.
+   */
+  template<typename Message>
+  class SharedEvent {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      SharedEvent() = default;
+
+      SharedEvent(const SharedEvent& other)
+          :m_block(other.m_block)
+      {
+        if (m_block != nullptr) {
+          m_block->retain();
+        }
+      }
+
+      SharedEvent(SharedEvent&& other) noexcept
+          :m_block(std::exchange(other.m_block, nullptr))
+      {
+      }
+
+      SharedEvent& operator=(SharedEvent other) noexcept
+      {
+        std::swap(m_block, other.m_block);
+        return *this;
+      }
+
+      ~SharedEvent()
+      {
+        if (m_block != nullptr) {
+          m_block->release();
+        }
+      }
+
+      explicit operator bool() const
+      {
+        return m_block != nullptr;
+      }
+
+      const Message& operator*() const
+      {
+        return *static_cast<const Message*>(m_block->message());
+      }
+
+      const Message* operator->() const
+      {
+        return static_cast<const Message*>(m_block->message());
+      }
+
+      /**
+       *  Hand the reference over as a raw block, for transport through a
+       *  queue. adopt() takes it back on the other side.
+       */
+      EventBlock* detach()
+      {
+        return std::exchange(m_block, nullptr);
+      }
+
+      static SharedEvent adopt(EventBlock* block)
+      {
+        return SharedEvent{block};
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      explicit SharedEvent(EventBlock* block)
+          :m_block(block)
+      {
+      }
+
+      EventBlock* m_block{nullptr};
+  };
+
+  /**
+   *  Pool of Count events of up to PayloadSize bytes, all derived from
+   *  Message.
+   *
+   *  make() and makeFromISR() construct an event in a free block and
+   *  return the first reference to it. The block goes back to the pool
+   *  when the last SharedEvent referring to it is destroyed, in whatever
+   *  task or ISR that happens.
+   */
+  template<typename Message, size_t PayloadSize, size_t Count>
+  class EventPool {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      EventPool() = default;
+
+      EventPool(const EventPool&) = delete;
+      EventPool& operator=(const EventPool&) = delete;
+
+      /**
+       *  Construct an event of type T.
+       *
+       *  @return The only reference to it, empty if the pool is exhausted.
+       */
+      template<typename T, typename... Args>
+      SharedEvent<Message> make(Args&&... args)
+      {
+        return construct<T>(m_blocks.allocate(), std::forward<Args>(args)...);
+      }
+
+      template<typename T, typename... Args>
+      SharedEvent<Message> makeFromISR(Args&&... args)
+      {
+        return construct<T>(m_blocks.allocateFromISR(), std::forward<Args>(args)...);
+      }
+
+      [[nodiscard]] BlockPoolStats stats() const
+      {
+        return m_blocks.stats();
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      using Blocks = BlockPool<EventBlock::HEADER + PayloadSize, Count>;
+
+      template<typename T, typename... Args>
+      SharedEvent<Message> construct(void* memory, Args&&... args)
+      {
+        static_assert(std::is_base_of_v<Message, T>, "Events of an EventPool derive from its Message type");
+        static_assert(sizeof(T) <= PayloadSize, "Event does not fit, raise the EventPool PayloadSize");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Event is over aligned");
+
+        if (memory == nullptr) {
+          return {};
+        }
+
+        auto* block = ::new (memory) EventBlock(&destroy<T>, &m_blocks);
+        const T* event = ::new (block->payload()) T(std::forward<Args>(args)...);
+        block->m_message = static_cast<const Message*>(event);
+        return SharedEvent<Message>::adopt(block);
+      }
+
+      template<typename T>
+      static void destroy(EventBlock* block)
+      {
+        std::launder(static_cast<T*>(block->payload()))->~T();
+        void* pool = block->m_pool;
+        block->~EventBlock();
+        static_cast<Blocks*>(pool)->freeFromISR(block);
+      }
+
+      Blocks m_blocks{};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_SHAREDEVENT_HPP_ */
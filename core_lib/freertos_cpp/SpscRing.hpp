@@ -0,0 +1,273 @@
+/*
+ * SpscRing.hpp
+ *
+ *  Lock free single producer / single consumer ring buffer.
+ */
+
+#ifndef LIB_FREERTOS_CPP_SPSCRING_HPP_
+#define LIB_FREERTOS_CPP_SPSCRING_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace freertos {
+
+  /**
+   *  Ring buffer for exactly one producer and one consumer, typically an
+   *  ISR feeding a task.
+   *
+   *  The only shared state is the free running head and tail indices, so
+   *  neither side takes a critical section. A bulk push or pop is at most
+   *  two memcpy calls regardless of how many items are moved.
+   *
+   *  The consumer may block in receive(). It does so by publishing its task
+   *  handle, the producer then sends a task notification once the number of
+   *  items in the ring reaches the watermark. When nobody is waiting the
+   *  producer pays a single atomic load.
+   *
+   *  @note Uses the calling task's notification value while blocked in
+   *        receive(), do not mix with other notification users on that task.
+   */
+  template<typename T, size_t N>
+  class SpscRing {
+
+      static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+      static_assert(std::is_trivially_copyable_v<T>, "SpscRing items are copied with memcpy");
+      static_assert(std::atomic<size_t>::is_always_lock_free, "SpscRing needs lock free indices");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using value_type = T;
+
+      static constexpr size_t capacity = N;
+
+      /**
+       *  @param watermark Number of items that must be available before a
+       *         waiting consumer is woken. Clamped to [1, N].
+       */
+      explicit SpscRing(size_t watermark = 1)
+      {
+        setWatermark(watermark);
+      }
+
+      SpscRing(const SpscRing&) = delete;
+      SpscRing& operator=(const SpscRing&) = delete;
+
+      /**
+       *  Copy as many items as fit into the ring, task context.
+       *
+       *  @param data Items to add.
+       *  @return Number of items written, may be less than data.size().
+       */
+      size_t push(std::span<const T> data)
+      {
+        size_t written = write(data);
+        TaskHandle_t waiter = takeWaiterIfReady();
+        if (waiter != nullptr) {
+          xTaskNotifyGive(waiter);
+        }
+        return written;
+      }
+
+      /**
+       *  Copy as many items as fit into the ring, ISR context.
+       *
+       *  @param data Items to add.
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       *  @return Number of items written, may be less than data.size().
+       */
+      size_t pushFromISR(std::span<const T> data, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        size_t written = write(data);
+        TaskHandle_t waiter = takeWaiterIfReady();
+        if (waiter != nullptr) {
+          vTaskNotifyGiveFromISR(waiter, pxHigherPriorityTaskWoken);
+        }
+        return written;
+      }
+
+      inline bool push(const T& item)
+      {
+        return push(std::span<const T>(&item, 1)) == 1;
+      }
+
+      inline bool pushFromISR(const T& item, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        return pushFromISR(std::span<const T>(&item, 1), pxHigherPriorityTaskWoken) == 1;
+      }
+
+      /**
+       *  Copy up to out.size() items out of the ring without blocking.
+       *  Safe from task or ISR context on the consumer side.
+       *
+       *  @param out Destination for the items.
+       *  @return Number of items read.
+       */
+      size_t pop(std::span<T> out)
+      {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t head = m_head.load(std::memory_order_acquire);
+
+        size_t count = head - tail;
+        if (count > out.size()) {
+          count = out.size();
+        }
+        if (count == 0) {
+          return 0;
+        }
+
+        const size_t index = tail & MASK;
+        const size_t first = count < N - index ? count : N - index;
+        std::memcpy(out.data(), &m_storage[index], first * sizeof(T));
+        std::memcpy(out.data() + first, &m_storage[0], (count - first) * sizeof(T));
+
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+      }
+
+      inline bool pop(T& item)
+      {
+        return pop(std::span<T>(&item, 1)) == 1;
+      }
+
+      /**
+       *  Copy up to out.size() items out of the ring, blocking the calling
+       *  task until at least the watermark is available or the timeout
+       *  expires.
+       *
+       *  @param out Destination for the items.
+       *  @param ticksToWait How long to wait for data.
+       *  @return Number of items read, 0 on timeout.
+       */
+      size_t receive(std::span<T> out, TickType_t ticksToWait = portMAX_DELAY)
+      {
+        if (out.empty()) {
+          return 0;
+        }
+
+        if (ticksToWait != 0 && size() < m_watermark.load(std::memory_order_relaxed)) {
+          TimeOut_t timeOut;
+          vTaskSetTimeOutState(&timeOut);
+
+          // A producer that claimed the handle just before the re-check
+          // below still notifies, so a wakeup can be left over from an
+          // earlier call and only means look again.
+          do {
+            m_waiter.store(xTaskGetCurrentTaskHandle(), std::memory_order_seq_cst);
+
+            // Re-check after publishing ourselves, the producer may have
+            // pushed the last item before it could see the handle.
+            if (size() < m_watermark.load(std::memory_order_relaxed)) {
+              (void) ulTaskNotifyTake(pdTRUE, ticksToWait);
+            }
+
+            m_waiter.store(nullptr, std::memory_order_seq_cst);
+          } while (size() < m_watermark.load(std::memory_order_relaxed)
+                   && xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdFALSE);
+        }
+
+        return pop(out);
+      }
+
+      /**
+       *  Change how many items must be queued before a waiting consumer
+       *  is woken.
+       */
+      void setWatermark(size_t watermark)
+      {
+        if (watermark == 0) {
+          watermark = 1;
+        }
+        if (watermark > N) {
+          watermark = N;
+        }
+        m_watermark.store(watermark, std::memory_order_relaxed);
+      }
+
+      [[nodiscard]] inline size_t size() const
+      {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+      }
+
+      [[nodiscard]] inline size_t spaceAvailable() const
+      {
+        return N - size();
+      }
+
+      inline bool isEmpty() const
+      {
+        return size() == 0;
+      }
+
+      inline bool isFull() const
+      {
+        return size() == N;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      static constexpr size_t MASK = N - 1;
+
+      size_t write(std::span<const T> data)
+      {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+
+        size_t count = N - (head - tail);
+        if (count > data.size()) {
+          count = data.size();
+        }
+        if (count == 0) {
+          return 0;
+        }
+
+        const size_t index = head & MASK;
+        const size_t first = count < N - index ? count : N - index;
+        std::memcpy(&m_storage[index], data.data(), first * sizeof(T));
+        std::memcpy(&m_storage[0], data.data() + first, (count - first) * sizeof(T));
+
+        m_head.store(head + count, std::memory_order_seq_cst);
+        return count;
+      }
+
+      /**
+       *  Claim the waiting consumer if the watermark has been reached.
+       *  The exchange makes sure one wait is answered by one notification.
+       */
+      TaskHandle_t takeWaiterIfReady()
+      {
+        if (m_waiter.load(std::memory_order_seq_cst) == nullptr) {
+          return nullptr;
+        }
+        if (size() < m_watermark.load(std::memory_order_relaxed)) {
+          return nullptr;
+        }
+        return m_waiter.exchange(nullptr, std::memory_order_acq_rel);
+      }
+
+      std::array<T, N> m_storage{};
+      std::atomic<size_t> m_head{0};
+      std::atomic<size_t> m_tail{0};
+      std::atomic<size_t> m_watermark{1};
+      std::atomic<TaskHandle_t> m_waiter{nullptr};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_SPSCRING_HPP_ */
@@ -0,0 +1,187 @@
+/*
+ * Stats.cpp
+ *
+ *  Run time statistics clock, context switch and ISR accounting.
+ */
+
+#include "Stats.hpp"
+
+#include "Critical.hpp"
+#include "TickHook.hpp"
+
+#include "placement.h"
+
+#if defined(__arm__)
+#include CMSIS_device_header
+#else
+#include <atomic>
+#include <chrono>
+#endif
+
+#if (configGENERATE_RUN_TIME_STATS != 1)
+#error "Stats needs configGENERATE_RUN_TIME_STATS and the hooks in FreeRTOSConfig.h"
+#endif
+
+namespace freertos {
+
+  namespace {
+
+    uint32_t contextSwitchCount = 0;
+    TaskHandle_t lastTask = nullptr;
+
+    uint32_t isrCounter = 0;
+    uint64_t isrTotal = 0;
+
+#if defined(__arm__)
+    uint32_t lastCycles = 0;
+    uint64_t extendedCycles = 0;
+#else
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::atomic<uint64_t> advanced{0};
+#endif
+
+#if (configUSE_TICK_HOOK == 1)
+    /**
+     *  Reads the clock once per tick so the 64 bit extension never misses
+     *  a wrap of the hardware counter.
+     */
+    class ClockKeeper : public TickHook {
+      protected:
+        void run() override
+        {
+          (void) Stats::now();
+        }
+    };
+
+    ClockKeeper clockKeeper{};
+#endif
+
+  } // namespace
+
+  void Stats::start()
+  {
+#if (configUSE_TICK_HOOK == 1)
+    clockKeeper.registerTickHook();
+#endif
+  }
+
+  RAMFUNC uint32_t Stats::timestamp()
+  {
+#if defined(__arm__)
+    return DWT->CYCCNT;
+#else
+    return static_cast<uint32_t>(now());
+#endif
+  }
+
+  uint64_t Stats::now()
+  {
+#if defined(__arm__)
+    const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+    const uint32_t cycles = DWT->CYCCNT;
+    extendedCycles += cycles - lastCycles;
+    lastCycles = cycles;
+    const uint64_t value = extendedCycles;
+    CriticalSection::exitFromISR(savedInterruptStatus);
+    return value;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count()) + advanced.load(std::memory_order_relaxed);
+#endif
+  }
+
+  void Stats::advance(uint64_t elapsed)
+  {
+#if defined(__arm__)
+    const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+    const uint32_t cycles = DWT->CYCCNT;
+    extendedCycles += (cycles - lastCycles) + elapsed;
+    lastCycles = cycles;
+    CriticalSection::exitFromISR(savedInterruptStatus);
+#else
+    advanced.fetch_add(elapsed, std::memory_order_relaxed);
+#endif
+  }
+
+  uint32_t Stats::timestampFrequency()
+  {
+#if defined(__arm__)
+    return SystemCoreClock;
+#else
+    return 1000000000;
+#endif
+  }
+
+  uint32_t Stats::contextSwitches()
+  {
+    return contextSwitchCount;
+  }
+
+  uint32_t Stats::isrCount()
+  {
+    const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+    const uint32_t count = isrCounter;
+    CriticalSection::exitFromISR(savedInterruptStatus);
+    return count;
+  }
+
+  uint64_t Stats::isrTime()
+  {
+    const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+    const uint64_t total = isrTotal;
+    CriticalSection::exitFromISR(savedInterruptStatus);
+    return total;
+  }
+
+} // namespace freertos
+
+using namespace freertos;
+
+void freertos_stats_configure_counter(void)
+{
+#if defined(__arm__)
+  CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+#endif
+  (void) Stats::now();
+}
+
+uint32_t freertos_stats_run_time_counter(void)
+{
+  return static_cast<uint32_t>(Stats::now() >> Stats::RUN_TIME_SHIFT);
+}
+
+/**
+ *  Runs inside vTaskSwitchContext() with interrupts masked. The kernel
+ *  calls it on every switch decision, count only actual task changes.
+ */
+void freertos_stats_task_switched_in(void)
+{
+  TaskHandle_t current = xTaskGetCurrentTaskHandle();
+  if (current == lastTask) {
+    return;
+  }
+  lastTask = current;
+  ++contextSwitchCount;
+
+#if (configNUM_THREAD_LOCAL_STORAGE_POINTERS > 0) && defined(configSTATS_TLS_INDEX)
+  const auto switches = reinterpret_cast<uintptr_t>(pvTaskGetThreadLocalStoragePointer(current, configSTATS_TLS_INDEX));
+  vTaskSetThreadLocalStoragePointer(current, configSTATS_TLS_INDEX, reinterpret_cast<void*>(switches + 1));
+#endif
+}
+
+RAMFUNC uint32_t freertos_stats_isr_enter(void)
+{
+  return Stats::timestamp();
+}
+
+RAMFUNC void freertos_stats_isr_exit(uint32_t start)
+{
+  const uint32_t elapsed = Stats::timestamp() - start;
+
+  const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+  ++isrCounter;
+  isrTotal += elapsed;
+  CriticalSection::exitFromISR(savedInterruptStatus);
+}
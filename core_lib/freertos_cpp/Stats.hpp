@@ -0,0 +1,347 @@
+/*
+ * Stats.hpp
+ *
+ *  Run time statistics: per task CPU load, stack high water marks,
+ *  context switches and ISR time.
+ */
+
+#ifndef LIB_FREERTOS_CPP_STATS_HPP_
+#define LIB_FREERTOS_CPP_STATS_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ *  Kernel hooks, declared and wired up in FreeRTOSConfig.h:
+ *
+ *    portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()  freertos_stats_configure_counter()
+ *    portGET_RUN_TIME_COUNTER_VALUE()          freertos_stats_run_time_counter()
+ *    traceTASK_SWITCHED_IN()                   freertos_stats_task_switched_in()
+ *
+ *  FreeRTOSConfig.h also declares freertos_stats_isr_enter() and
+ *  freertos_stats_isr_exit(), which C interrupt handlers running at or
+ *  below configMAX_SYSCALL_INTERRUPT_PRIORITY use to account their time.
+ */
+
+namespace freertos {
+
+  /**
+   *  One task's share of a sampling interval.
+   */
+  struct TaskStats {
+    const char* name;
+    UBaseType_t number;
+    UBaseType_t priority;
+    eTaskState state;
+
+    /**
+     *  Run time in run time counter units. Includes the time spent in
+     *  interrupts that fired while the task was running.
+     */
+    uint32_t runTime;
+
+    /**
+     *  runTime in tenths of a percent of the interval.
+     */
+    uint16_t cpuPermille;
+
+    /**
+     *  Least amount of stack, in words, that has been free since the task
+     *  started.
+     */
+    uint16_t stackHighWaterMark;
+
+    /**
+     *  Times the task was switched in, 0 without thread local storage.
+     */
+    uint32_t contextSwitches;
+  };
+
+  /**
+   *  System wide figures of a sampling interval.
+   */
+  struct SystemStats {
+    /**
+     *  Length of the interval in run time counter units.
+     */
+    uint32_t elapsed;
+
+    uint32_t contextSwitches;
+
+    /**
+     *  Number and total duration, in timestamp units, of the interrupts
+     *  wrapped with Stats::IsrScope or freertos_stats_isr_enter/exit.
+     */
+    uint32_t isrCount;
+    uint32_t isrTime;
+    uint16_t isrPermille;
+
+    size_t taskCount;
+  };
+
+  /**
+   *  Clock and counters behind the kernel run time statistics.
+   *
+   *  On Cortex-M the clock is the DWT cycle counter, extended to 64 bits
+   *  in software. The kernel's 32 bit run time counter is that value
+   *  shifted down by RUN_TIME_SHIFT, which keeps it from wrapping for
+   *  about 25 minutes at 180 MHz. On the host build a monotonic clock in
+   *  nanoseconds takes its place.
+   *
+   *  The 64 bit extension only works if the counter is read at least once
+   *  per wrap of the 32 bit hardware counter. start() registers a tick
+   *  hook that guarantees this when configUSE_TICK_HOOK is enabled.
+   */
+  class Stats {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+#if defined(__arm__)
+      static constexpr uint32_t RUN_TIME_SHIFT = 6;
+#else
+      static constexpr uint32_t RUN_TIME_SHIFT = 10;
+#endif
+
+      Stats() = delete;
+
+      /**
+       *  Register the tick hook keeping the clock extension alive. Call
+       *  once, before or after the scheduler has started.
+       */
+      static void start();
+
+      /**
+       *  Raw 32 bit timestamp, CPU cycles on target. Cheap enough for
+       *  timing short sections, wraps after a few seconds.
+       */
+      static uint32_t timestamp();
+
+      /**
+       *  Timestamp extended to 64 bits.
+       */
+      static uint64_t now();
+
+      /**
+       *  Move now() on by time the clock did not see. The cycle counter
+       *  stops while the core sleeps in WFI with its clock gated, tickless
+       *  idle hands the slept time back here so the idle task is still
+       *  charged with it.
+       *
+       *  @param elapsed Time in timestamp units.
+       */
+      static void advance(uint64_t elapsed);
+
+      /**
+       *  Timestamp ticks per second.
+       */
+      static uint32_t timestampFrequency();
+
+      /**
+       *  Run time counter ticks per second.
+       */
+      static inline uint32_t runTimeFrequency()
+      {
+        return timestampFrequency() >> RUN_TIME_SHIFT;
+      }
+
+      /**
+       *  Context switches since the scheduler started.
+       */
+      static uint32_t contextSwitches();
+
+      /**
+       *  Interrupts accounted since boot and their total duration in
+       *  timestamp units.
+       */
+      static uint32_t isrCount();
+      static uint64_t isrTime();
+
+      /**
+       *  Accounts the lifetime of the object as ISR time. Declare one at
+       *  the top of an interrupt handler.
+       *
+       *  @note Time of a nested interrupt is counted by both handlers.
+       */
+      class IsrScope {
+        public:
+          IsrScope()
+              :m_start(freertos_stats_isr_enter())
+          {
+          }
+
+          ~IsrScope()
+          {
+            freertos_stats_isr_exit(m_start);
+          }
+
+          IsrScope(const IsrScope&) = delete;
+          IsrScope& operator=(const IsrScope&) = delete;
+
+        private:
+          uint32_t m_start;
+      };
+  };
+
+  /**
+   *  Sampler for up to MaxTasks tasks.
+   *
+   *  Every call to sample() reports what happened since the previous one,
+   *  the first call covers the time since the scheduler started. Keep the
+   *  object around between samples, it remembers the previous counters.
+   *  The object is fairly large, place it in static storage rather than
+   *  on a task stack.
+   */
+  template<size_t MaxTasks>
+  class StatsSnapshot {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      /**
+       *  Take a new sample.
+       *
+       *  @return false if there are more than MaxTasks tasks, the previous
+       *          sample is kept in that case.
+       */
+      bool sample()
+      {
+        uint32_t total = 0;
+        const UBaseType_t count = uxTaskGetSystemState(m_status.data(), MaxTasks, &total);
+        if (count == 0) {
+          return false;
+        }
+
+        // The kernel only adds to a task's counter when it is switched
+        // out, so the calling task's entry lags behind. Give it whatever
+        // the others did not use.
+        uint32_t others = 0;
+        for (size_t i = 0; i < count; ++i) {
+          if (m_status[i].eCurrentState != eRunning) {
+            others += m_status[i].ulRunTimeCounter;
+          }
+        }
+        for (size_t i = 0; i < count; ++i) {
+          if (m_status[i].eCurrentState == eRunning) {
+            m_status[i].ulRunTimeCounter = total - others;
+          }
+        }
+
+        const uint32_t elapsed = total - m_lastTotal;
+        for (size_t i = 0; i < count; ++i) {
+          const TaskStatus_t& status = m_status[i];
+          const Counters previous = findPrevious(status.xTaskNumber);
+          const uint32_t switches = taskSwitches(status.xHandle);
+
+          TaskStats& task = m_tasks[i];
+          task.name = status.pcTaskName;
+          task.number = status.xTaskNumber;
+          task.priority = status.uxCurrentPriority;
+          task.state = status.eCurrentState;
+          task.runTime = status.ulRunTimeCounter - previous.runTime;
+          task.cpuPermille = permille(task.runTime, elapsed);
+          task.stackHighWaterMark = status.usStackHighWaterMark;
+          task.contextSwitches = switches - previous.switches;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+          m_previous[i] = {m_status[i].xTaskNumber, m_status[i].ulRunTimeCounter, taskSwitches(m_status[i].xHandle)};
+        }
+        m_count = count;
+
+        const uint32_t switches = Stats::contextSwitches();
+        const uint32_t isrCount = Stats::isrCount();
+        const uint64_t isrTime = Stats::isrTime();
+
+        m_system.elapsed = elapsed;
+        m_system.contextSwitches = switches - m_lastSwitches;
+        m_system.isrCount = isrCount - m_lastIsrCount;
+        m_system.isrTime = static_cast<uint32_t>(isrTime - m_lastIsrTime);
+        m_system.isrPermille = permille(m_system.isrTime, static_cast<uint64_t>(elapsed) << Stats::RUN_TIME_SHIFT);
+        m_system.taskCount = count;
+
+        m_lastTotal = total;
+        m_lastSwitches = switches;
+        m_lastIsrCount = isrCount;
+        m_lastIsrTime = isrTime;
+        return true;
+      }
+
+      std::span<const TaskStats> tasks() const
+      {
+        return {m_tasks.data(), m_count};
+      }
+
+      const SystemStats& system() const
+      {
+        return m_system;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      struct Counters {
+        UBaseType_t number;
+        uint32_t runTime;
+        uint32_t switches;
+      };
+
+      Counters findPrevious(UBaseType_t number) const
+      {
+        for (size_t i = 0; i < m_count; ++i) {
+          if (m_previous[i].number == number) {
+            return m_previous[i];
+          }
+        }
+        return {number, 0, 0};
+      }
+
+      static uint32_t taskSwitches(TaskHandle_t handle)
+      {
+#if (configNUM_THREAD_LOCAL_STORAGE_POINTERS > 0) && defined(configSTATS_TLS_INDEX)
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(
+            pvTaskGetThreadLocalStoragePointer(handle, configSTATS_TLS_INDEX)));
+#else
+        (void) handle;
+        return 0;
+#endif
+      }
+
+      static uint16_t permille(uint64_t part, uint64_t whole)
+      {
+        if (whole == 0) {
+          return 0;
+        }
+        const uint64_t value = part * 1000 / whole;
+        return static_cast<uint16_t>(value > 1000 ? 1000 : value);
+      }
+
+      std::array<TaskStatus_t, MaxTasks> m_status{};
+      std::array<TaskStats, MaxTasks> m_tasks{};
+      std::array<Counters, MaxTasks> m_previous{};
+      size_t m_count{0};
+      SystemStats m_system{};
+
+      uint32_t m_lastTotal{0};
+      uint32_t m_lastSwitches{0};
+      uint32_t m_lastIsrCount{0};
+      uint64_t m_lastIsrTime{0};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_STATS_HPP_ */
@@ -0,0 +1,509 @@
+/*
+ * System.hpp
+ *
+ *  Compile time description of the application's tasks, queues and
+ *  stream buffers, with their RAM laid out and checked at build time.
+ */
+
+#ifndef LIB_FREERTOS_CPP_SYSTEM_HPP_
+#define LIB_FREERTOS_CPP_SYSTEM_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Queue.hpp"
+#include "StreamBuffer.hpp"
+#include "Task.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ *  Define the stack and buffer storage of a System and place its RAM map
+ *  in the non allocated .ram_map section of the ELF, from where the build
+ *  dumps it next to the firmware. Use exactly once, at global scope in a
+ *  source file, with the name of a System type.
+ *
+ *  The storage is defined here rather than in the class template because
+ *  GCC drops the section attribute of template static members.
+ */
+#if(configSUPPORT_STATIC_ALLOCATION == 1)
+#define FREERTOS_SYSTEM_DEFINE(system_type)                                                              \
+  template<> alignas(freertos::system_detail::STACK_ALIGNMENT) __attribute__((section(".bss.task_stacks"))) \
+  system_type::StackArray system_type::stacks{};                                                         \
+  template<> alignas(freertos::system_detail::STACK_ALIGNMENT) __attribute__((section(".bss.rtos_buffers"))) \
+  system_type::BufferArray system_type::buffers{};                                                       \
+  __attribute__((section(".ram_map"), used)) static constexpr auto freertos_system_ram_map_ = system_type::ramMap()
+#else
+#define FREERTOS_SYSTEM_DEFINE(system_type) \
+  __attribute__((section(".ram_map"), used)) static constexpr auto freertos_system_ram_map_ = system_type::ramMap()
+#endif
+
+namespace freertos {
+
+  /**
+   *  String literal usable as a template argument, names an object of a
+   *  System.
+   */
+  template<size_t N>
+  struct SystemName {
+    constexpr SystemName(const char (&text)[N])
+    {
+      std::copy_n(text, N, value);
+    }
+
+    constexpr std::string_view view() const
+    {
+      return {value, N - 1};
+    }
+
+    char value[N]{};
+  };
+
+  enum class SystemObjectKind : uint8_t {
+    Task,
+    Queue,
+    StreamBuffer
+  };
+
+  /**
+   *  One line of the RAM map.
+   */
+  struct SystemEntry {
+    std::string_view name;
+    SystemObjectKind kind;
+    uint8_t priority;
+
+    /**
+     *  Stack words, queue depth or stream buffer size in bytes.
+     */
+    size_t count;
+
+    /**
+     *  Queue item size, 0 for the others.
+     */
+    size_t itemSize;
+
+    /**
+     *  Stack or storage buffer bytes and their offset in .task_stacks or
+     *  .rtos_buffers.
+     */
+    size_t storageBytes;
+    size_t storageOffset;
+
+    /**
+     *  Size of the C++ object, which holds the kernel control block.
+     */
+    size_t objectBytes;
+  };
+
+  /**
+   *  A task of type TaskType, which derives from Task and is constructible
+   *  the way Task is.
+   */
+  template<SystemName Name, class TaskType, size_t StackWords, uint8_t Priority = Task::DEFAULT_PRIORITY>
+  struct TaskSpec {
+      static_assert(std::is_base_of_v<Task, TaskType>, "TaskType must derive from freertos::Task");
+      static_assert(StackWords >= configMINIMAL_STACK_SIZE, "Stack is smaller than configMINIMAL_STACK_SIZE");
+      static_assert(StackWords <= UINT16_MAX, "Task takes a 16 bit stack size");
+      static_assert(Priority < configMAX_PRIORITIES, "Priority must be below configMAX_PRIORITIES");
+
+      using object_type = TaskType;
+
+      static constexpr SystemEntry entry{Name.view(), SystemObjectKind::Task, Priority, StackWords, 0,
+                                         StackWords * sizeof(StackType_t), 0, sizeof(TaskType)};
+
+      #if(configSUPPORT_STATIC_ALLOCATION == 1)
+      static TaskType construct(StackType_t* stack)
+      {
+        return TaskType(Name.value, stack, StackWords, Priority);
+      }
+      #else
+      static TaskType construct()
+      {
+        return TaskType(Name.value, StackWords, Priority);
+      }
+      #endif
+  };
+
+  /**
+   *  A Queue of Depth items of type T.
+   */
+  template<SystemName Name, typename T, UBaseType_t Depth>
+  struct QueueSpec {
+      static_assert(std::is_trivially_copyable_v<T>, "FreeRTOS queues memcpy their items, T must be trivially copyable");
+      static_assert(Depth > 0, "Queue must hold at least one item");
+
+      using object_type = Queue;
+
+      static constexpr SystemEntry entry{Name.view(), SystemObjectKind::Queue, 0, Depth, sizeof(T),
+                                         Depth * sizeof(T), 0, sizeof(Queue)};
+
+      #if(configSUPPORT_STATIC_ALLOCATION == 1)
+      static Queue construct(uint8_t* buffer)
+      {
+        return Queue(Depth, sizeof(T), buffer);
+      }
+      #else
+      static Queue construct()
+      {
+        return Queue(Depth, sizeof(T));
+      }
+      #endif
+  };
+
+  /**
+   *  A StreamBuffer of Bytes bytes.
+   */
+  template<SystemName Name, size_t Bytes, size_t TriggerLevel = 1>
+  struct StreamBufferSpec {
+      static_assert(TriggerLevel > 0 && TriggerLevel <= Bytes, "Trigger level must be within the buffer");
+
+      using object_type = StreamBuffer;
+
+      // The kernel keeps one byte free to tell a full buffer from an empty one.
+      static constexpr SystemEntry entry{Name.view(), SystemObjectKind::StreamBuffer, 0, Bytes, 0,
+                                         Bytes + 1, 0, sizeof(StreamBuffer)};
+
+      #if(configSUPPORT_STATIC_ALLOCATION == 1)
+      static StreamBuffer construct(uint8_t* buffer)
+      {
+        return StreamBuffer(Bytes, TriggerLevel, buffer);
+      }
+      #else
+      static StreamBuffer construct()
+      {
+        return StreamBuffer(Bytes, TriggerLevel);
+      }
+      #endif
+  };
+
+  namespace system_detail {
+
+    static constexpr size_t STACK_ALIGNMENT = 8;
+    static constexpr size_t BUFFER_ALIGNMENT = 4;
+
+    constexpr size_t alignUp(size_t value, size_t alignment)
+    {
+      return (value + alignment - 1) / alignment * alignment;
+    }
+
+    template<size_t N>
+    constexpr std::array<SystemEntry, N> layout(std::array<SystemEntry, N> entries)
+    {
+      size_t stackOffset = 0;
+      size_t bufferOffset = 0;
+      for (SystemEntry& entry : entries) {
+        if (entry.kind == SystemObjectKind::Task) {
+          entry.storageOffset = stackOffset;
+          stackOffset += alignUp(entry.storageBytes, STACK_ALIGNMENT);
+        } else {
+          entry.storageOffset = bufferOffset;
+          bufferOffset += alignUp(entry.storageBytes, BUFFER_ALIGNMENT);
+        }
+      }
+      return entries;
+    }
+
+    template<size_t N>
+    constexpr size_t sectionBytes(const std::array<SystemEntry, N>& entries, bool stacks)
+    {
+      size_t total = 0;
+      for (const SystemEntry& entry : entries) {
+        if ((entry.kind == SystemObjectKind::Task) == stacks) {
+          total += alignUp(entry.storageBytes, stacks ? STACK_ALIGNMENT : BUFFER_ALIGNMENT);
+        }
+      }
+      return total;
+    }
+
+    template<size_t N>
+    constexpr size_t objectBytes(const std::array<SystemEntry, N>& entries)
+    {
+      size_t total = 0;
+      for (const SystemEntry& entry : entries) {
+        total += entry.objectBytes;
+      }
+      return total;
+    }
+
+    template<size_t N>
+    constexpr size_t find(const std::array<SystemEntry, N>& entries, std::string_view name)
+    {
+      for (size_t i = 0; i < N; ++i) {
+        if (entries[i].name == name) {
+          return i;
+        }
+      }
+      return N;
+    }
+
+    template<size_t N>
+    constexpr bool uniqueNames(const std::array<SystemEntry, N>& entries)
+    {
+      for (size_t i = 0; i < N; ++i) {
+        if (find(entries, entries[i].name) != i) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /**
+     *  Fixed capacity text builder for the RAM map.
+     */
+    template<size_t Capacity>
+    struct MapText {
+      std::array<char, Capacity> text{};
+      size_t length{0};
+
+      constexpr void put(char c)
+      {
+        if (length < Capacity) {
+          text[length++] = c;
+        }
+      }
+
+      constexpr void put(std::string_view s, size_t width = 0)
+      {
+        for (char c : s.substr(0, width != 0 ? width - 1 : s.size())) {
+          put(c);
+        }
+        for (size_t i = s.size(); i < width; ++i) {
+          put(' ');
+        }
+        if (width != 0 && s.size() >= width) {
+          put(' ');
+        }
+      }
+
+      constexpr void number(size_t value, size_t width = 0, size_t base = 10)
+      {
+        std::array<char, 20> digits{};
+        size_t count = 0;
+        do {
+          digits[count++] = "0123456789abcdef"[value % base];
+          value /= base;
+        } while (value != 0);
+
+        for (size_t i = count; i < width; ++i) {
+          put(base == 16 ? '0' : ' ');
+        }
+        while (count > 0) {
+          put(digits[--count]);
+        }
+      }
+    };
+
+    constexpr std::string_view kindName(SystemObjectKind kind)
+    {
+      switch (kind) {
+        case SystemObjectKind::Task:
+          return "task";
+        case SystemObjectKind::Queue:
+          return "queue";
+        case SystemObjectKind::StreamBuffer:
+          return "stream";
+        default:
+          return "?";
+      }
+    }
+
+    static constexpr size_t MAP_LINE_LENGTH = 96;
+
+    template<size_t N>
+    constexpr MapText<(N + 4) * MAP_LINE_LENGTH> render(const std::array<SystemEntry, N>& entries, size_t budget)
+    {
+      MapText<(N + 4) * MAP_LINE_LENGTH> map{};
+      const size_t stacks = sectionBytes(entries, true);
+      const size_t buffers = sectionBytes(entries, false);
+      const size_t objects = objectBytes(entries);
+      const size_t total = stacks + buffers + objects;
+
+      map.put("kind    name              prio  size            section        offset    bytes   object\n");
+      for (const SystemEntry& entry : entries) {
+        map.put(kindName(entry.kind), 8);
+        map.put(entry.name, 18);
+
+        if (entry.kind == SystemObjectKind::Task) {
+          map.number(entry.priority, 4);
+          map.put("  ");
+        } else {
+          map.put("   -  ");
+        }
+
+        MapText<16> size{};
+        size.number(entry.count);
+        if (entry.kind == SystemObjectKind::Task) {
+          size.put(" words");
+        } else if (entry.kind == SystemObjectKind::Queue) {
+          size.put(" x ");
+          size.number(entry.itemSize);
+          size.put(" B");
+        } else {
+          size.put(" B");
+        }
+        map.put({size.text.data(), size.length}, 16);
+
+        map.put(entry.kind == SystemObjectKind::Task ? ".task_stacks" : ".rtos_buffers", 15);
+        map.put("0x");
+        map.number(entry.storageOffset, 5, 16);
+        map.number(entry.storageBytes, 9);
+        map.number(entry.objectBytes, 9);
+        map.put('\n');
+      }
+
+      map.put("stacks ");
+      map.number(stacks);
+      map.put(" B, buffers ");
+      map.number(buffers);
+      map.put(" B, objects ");
+      map.number(objects);
+      map.put(" B, total ");
+      map.number(total);
+      map.put(" of ");
+      map.number(budget);
+      map.put(" B (");
+      map.number(budget != 0 ? total * 100 / budget : 0);
+      map.put("%)\n");
+      return map;
+    }
+
+  } // namespace system_detail
+
+  /**
+   *  The application's kernel objects, described once as a list of
+   *  TaskSpec, QueueSpec and StreamBufferSpec.
+   *
+   *  Every task stack is laid out in one array in the .task_stacks linker
+   *  section, every queue and stream buffer storage area in one array in
+   *  .rtos_buffers, at offsets fixed at compile time. Both arrays are
+   *  defined by FREERTOS_SYSTEM_DEFINE. The objects
+   *  themselves, which carry the kernel control blocks, are ordinary
+   *  globals. The build fails if stacks, storage and objects together
+   *  exceed BudgetBytes, and ramMap() describes the result.
+   *
+   *  Objects are constructed during static initialisation, in no
+   *  particular order among themselves, so their constructors must not
+   *  depend on each other. Only the objects the application reaches
+   *  through get() or startTasks() are instantiated.
+   *
+   *  @note Neither section is cleared at startup. The kernel fills new
+   *        stacks itself and queue storage is never read before it is
+   *        written.
+   */
+  template<size_t BudgetBytes, class... Specs>
+  class System {
+
+      static constexpr size_t COUNT = sizeof...(Specs);
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      static constexpr std::array<SystemEntry, COUNT> entries = system_detail::layout<COUNT>({Specs::entry...});
+
+      static constexpr size_t stackBytes = system_detail::sectionBytes(entries, true);
+      static constexpr size_t bufferBytes = system_detail::sectionBytes(entries, false);
+      static constexpr size_t objectBytes = system_detail::objectBytes(entries);
+      static constexpr size_t totalBytes = stackBytes + bufferBytes + objectBytes;
+
+      static_assert(system_detail::uniqueNames(entries), "Every System object needs a unique name");
+      static_assert(totalBytes <= BudgetBytes, "Tasks, queues and stream buffers exceed the RAM budget");
+
+      System() = delete;
+
+      /**
+       *  The object called Name.
+       */
+      template<SystemName Name>
+      static inline auto& get()
+      {
+        constexpr size_t index = system_detail::find(entries, Name.view());
+        static_assert(index < COUNT, "No System object has that name");
+        return object<index>;
+      }
+
+      /**
+       *  Start every task, in the order they are listed.
+       */
+      static void startTasks()
+      {
+        startTasks(std::make_index_sequence<COUNT>{});
+      }
+
+      /**
+       *  The RAM map as text, see FREERTOS_SYSTEM_DEFINE.
+       */
+      static constexpr auto ramMap()
+      {
+        constexpr auto map = system_detail::render(entries, BudgetBytes);
+        std::array<char, map.length> text{};
+        std::copy_n(map.text.begin(), map.length, text.begin());
+        return text;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      template<size_t I>
+      using spec = std::tuple_element_t<I, std::tuple<Specs...>>;
+
+      template<size_t... I>
+      static void startTasks(std::index_sequence<I...>)
+      {
+        (startTask<I>(), ...);
+      }
+
+      template<size_t I>
+      static void startTask()
+      {
+        if constexpr (entries[I].kind == SystemObjectKind::Task) {
+          if (!object<I>.start(nullptr)) {
+            configASSERT(!"System Task Start Failed");
+          }
+        }
+      }
+
+      #if(configSUPPORT_STATIC_ALLOCATION == 1)
+      using StackArray = std::array<StackType_t, stackBytes / sizeof(StackType_t)>;
+      using BufferArray = std::array<uint8_t, bufferBytes>;
+
+      /**
+       *  Defined by FREERTOS_SYSTEM_DEFINE.
+       */
+      alignas(system_detail::STACK_ALIGNMENT) static StackArray stacks;
+      alignas(system_detail::STACK_ALIGNMENT) static BufferArray buffers;
+
+      template<size_t I>
+      static inline auto storage()
+      {
+        if constexpr (entries[I].kind == SystemObjectKind::Task) {
+          return stacks.data() + entries[I].storageOffset / sizeof(StackType_t);
+        } else {
+          return buffers.data() + entries[I].storageOffset;
+        }
+      }
+
+      template<size_t I>
+      static inline typename spec<I>::object_type object = spec<I>::construct(storage<I>());
+      #else
+      template<size_t I>
+      static inline typename spec<I>::object_type object = spec<I>::construct();
+      #endif
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_SYSTEM_HPP_ */
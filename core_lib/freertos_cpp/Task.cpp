@@ -94,6 +94,10 @@ namespace freertos {
   void Task::taskFunctionAdapter(void* pvParameters)
   {
     Task* thread = static_cast<Task*>(pvParameters);
+
+    // A task with a higher priority than its creator runs before
+    // start() has stored the handle, make it valid before run().
+    thread->m_handle = xTaskGetCurrentTaskHandle();
     thread->run();
 
 #if (INCLUDE_vTaskDelete == 1)
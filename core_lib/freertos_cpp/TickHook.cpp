@@ -1,28 +1,49 @@
 #include "TickHook.hpp"
 
-#if (configUSE_TICK_HOOK == 0)
+#if (configUSE_TICK_HOOK == 1)
 
-using namespace std;
 using namespace freertos;
 
-list<TickHook *> TickHook::callbacks;
+TickHook *TickHook::head = nullptr;
+
+
+/**
+ *  Timestamp used for the per hook accounting.
+ */
+static inline uint32_t hookTimestamp() {
+#if (configGENERATE_RUN_TIME_STATS == 1)
+  const uint32_t now = portGET_RUN_TIME_COUNTER_VALUE();
+  return now;
+#else
+  return 0;
+#endif
+}
 
 
 TickHook::TickHook()
-    : enabled(true) {
+    : next(nullptr), registered(false), enabled(true), accounting{} {
 }
 
 
 TickHook::~TickHook() {
   taskENTER_CRITICAL();
-  callbacks.remove(this);
+  for (TickHook **link = &head; *link != nullptr; link = &(*link)->next) {
+    if (*link == this) {
+      *link = next;
+      break;
+    }
+  }
   taskEXIT_CRITICAL();
 }
 
 
 void TickHook::registerTickHook() {
   taskENTER_CRITICAL();
-  callbacks.push_front(this);
+  if (!registered) {
+    next = head;
+    head = this;
+    registered = true;
+  }
   taskEXIT_CRITICAL();
 }
 
@@ -41,18 +62,41 @@ void TickHook::enable() {
 }
 
 
+TickHookStats TickHook::stats() const {
+  taskENTER_CRITICAL();
+  TickHookStats snapshot = accounting;
+  taskEXIT_CRITICAL();
+  return snapshot;
+}
+
+
+void TickHook::resetStats() {
+  taskENTER_CRITICAL();
+  accounting = {};
+  taskEXIT_CRITICAL();
+}
+
+
 /**
  *  We are a friend of the Tick class, which makes this much simplier.
  */
 void vApplicationTickHook(void) {
-  for (list<TickHook *>::iterator it = TickHook::callbacks.begin();
-       it != TickHook::callbacks.end();
-       ++it) {
-
-    TickHook *tickHookObject = *it;
+  for (TickHook *tickHookObject = TickHook::head;
+       tickHookObject != nullptr;
+       tickHookObject = tickHookObject->next) {
 
     if (tickHookObject->enabled) {
+      const uint32_t start = hookTimestamp();
       tickHookObject->run();
+      const uint32_t elapsed = hookTimestamp() - start;
+
+      TickHookStats &accounting = tickHookObject->accounting;
+      accounting.runs++;
+      accounting.lastTime = elapsed;
+      accounting.totalTime += elapsed;
+      if (elapsed > accounting.maxTime) {
+        accounting.maxTime = elapsed;
+      }
     }
   }
 }
@@ -1,11 +1,12 @@
-#ifndef LIB_FREERTOS_CPP_READ_WRITE_LOCK_HPP_
-#define LIB_FREERTOS_CPP_READ_WRITE_LOCK_HPP_
+#ifndef LIB_FREERTOS_CPP_TICK_HOOK_HPP_
+#define LIB_FREERTOS_CPP_TICK_HOOK_HPP_
 
 #include "FreeRTOS.h"
 #include "task.h"
-#include <list>
 
-#if (configUSE_TICK_HOOK == 0)
+#include <cstdint>
+
+#if (configUSE_TICK_HOOK == 1)
 
 /**
  *  FreeRTOS expects this function to exist and requires it to be 
@@ -15,6 +16,35 @@ extern "C" void vApplicationTickHook(void);
 
 namespace freertos {
 
+/**
+ *  Execution time accounting of a single tick hook.
+ *
+ *  Times are in units of portGET_RUN_TIME_COUNTER_VALUE(), so they are
+ *  only collected when configGENERATE_RUN_TIME_STATS is enabled. The
+ *  run count is always maintained.
+ */
+  struct TickHookStats {
+    /**
+     *  Number of times run() was called.
+     */
+    uint32_t runs;
+
+    /**
+     *  Duration of the most recent run.
+     */
+    uint32_t lastTime;
+
+    /**
+     *  Longest run seen since the last reset.
+     */
+    uint32_t maxTime;
+
+    /**
+     *  Sum of all runs since the last reset.
+     */
+    uint64_t totalTime;
+  };
+
 /**
  *  Wrapper class for Tick hooks, functions you want to run within 
  *  the tick ISR. 
@@ -27,6 +57,10 @@ namespace freertos {
  *  You can register multiple hooks with this class. The order of 
  *  execution should not be assumed. All tick hooks will execute 
  *  every tick.
+ *
+ *  Registered hooks form an intrusive singly linked list through the
+ *  hook objects themselves, registering never allocates and takes
+ *  constant time.
  */
   class TickHook {
 
@@ -47,6 +81,9 @@ namespace freertos {
      */
     virtual ~TickHook();
 
+    TickHook(const TickHook&) = delete;
+    TickHook& operator=(const TickHook&) = delete;
+
     /**
      *  After this is called your run routine will execute in the
      *  Tick ISR. This registration cannot be done in the base class
@@ -55,6 +92,7 @@ namespace freertos {
      *  @note Immedately after you call this function, your TickHook
      *  run() method will run, perhaps before you even return from this
      *  call. You "must" be ready to run before you call register().
+     *  Registering an already registered hook does nothing.
      */
     void registerTickHook();
 
@@ -70,6 +108,16 @@ namespace freertos {
      */
     void enable();
 
+    /**
+     *  Snapshot of this hook's execution time accounting.
+     */
+    TickHookStats stats() const;
+
+    /**
+     *  Clear this hook's execution time accounting.
+     */
+    void resetStats();
+
 
     /////////////////////////////////////////////////////////////////////////
     //
@@ -92,16 +140,30 @@ namespace freertos {
     /////////////////////////////////////////////////////////////////////////
     private:
     /**
-     *  List of Tick Hook callbacks that are executed in the
-     *  Tick ISR.
+     *  First Tick Hook of the list executed in the Tick ISR.
      */
-    static std::list<TickHook *> callbacks;
+    static TickHook *head;
+
+    /**
+     *  Next Tick Hook in the list, nullptr for the last one.
+     */
+    TickHook *next;
+
+    /**
+     *  Is this hook linked into the list?
+     */
+    bool registered;
 
     /**
      *  Should the tick hook run?
      */
     bool enabled;
 
+    /**
+     *  Execution time accounting, updated from the Tick ISR.
+     */
+    TickHookStats accounting;
+
     /**
      *  Allow the global vApplicationTickHook() function access
      *  to the internals of this class. This simplifies the overall
@@ -0,0 +1,216 @@
+/*
+ * TicklessIdle.hpp
+ *
+ *  Tick suppression for the idle task, independent of the timer
+ *  hardware.
+ */
+
+#ifndef LIB_FREERTOS_CPP_TICKLESSIDLE_HPP_
+#define LIB_FREERTOS_CPP_TICKLESSIDLE_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <cstdint>
+
+namespace freertos {
+
+  /**
+   *  What tick suppression achieved since boot.
+   */
+  struct TicklessStats {
+    /**
+     *  Times the idle task went to sleep with the tick stopped.
+     */
+    uint32_t sleeps;
+
+    /**
+     *  Sleeps abandoned because a task became ready in the meantime.
+     */
+    uint32_t aborted;
+
+    /**
+     *  Sleeps ended by another interrupt before the wake-up timer.
+     */
+    uint32_t earlyWakeups;
+
+    /**
+     *  Tick periods slept through and accounted to the kernel at once.
+     *  Those of sleeps ended by the wake-up timer include the one its
+     *  interrupt counted.
+     */
+    uint32_t ticksSuppressed;
+  };
+
+#if (configUSE_TICKLESS_IDLE != 0)
+
+  /**
+   *  Kernel side of TicklessIdle, the real FreeRTOS calls.
+   */
+  struct TicklessKernel {
+    static inline bool abortSleep()
+    {
+      return eTaskConfirmSleepModeStatus() == eAbortSleep;
+    }
+
+    static inline void stepTick(TickType_t ticks)
+    {
+      vTaskStepTick(ticks);
+    }
+
+    static inline void preSleep(TickType_t& idleTime)
+    {
+      configPRE_SLEEP_PROCESSING(idleTime);
+      (void) idleTime;
+    }
+
+    static inline void postSleep(TickType_t& idleTime)
+    {
+      configPOST_SLEEP_PROCESSING(idleTime);
+      (void) idleTime;
+    }
+  };
+
+#endif
+
+  /**
+   *  The body of portSUPPRESS_TICKS_AND_SLEEP(), written against a timer
+   *  interface instead of the SysTick registers so the same code runs on
+   *  the target and against a simulated timer on the host.
+   *
+   *  Timebase provides static functions, all called with the scheduler
+   *  suspended and, between disableInterrupts() and enableInterrupts(),
+   *  with interrupts masked:
+   *
+   *    uint32_t countsPerTick()        timer counts in one tick period
+   *    uint32_t maxSleepCounts()       longest one shot the timer can do
+   *    uint32_t stoppedCompensation()  counts lost each time the timer
+   *                                    is stopped and started again
+   *    uint32_t stopTick()             stop every periodic tick source,
+   *                                    return the counts left until the
+   *                                    tick that was due next
+   *    void startWakeup(uint32_t n)    one shot interrupt after n counts,
+   *                                    which the kernel takes as a tick
+   *    uint32_t stopWakeup(bool& expired)
+   *                                    stop it, return the counts since
+   *                                    startWakeup(), which can be more
+   *                                    than n when it expired
+   *    void startTick(uint32_t n, TickType_t slept)
+   *                                    restart the periodic ticks, the
+   *                                    first one after n counts, and
+   *                                    account slept ticks to any other
+   *                                    tick source that was stopped
+   *    void disableInterrupts(), enableInterrupts(), waitForInterrupt()
+   *
+   *  Kernel is TicklessKernel on the target and a model of the kernel in
+   *  the host simulation.
+   */
+  template<class Timebase, class Kernel>
+  class TicklessIdle {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      TicklessIdle() = delete;
+
+      /**
+       *  Sleep for up to expectedIdleTime ticks, or until an interrupt.
+       */
+      static void sleep(TickType_t expectedIdleTime)
+      {
+        const uint32_t countsPerTick = Timebase::countsPerTick();
+        const uint32_t compensation = Timebase::stoppedCompensation();
+
+        const TickType_t maxTicks = Timebase::maxSleepCounts() / countsPerTick;
+        if (expectedIdleTime > maxTicks) {
+          expectedIdleTime = maxTicks;
+        }
+
+        const uint32_t untilTick = Timebase::stopTick();
+
+        // Interrupts stay masked at the core only, so a pending one still
+        // ends the wait but does not run until the timer is sorted out.
+        Timebase::disableInterrupts();
+
+        if (Kernel::abortSleep()) {
+          Timebase::startTick(untilTick, 0);
+          Timebase::enableInterrupts();
+          ++s_stats.aborted;
+          return;
+        }
+
+        // Wake at the tick boundary expectedIdleTime ticks on, less the
+        // counts lost while the timer was stopped.
+        uint32_t wakeCounts = untilTick + countsPerTick * (expectedIdleTime - 1);
+        if (wakeCounts > compensation) {
+          wakeCounts -= compensation;
+        }
+        Timebase::startWakeup(wakeCounts);
+
+        // The pre sleep hook may clear its copy to say it waited itself.
+        TickType_t modifiableIdleTime = expectedIdleTime;
+        Kernel::preSleep(modifiableIdleTime);
+        if (modifiableIdleTime > 0) {
+          Timebase::waitForInterrupt();
+        }
+        Kernel::postSleep(expectedIdleTime);
+
+        // Let the interrupt that woke us run, then stop the clock again.
+        Timebase::enableInterrupts();
+        Timebase::disableInterrupts();
+
+        bool expired = false;
+        const uint32_t elapsed = Timebase::stopWakeup(expired);
+
+        // Counts since the tick boundary before the sleep, up to the
+        // restart, including both times the timer was stopped.
+        const uint32_t position = (countsPerTick - untilTick) + compensation + elapsed + compensation;
+        TickType_t completeTicks = position / countsPerTick;
+        uint32_t nextTick = countsPerTick - position % countsPerTick;
+
+        // The kernel must not be moved past the tick it asked to wake up
+        // at. Short of the wake-up, that tick is left to the timer.
+        const TickType_t limit = expired ? expectedIdleTime : expectedIdleTime - 1;
+        if (completeTicks > limit) {
+          completeTicks = limit;
+          nextTick = 1;
+        }
+        if (!expired) {
+          ++s_stats.earlyWakeups;
+        }
+
+        Timebase::startTick(nextTick, completeTicks);
+
+        // The wake-up interrupt already counted one of them.
+        Kernel::stepTick(expired ? completeTicks - 1 : completeTicks);
+
+        ++s_stats.sleeps;
+        s_stats.ticksSuppressed += completeTicks;
+
+        Timebase::enableInterrupts();
+      }
+
+      /**
+       *  Counters since boot. Read them from a task, the idle task is
+       *  the only writer.
+       */
+      static TicklessStats stats()
+      {
+        return s_stats;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      static inline TicklessStats s_stats{};
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_TICKLESSIDLE_HPP_ */
@@ -0,0 +1,155 @@
+/*
+ * TimerWheel.cpp
+ *
+ *  Hierarchical timing wheel for large numbers of software timers.
+ */
+
+#include "TimerWheel.hpp"
+
+#include "Critical.hpp"
+
+namespace freertos {
+
+  namespace {
+
+    constexpr uint32_t SLOT_MASK = TimerWheel::SLOTS - 1;
+
+    /**
+     *  Timers moved down a level per critical section, so a crowded slot
+     *  does not hold interrupts off for all of its timers at once.
+     */
+    constexpr uint32_t CASCADE_BATCH = 8;
+
+  } // namespace
+
+  WheelTimer::~WheelTimer()
+  {
+    if (m_wheel != nullptr) {
+      (void) m_wheel->cancel(*this);
+    }
+  }
+
+  void TimerWheel::start(WheelTimer& timer, uint32_t delay, uint32_t period)
+  {
+    const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+    if (timer.isActive()) {
+      timer.m_wheel->unlink(timer);
+    }
+    timer.m_wheel = this;
+    timer.m_expiry = m_now + (delay != 0 ? delay : 1);
+    timer.m_period = period;
+    link(timer);
+    CriticalSection::exitFromISR(savedInterruptStatus);
+  }
+
+  bool TimerWheel::cancel(WheelTimer& timer)
+  {
+    const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+    const bool active = timer.isActive();
+    if (active) {
+      unlink(timer);
+    }
+    CriticalSection::exitFromISR(savedInterruptStatus);
+    return active;
+  }
+
+  void TimerWheel::advance(uint32_t now)
+  {
+    while (static_cast<int32_t>(now - m_now) > 0) {
+      BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+      ++m_now;
+
+      const uint32_t index = m_now & SLOT_MASK;
+      if (index == 0) {
+        // Level 0 wrapped, pull the next block of timers down, and so on
+        // up as far as the higher levels wrapped too.
+        for (uint32_t level = 1; level < LEVELS; ++level) {
+          cascade(level, savedInterruptStatus);
+          if (((m_now >> (level * SLOT_BITS)) & SLOT_MASK) != 0) {
+            break;
+          }
+        }
+      }
+
+      WheelTimer* timer;
+      while ((timer = m_levels[0][index]) != nullptr) {
+        unlink(*timer);
+        if (timer->m_period != 0) {
+          // Keep a periodic timer in phase, unless it fell behind.
+          timer->m_expiry += timer->m_period;
+          if (static_cast<int32_t>(timer->m_expiry - m_now) <= 0) {
+            timer->m_expiry = m_now + 1;
+          }
+          link(*timer);
+        }
+
+        // Run a copy, the callback may restart the timer with another one.
+        const WheelTimer::Callback callback = timer->m_callback;
+        CriticalSection::exitFromISR(savedInterruptStatus);
+        if (callback) {
+          callback();
+        }
+        savedInterruptStatus = CriticalSection::enterFromISR();
+      }
+
+      CriticalSection::exitFromISR(savedInterruptStatus);
+    }
+  }
+
+  void TimerWheel::link(WheelTimer& timer)
+  {
+    uint32_t delta = timer.m_expiry - m_now;
+    uint32_t expiry = timer.m_expiry;
+    if (delta > MAX_DELAY) {
+      // Parked, filed again when its slot of the last level comes round.
+      delta = MAX_DELAY;
+      expiry = m_now + MAX_DELAY;
+    }
+
+    uint32_t level = 0;
+    while (delta >= (1U << (SLOT_BITS * (level + 1)))) {
+      ++level;
+    }
+
+    WheelTimer*& head = m_levels[level][(expiry >> (SLOT_BITS * level)) & SLOT_MASK];
+    timer.m_next = head;
+    timer.m_link = &head;
+    if (head != nullptr) {
+      head->m_link = &timer.m_next;
+    }
+    head = &timer;
+    ++m_active;
+  }
+
+  void TimerWheel::unlink(WheelTimer& timer)
+  {
+    *timer.m_link = timer.m_next;
+    if (timer.m_next != nullptr) {
+      timer.m_next->m_link = timer.m_link;
+    }
+    timer.m_next = nullptr;
+    timer.m_link = nullptr;
+    --m_active;
+  }
+
+  void TimerWheel::cascade(uint32_t level, BaseType_t& savedInterruptStatus)
+  {
+    // Nothing can be filed into this slot while it drains: the level
+    // below has just wrapped, so whatever lands in this level now is due
+    // in a later block.
+    WheelTimer*& head = m_levels[level][(m_now >> (SLOT_BITS * level)) & SLOT_MASK];
+
+    uint32_t moved = 0;
+    WheelTimer* timer;
+    while ((timer = head) != nullptr) {
+      unlink(*timer);
+      link(*timer);
+      if (++moved == CASCADE_BATCH) {
+        moved = 0;
+        CriticalSection::exitFromISR(savedInterruptStatus);
+        savedInterruptStatus = CriticalSection::enterFromISR();
+      }
+    }
+  }
+
+} // namespace freertos
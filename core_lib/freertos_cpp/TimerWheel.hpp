@@ -0,0 +1,270 @@
+/*
+ * TimerWheel.hpp
+ *
+ *  Hierarchical timing wheel for large numbers of software timers.
+ */
+
+#ifndef LIB_FREERTOS_CPP_TIMERWHEEL_HPP_
+#define LIB_FREERTOS_CPP_TIMERWHEEL_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "InlineFunction.hpp"
+#include "TickHook.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace freertos {
+
+  class TimerWheel;
+
+  /**
+   *  A timer run by a TimerWheel.
+   *
+   *  The callback is stored inside the timer, see InlineFunction for what
+   *  it may capture. It runs in whatever context drives the wheel, often
+   *  the tick interrupt, so it must be short and may only use FromISR
+   *  calls there.
+   *
+   *  @note Cancel the timer, or let it expire, before destroying it.
+   */
+  class WheelTimer {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using Callback = InlineFunction<void(), 2 * sizeof(void*)>;
+
+      WheelTimer() = default;
+
+      explicit WheelTimer(Callback callback)
+          :m_callback(callback)
+      {
+      }
+
+      ~WheelTimer();
+
+      WheelTimer(const WheelTimer&) = delete;
+      WheelTimer& operator=(const WheelTimer&) = delete;
+
+      /**
+       *  Replace the callback. Only while the timer is not active.
+       */
+      void setCallback(Callback callback)
+      {
+        configASSERT(!isActive());
+        m_callback = callback;
+      }
+
+      /**
+       *  Is the timer waiting to expire?
+       */
+      [[nodiscard]] bool isActive() const
+      {
+        return m_link != nullptr;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      friend class TimerWheel;
+
+      Callback m_callback{};
+      TimerWheel* m_wheel{nullptr};
+
+      /**
+       *  Next timer in the slot, and the pointer that points at this
+       *  timer, nullptr while the timer is not linked into a slot.
+       */
+      WheelTimer* m_next{nullptr};
+      WheelTimer** m_link{nullptr};
+
+      uint32_t m_expiry{0};
+      uint32_t m_period{0};
+  };
+
+  /**
+   *  Hashed hierarchical timing wheel, after Varghese and Lauck.
+   *
+   *  Four levels of 64 slots each cover 2^24 ticks, longer delays are
+   *  parked in the last level and re-filed when it comes around. Starting
+   *  and cancelling a timer unlinks and links one list node, in constant
+   *  time whatever the number of active timers. Timers in the higher
+   *  levels move down one level every 64^level ticks, so each timer is
+   *  touched at most four times before it expires.
+   *
+   *  start() and cancel() may be called from tasks and from ISRs at or
+   *  below configMAX_SYSCALL_INTERRUPT_PRIORITY. They work directly on the
+   *  wheel inside a short critical section, there is no command queue to
+   *  fill up as with Timer and the daemon task.
+   *
+   *  A single context drives the wheel by calling advance() or tick(),
+   *  for example a hardware timer interrupt, a task, or the kernel tick
+   *  through TimerWheelTickDriver. Callbacks run in that context, outside
+   *  the critical section.
+   *
+   *  The time interrupts stay off is bounded whatever the number of
+   *  timers: advance() takes the critical section for one tick at a time
+   *  and leaves it to run each callback and after every few timers it
+   *  moves down a level. The time advance() itself takes is not bounded,
+   *  a tick that cascades a crowded slot moves all of its timers.
+   */
+  class TimerWheel {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      static constexpr uint32_t SLOT_BITS = 6;
+      static constexpr uint32_t SLOTS = 1U << SLOT_BITS;
+      static constexpr uint32_t LEVELS = 4;
+
+      /**
+       *  Longest delay filed directly, longer ones are re-filed once per
+       *  MAX_DELAY ticks until they are due.
+       */
+      static constexpr uint32_t MAX_DELAY = (1U << (SLOT_BITS * LEVELS)) - 1;
+
+      /**
+       *  @param now Wheel time to start at, usually the current tick
+       *         count when the wheel is driven from the tick.
+       */
+      explicit TimerWheel(uint32_t now = 0)
+          :m_now(now)
+      {
+      }
+
+      TimerWheel(const TimerWheel&) = delete;
+      TimerWheel& operator=(const TimerWheel&) = delete;
+
+      /**
+       *  (Re)start a timer, it expires delay ticks from now. Restarting
+       *  an active timer moves it.
+       *
+       *  @param timer The timer, bound to this wheel from now on.
+       *  @param delay Ticks until expiry, 0 counts as 1.
+       *  @param period Ticks between expiries after the first, 0 for a
+       *         one shot timer.
+       */
+      void start(WheelTimer& timer, uint32_t delay, uint32_t period = 0);
+
+      /**
+       *  Stop a timer. Calling it from the timer's own callback stops a
+       *  periodic timer.
+       *
+       *  @return true if the timer was active.
+       */
+      bool cancel(WheelTimer& timer);
+
+      /**
+       *  Advance the wheel to time now, running every timer that expires
+       *  on the way. Skipped ticks are caught up one by one.
+       */
+      void advance(uint32_t now);
+
+      /**
+       *  Advance the wheel by one tick.
+       */
+      inline void tick()
+      {
+        advance(m_now + 1);
+      }
+
+      /**
+       *  Current wheel time.
+       */
+      [[nodiscard]] uint32_t now() const
+      {
+        return m_now;
+      }
+
+      /**
+       *  Number of timers waiting to expire.
+       */
+      [[nodiscard]] size_t activeTimers() const
+      {
+        return m_active;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      /**
+       *  Must be called inside the critical section.
+       */
+      void link(WheelTimer& timer);
+      void unlink(WheelTimer& timer);
+
+      /**
+       *  Must be called inside the critical section entered with
+       *  savedInterruptStatus, leaves and re-enters it between batches.
+       */
+      void cascade(uint32_t level, BaseType_t& savedInterruptStatus);
+
+      using Slots = std::array<WheelTimer*, SLOTS>;
+      std::array<Slots, LEVELS> m_levels{};
+
+      uint32_t m_now;
+      size_t m_active{0};
+  };
+
+#if (configUSE_TICK_HOOK == 1)
+
+  /**
+   *  Drives a TimerWheel from the kernel tick. The wheel's time follows
+   *  the tick count and its callbacks run inside the tick interrupt.
+   *  Construct the wheel with the tick count at the time, or the first
+   *  tick catches up from 0, and call registerTickHook() to start.
+   */
+  class TimerWheelTickDriver : public TickHook {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      explicit TimerWheelTickDriver(TimerWheel& wheel)
+          :m_wheel(wheel)
+      {
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Protected API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    protected:
+      void run() override
+      {
+        m_wheel.advance(xTaskGetTickCountFromISR());
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      TimerWheel& m_wheel;
+  };
+
+#endif
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_TIMERWHEEL_HPP_ */
@@ -0,0 +1,380 @@
+/*
+ * Trace.cpp
+ *
+ *  Kernel trace recorder: scheduling, queue, notification and interrupt
+ *  events as compact binary records in a RAM ring.
+ */
+
+#include "Trace.hpp"
+
+#include "Critical.hpp"
+#include "Stats.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#if defined(__arm__)
+#include CMSIS_device_header
+#endif
+
+namespace freertos {
+
+  namespace {
+
+    static_assert((Trace::BUFFER_SIZE & (Trace::BUFFER_SIZE - 1)) == 0, "Trace buffer size must be a power of two");
+
+    /**
+     *  Overflow record in front of a record: event, delta, count.
+     */
+    constexpr size_t OVERFLOW_RECORD_SIZE = 1 + 10 + 5;
+
+    std::array<uint8_t, Trace::BUFFER_SIZE> ring;
+
+    /**
+     *  Free running byte counters, written by the hooks under a critical
+     *  section and by drain() respectively.
+     */
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+
+    std::atomic<bool> recording{false};
+
+    // Only touched inside the critical section of record().
+    uint64_t lastTime = 0;
+    uint32_t droppedRecords = 0;
+    uint32_t pendingOverflow = 0;
+
+    // Only touched by the switch hook, inside vTaskSwitchContext().
+    uint32_t lastTask = 0;
+
+    struct QueueEntry {
+      uint32_t number;
+      uint32_t type;
+    };
+
+    /**
+     *  What start() lists: live tasks and queues, a free slot is null or
+     *  number 0, and how many did not fit. The task hooks run inside
+     *  the kernel's critical sections, the queue hooks are not called
+     *  under one and take their own. start() reads them with the
+     *  scheduler suspended, and neither is used from interrupts.
+     */
+    std::array<void*, Trace::MAX_TASKS> tasks{};
+    std::array<QueueEntry, Trace::MAX_QUEUES> queues{};
+    uint32_t unlistedTasks = 0;
+    uint32_t unlistedQueues = 0;
+
+    uint8_t* putVarint(uint8_t* out, uint64_t value)
+    {
+      do {
+        const auto byte = static_cast<uint8_t>(value & 0x7FU);
+        value >>= 7;
+        *out++ = value != 0 ? static_cast<uint8_t>(byte | 0x80U) : byte;
+      } while (value != 0);
+      return out;
+    }
+
+    constexpr size_t argumentCount(TraceEvent event)
+    {
+      switch (event) {
+        case TraceEvent::Header:
+        case TraceEvent::TaskCreate:
+        case TraceEvent::QueueCreate:
+        case TraceEvent::Truncated:
+          return 2;
+        case TraceEvent::TaskNotifyBlock:
+        case TraceEvent::IsrExit:
+          return 0;
+        default:
+          return 1;
+      }
+    }
+
+  } // namespace
+
+  void Trace::start()
+  {
+    recording.store(false, std::memory_order_relaxed);
+
+    const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+    tail.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    lastTime = Stats::now();
+    droppedRecords = 0;
+    pendingOverflow = 0;
+    lastTask = 0;
+
+    // The header must come first, no hook may get in before it.
+    recording.store(true, std::memory_order_release);
+    record(TraceEvent::Header, Stats::timestampFrequency(), configTICK_RATE_HZ);
+    CriticalSection::exitFromISR(savedInterruptStatus);
+
+    // No task can be created or deleted while the tables are walked.
+    vTaskSuspendAll();
+    for (void* task : tasks) {
+      if (task != nullptr) {
+        TaskStatus_t state{};
+        vTaskGetInfo(static_cast<TaskHandle_t>(task), &state, pdFALSE, eInvalid);
+        record(TraceEvent::TaskCreate, static_cast<uint32_t>(state.xTaskNumber),
+               static_cast<uint32_t>(state.uxCurrentPriority), state.pcTaskName);
+      }
+    }
+    for (const QueueEntry& queue : queues) {
+      if (queue.number != 0) {
+        record(TraceEvent::QueueCreate, queue.number, queue.type);
+      }
+    }
+    if (unlistedTasks != 0 || unlistedQueues != 0) {
+      record(TraceEvent::Truncated, unlistedTasks, unlistedQueues);
+    }
+
+    // The running task, the converter needs it to open the first slice.
+    TaskStatus_t running{};
+    vTaskGetInfo(xTaskGetCurrentTaskHandle(), &running, pdFALSE, eRunning);
+    CriticalSection::enter();
+    lastTask = static_cast<uint32_t>(running.xTaskNumber);
+    record(TraceEvent::TaskSwitch, lastTask);
+    CriticalSection::exit();
+    (void) xTaskResumeAll();
+  }
+
+  void Trace::stop()
+  {
+    recording.store(false, std::memory_order_relaxed);
+  }
+
+  bool Trace::isRecording()
+  {
+    return recording.load(std::memory_order_relaxed);
+  }
+
+  size_t Trace::drain(uint8_t* out, size_t length)
+  {
+    const size_t from = tail.load(std::memory_order_relaxed);
+    const size_t available = head.load(std::memory_order_acquire) - from;
+    const size_t count = available < length ? available : length;
+
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = ring[(from + i) & (BUFFER_SIZE - 1)];
+    }
+    tail.store(from + count, std::memory_order_release);
+    return count;
+  }
+
+  uint32_t Trace::dropped()
+  {
+    const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+    const uint32_t count = droppedRecords;
+    CriticalSection::exitFromISR(savedInterruptStatus);
+    return count;
+  }
+
+  void Trace::record(TraceEvent event, uint32_t first, uint32_t second, const char* name)
+  {
+    if (!recording.load(std::memory_order_acquire)) {
+      return;
+    }
+
+    std::array<uint8_t, OVERFLOW_RECORD_SIZE + MAX_RECORD_SIZE> encoded;
+
+    const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+    const uint64_t time = Stats::now();
+
+    uint8_t* out = encoded.data();
+    if (pendingOverflow != 0) {
+      *out++ = static_cast<uint8_t>(TraceEvent::Overflow);
+      out = putVarint(out, time - lastTime);
+      out = putVarint(out, pendingOverflow);
+      *out++ = static_cast<uint8_t>(event);
+      out = putVarint(out, 0);
+    } else {
+      *out++ = static_cast<uint8_t>(event);
+      out = putVarint(out, time - lastTime);
+    }
+
+    const size_t arguments = argumentCount(event);
+    if (arguments > 0) {
+      out = putVarint(out, first);
+    }
+    if (arguments > 1) {
+      out = putVarint(out, second);
+    }
+    if (event == TraceEvent::TaskCreate) {
+      const size_t nameLength = name != nullptr ? strnlen(name, configMAX_TASK_NAME_LEN) : 0;
+      *out++ = static_cast<uint8_t>(nameLength);
+      std::memcpy(out, name, nameLength);
+      out += nameLength;
+    }
+
+    const auto size = static_cast<size_t>(out - encoded.data());
+    const size_t position = head.load(std::memory_order_relaxed);
+    if (BUFFER_SIZE - (position - tail.load(std::memory_order_acquire)) >= size) {
+      for (size_t i = 0; i < size; ++i) {
+        ring[(position + i) & (BUFFER_SIZE - 1)] = encoded[i];
+      }
+      head.store(position + size, std::memory_order_release);
+      lastTime = time;
+      pendingOverflow = 0;
+    } else {
+      ++droppedRecords;
+      ++pendingOverflow;
+    }
+
+    CriticalSection::exitFromISR(savedInterruptStatus);
+  }
+
+} // namespace freertos
+
+using namespace freertos;
+
+void freertos_trace_task_create(void* handle, uint32_t task, uint32_t priority, const char* name)
+{
+  void** slot = std::find(tasks.begin(), tasks.end(), nullptr);
+  if (slot != tasks.end()) {
+    *slot = handle;
+  } else {
+    ++unlistedTasks;
+  }
+  Trace::record(TraceEvent::TaskCreate, task, priority, name);
+}
+
+void freertos_trace_task_delete(void* handle)
+{
+  void** slot = std::find(tasks.begin(), tasks.end(), handle);
+  if (slot != tasks.end()) {
+    *slot = nullptr;
+  } else if (unlistedTasks != 0) {
+    --unlistedTasks;
+  }
+}
+
+/**
+ *  Called on every switch decision vTaskSwitchContext() makes, as the
+ *  statistics and flight recorder hooks are. A TaskSwitch record is
+ *  only written when the task really changes.
+ */
+void freertos_trace_task_switched_in(uint32_t task)
+{
+  if (task == lastTask) {
+    return;
+  }
+  lastTask = task;
+  Trace::record(TraceEvent::TaskSwitch, task);
+}
+
+void freertos_trace_task_delay(uint32_t ticks)
+{
+  Trace::record(TraceEvent::TaskDelay, ticks);
+}
+
+void freertos_trace_task_delay_until(uint32_t wakeTick)
+{
+  Trace::record(TraceEvent::TaskDelayUntil, wakeTick);
+}
+
+/**
+ *  Numbers queues, semaphores and mutexes in creation order, the kernel
+ *  leaves uxQueueNumber zero otherwise.
+ */
+uint32_t freertos_trace_queue_create(uint32_t type)
+{
+  static std::atomic<uint32_t> created{0};
+  const uint32_t queue = created.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+  QueueEntry* slot = std::find_if(queues.begin(), queues.end(), [](const QueueEntry& entry) {
+    return entry.number == 0;
+  });
+  if (slot != queues.end()) {
+    *slot = {queue, type};
+  } else {
+    ++unlistedQueues;
+  }
+  CriticalSection::exitFromISR(savedInterruptStatus);
+  Trace::record(TraceEvent::QueueCreate, queue, type);
+  return queue;
+}
+
+void freertos_trace_queue_delete(uint32_t queue)
+{
+  const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+  QueueEntry* slot = std::find_if(queues.begin(), queues.end(), [queue](const QueueEntry& entry) {
+    return entry.number == queue;
+  });
+  if (slot != queues.end()) {
+    *slot = {};
+  } else if (unlistedQueues != 0) {
+    --unlistedQueues;
+  }
+  CriticalSection::exitFromISR(savedInterruptStatus);
+}
+
+void freertos_trace_queue_send(uint32_t queue)
+{
+  Trace::record(TraceEvent::QueueSend, queue);
+}
+
+void freertos_trace_queue_send_failed(uint32_t queue)
+{
+  Trace::record(TraceEvent::QueueSendFailed, queue);
+}
+
+void freertos_trace_queue_send_from_isr(uint32_t queue)
+{
+  Trace::record(TraceEvent::QueueSendFromIsr, queue);
+}
+
+void freertos_trace_queue_receive(uint32_t queue)
+{
+  Trace::record(TraceEvent::QueueReceive, queue);
+}
+
+void freertos_trace_queue_receive_failed(uint32_t queue)
+{
+  Trace::record(TraceEvent::QueueReceiveFailed, queue);
+}
+
+void freertos_trace_queue_receive_from_isr(uint32_t queue)
+{
+  Trace::record(TraceEvent::QueueReceiveFromIsr, queue);
+}
+
+void freertos_trace_blocking_on_queue_send(uint32_t queue)
+{
+  Trace::record(TraceEvent::QueueBlockSend, queue);
+}
+
+void freertos_trace_blocking_on_queue_receive(uint32_t queue)
+{
+  Trace::record(TraceEvent::QueueBlockReceive, queue);
+}
+
+void freertos_trace_task_notify(uint32_t task)
+{
+  Trace::record(TraceEvent::TaskNotify, task);
+}
+
+void freertos_trace_task_notify_from_isr(uint32_t task)
+{
+  Trace::record(TraceEvent::TaskNotifyFromIsr, task);
+}
+
+void freertos_trace_task_notify_block(void)
+{
+  Trace::record(TraceEvent::TaskNotifyBlock);
+}
+
+void freertos_trace_isr_enter(void)
+{
+#if defined(__arm__)
+  Trace::record(TraceEvent::IsrEnter, __get_IPSR());
+#else
+  Trace::record(TraceEvent::IsrEnter, 0);
+#endif
+}
+
+void freertos_trace_isr_exit(void)
+{
+  Trace::record(TraceEvent::IsrExit);
+}
@@ -0,0 +1,210 @@
+/*
+ * Trace.hpp
+ *
+ *  Kernel trace recorder: scheduling, queue, notification and interrupt
+ *  events as compact binary records in a RAM ring.
+ */
+
+#ifndef LIB_FREERTOS_CPP_TRACE_HPP_
+#define LIB_FREERTOS_CPP_TRACE_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  Kernel hooks, declared and wired up in FreeRTOSConfig.h when
+ *  configUSE_TRACE_RECORDER is 1:
+ *
+ *    traceTASK_CREATE()                  freertos_trace_task_create()
+ *    traceTASK_DELETE()                  freertos_trace_task_delete()
+ *    traceTASK_SWITCHED_IN()             freertos_trace_task_switched_in()
+ *    traceTASK_DELAY()                   freertos_trace_task_delay()
+ *    traceTASK_DELAY_UNTIL()             freertos_trace_task_delay_until()
+ *    traceQUEUE_CREATE()                 freertos_trace_queue_create()
+ *    traceQUEUE_DELETE()                 freertos_trace_queue_delete()
+ *    traceQUEUE_SEND()                   freertos_trace_queue_send()
+ *    traceQUEUE_SEND_FAILED()            freertos_trace_queue_send_failed()
+ *    traceQUEUE_SEND_FROM_ISR()          freertos_trace_queue_send_from_isr()
+ *    traceQUEUE_RECEIVE()                freertos_trace_queue_receive()
+ *    traceQUEUE_RECEIVE_FAILED()         freertos_trace_queue_receive_failed()
+ *    traceQUEUE_RECEIVE_FROM_ISR()       freertos_trace_queue_receive_from_isr()
+ *    traceBLOCKING_ON_QUEUE_SEND()       freertos_trace_blocking_on_queue_send()
+ *    traceBLOCKING_ON_QUEUE_RECEIVE()    freertos_trace_blocking_on_queue_receive()
+ *    traceTASK_NOTIFY()                  freertos_trace_task_notify()
+ *    traceTASK_NOTIFY_FROM_ISR()         freertos_trace_task_notify_from_isr()
+ *    traceTASK_NOTIFY_GIVE_FROM_ISR()    freertos_trace_task_notify_from_isr()
+ *    traceTASK_NOTIFY_TAKE_BLOCK()       freertos_trace_task_notify_block()
+ *    traceTASK_NOTIFY_WAIT_BLOCK()       freertos_trace_task_notify_block()
+ *
+ *  Semaphores and mutexes are queues to the kernel and show up as such.
+ *  C interrupt handlers call freertos_trace_isr_enter() and
+ *  freertos_trace_isr_exit().
+ */
+
+namespace freertos {
+
+  /**
+   *  Record types. Tasks are identified by their TCB number, the order
+   *  they were created in, queues by a number the queue create hook
+   *  assigns.
+   */
+  enum class TraceEvent : uint8_t {
+    /**
+     *  timestamp frequency, tick rate. First record after start().
+     */
+    Header = 0,
+
+    /**
+     *  task, priority, name length, name characters.
+     */
+    TaskCreate,
+
+    /**
+     *  task.
+     */
+    TaskSwitch,
+
+    /**
+     *  ticks to delay.
+     */
+    TaskDelay,
+
+    /**
+     *  tick to wake at.
+     */
+    TaskDelayUntil,
+
+    /**
+     *  queue, queueQUEUE_TYPE_*.
+     */
+    QueueCreate,
+
+    /**
+     *  queue, for this and the other queue events.
+     */
+    QueueSend,
+    QueueSendFailed,
+    QueueSendFromIsr,
+    QueueReceive,
+    QueueReceiveFailed,
+    QueueReceiveFromIsr,
+    QueueBlockSend,
+    QueueBlockReceive,
+
+    /**
+     *  task notified.
+     */
+    TaskNotify,
+    TaskNotifyFromIsr,
+
+    /**
+     *  The running task blocks on its notification.
+     */
+    TaskNotifyBlock,
+
+    /**
+     *  exception number, IRQn + 16.
+     */
+    IsrEnter,
+    IsrExit,
+
+    /**
+     *  records lost since the previous one.
+     */
+    Overflow,
+
+    /**
+     *  tasks, queues that exist but start() did not list, its tables
+     *  being full. New events go after this one, the decoders count on
+     *  it being last.
+     */
+    Truncated,
+  };
+
+  /**
+   *  Recorder for the kernel trace hooks.
+   *
+   *  Every record is one event byte, the time since the previous record
+   *  as an unsigned LEB128 varint in Stats::now() units and the event's
+   *  arguments as varints, see TraceEvent. A context switch takes 3 or 4
+   *  bytes. Records go into a ring of BUFFER_SIZE bytes and are drained
+   *  by a task, tools/trace_convert.py turns the byte stream into Chrome
+   *  trace JSON that chrome://tracing and Perfetto load.
+   *
+   *      Trace::start();
+   *      ...
+   *      Trace::stop();
+   *      size_t length;
+   *      while ((length = Trace::drain(chunk, sizeof(chunk))) != 0) {
+   *        send(chunk, length);
+   *      }
+   *
+   *  Recording stops, rather than overwriting, when the ring is full:
+   *  draining while recording makes the drain path part of the trace, a
+   *  capture window followed by a drain leaves the system undisturbed.
+   *
+   *  The hooks never call into the kernel, they run inside its critical
+   *  sections and from interrupts up to configMAX_SYSCALL_INTERRUPT_PRIORITY.
+   */
+  class Trace {
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      static constexpr size_t BUFFER_SIZE = 4096;
+
+      /**
+       *  Longest record, a TaskCreate with the full task name.
+       */
+      static constexpr size_t MAX_RECORD_SIZE = 1 + 10 + 2 * 5 + 1 + configMAX_TASK_NAME_LEN;
+
+      /**
+       *  Tasks and queues start() can list, the create hooks keep a table
+       *  of each. Any more are counted in a Truncated record.
+       */
+      static constexpr size_t MAX_TASKS = 16;
+      static constexpr size_t MAX_QUEUES = 32;
+
+      Trace() = delete;
+
+      /**
+       *  Empty the ring and start recording with a Header record, then a
+       *  TaskCreate and a QueueCreate record for every task and queue
+       *  that exists, so a trace started at any time names them. Call
+       *  from a task.
+       */
+      static void start();
+
+      static void stop();
+
+      [[nodiscard]] static bool isRecording();
+
+      /**
+       *  Copy recorded bytes out of the ring, without blocking. Only one
+       *  task may drain.
+       *
+       *  @return Number of bytes copied, 0 once the ring is empty.
+       */
+      static size_t drain(uint8_t* out, size_t length);
+
+      /**
+       *  Records lost because the ring was full, since start().
+       */
+      [[nodiscard]] static uint32_t dropped();
+
+      /**
+       *  Store one record with up to two varint arguments and an optional
+       *  name. Used by the hooks.
+       */
+      static void record(TraceEvent event, uint32_t first = 0, uint32_t second = 0, const char* name = nullptr);
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_TRACE_HPP_ */
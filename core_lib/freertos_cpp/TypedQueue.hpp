@@ -0,0 +1,225 @@
+/*
+ * TypedQueue.hpp
+ *
+ *  Typed, header only FreeRTOS queue that owns its storage.
+ */
+
+#ifndef LIB_FREERTOS_CPP_TYPEDQUEUE_HPP_
+#define LIB_FREERTOS_CPP_TYPEDQUEUE_HPP_
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if(configSUPPORT_STATIC_ALLOCATION == 1)
+#include <array>
+#endif
+
+namespace freertos {
+
+  /**
+   *  Queue of N items of type T.
+   *
+   *  Unlike Queue this class has no virtual functions and no runtime item
+   *  size, every call inlines down to the matching xQueue* function. When
+   *  static allocation is enabled the item storage and the StaticQueue_t
+   *  control block live inside the object, so a TypedQueue can be declared
+   *  as a global without a separate buffer.
+   *
+   *  FreeRTOS copies items with memcpy, T must therefore be trivially
+   *  copyable.
+   *
+   *  @note The FreeRTOS handle points into this object. TypedQueue can
+   *        not be copied or moved.
+   */
+  template<typename T, size_t N>
+  class TypedQueue {
+
+      static_assert(std::is_trivially_copyable_v<T>,
+          "FreeRTOS queues memcpy their items, T must be trivially copyable");
+      static_assert(N > 0, "Queue must hold at least one item");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using value_type = T;
+
+      static constexpr size_t capacity = N;
+
+      TypedQueue()
+      {
+        // The class is only complete inside member bodies
+        static_assert(!std::is_polymorphic_v<TypedQueue>, "TypedQueue must not have virtual functions");
+        #if(configSUPPORT_STATIC_ALLOCATION == 1)
+        handle = xQueueCreateStatic(N, sizeof(T), storage.data(), &queueBuffer);
+        #else
+        handle = xQueueCreate(N, sizeof(T));
+        #endif
+
+        if (handle == nullptr) {
+          configASSERT(!"TypedQueue Constructor Failed");
+        }
+      }
+
+      ~TypedQueue()
+      {
+        vQueueDelete(handle);
+      }
+
+      TypedQueue(const TypedQueue&) = delete;
+      TypedQueue& operator=(const TypedQueue&) = delete;
+
+      /**
+       *  Add an item to the back of the queue.
+       *
+       *  @param item The item you are adding.
+       *  @param Timeout How long to wait to add the item to the queue if
+       *         the queue is currently full.
+       *  @return true if the item was added, false if it was not.
+       */
+      inline bool enqueue(const T& item, TickType_t Timeout = portMAX_DELAY)
+      {
+        return xQueueSendToBack(handle, &item, Timeout) == pdTRUE;
+      }
+
+      /**
+       *  Add an item to the front of the queue.
+       *
+       *  @param item The item you are adding.
+       *  @param Timeout How long to wait to add the item to the queue if
+       *         the queue is currently full.
+       *  @return true if the item was added, false if it was not.
+       */
+      inline bool enqueueToFront(const T& item, TickType_t Timeout = portMAX_DELAY)
+      {
+        return xQueueSendToFront(handle, &item, Timeout) == pdTRUE;
+      }
+
+      /**
+       *  Remove an item from the front of the queue.
+       *
+       *  @param item Where the item you are removing will be returned to.
+       *  @param Timeout How long to wait to remove an item if the queue
+       *         is currently empty.
+       *  @return true if an item was removed, false if no item was removed.
+       */
+      inline bool dequeue(T& item, TickType_t Timeout = portMAX_DELAY)
+      {
+        return xQueueReceive(handle, &item, Timeout) == pdTRUE;
+      }
+
+      /**
+       *  Copy the item at the front of the queue without removing it.
+       *
+       *  @param item Where the item will be copied to.
+       *  @param Timeout How long to wait if the queue is currently empty.
+       *  @return true if an item was copied, false if no item was copied.
+       */
+      inline bool peek(T& item, TickType_t Timeout = portMAX_DELAY)
+      {
+        return xQueuePeek(handle, &item, Timeout) == pdTRUE;
+      }
+
+      /**
+       *  Overwrite the item in a queue of length one. Always succeeds.
+       *
+       *  @param item The item you are writing.
+       */
+      inline void overwrite(const T& item)
+      {
+        static_assert(N == 1, "overwrite() is only valid on a queue of length one");
+        (void) xQueueOverwrite(handle, &item);
+      }
+
+      /**
+       *  Add an item to the back of the queue in ISR context.
+       *
+       *  @param item The item you are adding.
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       *  @return true if the item was added, false if it was not.
+       */
+      inline bool enqueueFromISR(const T& item, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        return xQueueSendToBackFromISR(handle, &item, pxHigherPriorityTaskWoken) == pdTRUE;
+      }
+
+      /**
+       *  Remove an item from the front of the queue in ISR context.
+       *
+       *  @param item Where the item you are removing will be returned to.
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       *  @return true if an item was removed, false if no item was removed.
+       */
+      inline bool dequeueFromISR(T& item, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        return xQueueReceiveFromISR(handle, &item, pxHigherPriorityTaskWoken) == pdTRUE;
+      }
+
+      /**
+       *  Overwrite the item in a queue of length one in ISR context.
+       *
+       *  @param item The item you are writing.
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       */
+      inline void overwriteFromISR(const T& item, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        static_assert(N == 1, "overwriteFromISR() is only valid on a queue of length one");
+        (void) xQueueOverwriteFromISR(handle, &item, pxHigherPriorityTaskWoken);
+      }
+
+      inline bool isEmpty() const
+      {
+        return uxQueueMessagesWaiting(handle) == 0;
+      }
+
+      inline bool isFull() const
+      {
+        return uxQueueSpacesAvailable(handle) == 0;
+      }
+
+      inline void flush()
+      {
+        xQueueReset(handle);
+      }
+
+      [[nodiscard]] inline UBaseType_t numItems() const
+      {
+        return uxQueueMessagesWaiting(handle);
+      }
+
+      [[nodiscard]] inline UBaseType_t numSpacesLeft() const
+      {
+        return uxQueueSpacesAvailable(handle);
+      }
+
+      inline QueueHandle_t getHandle() const
+      {
+        return handle;
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      QueueHandle_t handle;
+
+      #if(configSUPPORT_STATIC_ALLOCATION == 1)
+      alignas(T) std::array<uint8_t, N * sizeof(T)> storage{};
+      StaticQueue_t queueBuffer{};
+      #endif
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_TYPEDQUEUE_HPP_ */
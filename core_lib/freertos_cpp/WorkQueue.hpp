@@ -0,0 +1,248 @@
+/*
+ * WorkQueue.hpp
+ *
+ *  Deferred work run by a fixed set of worker tasks at several
+ *  priorities.
+ */
+
+#ifndef LIB_FREERTOS_CPP_WORKQUEUE_HPP_
+#define LIB_FREERTOS_CPP_WORKQUEUE_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Critical.hpp"
+#include "InlineFunction.hpp"
+#include "Stats.hpp"
+#include "Task.hpp"
+#include "TypedQueue.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace freertos {
+
+  /**
+   *  Counters of one WorkQueue level. Latencies are in Stats::timestamp()
+   *  units, from submission until the work item starts running.
+   */
+  struct WorkQueueStats {
+    /**
+     *  Work items run to completion.
+     */
+    uint32_t completed;
+
+    /**
+     *  Submissions refused because the level's queue stayed full.
+     */
+    uint32_t rejected;
+
+    /**
+     *  Items queued right now, and the most ever queued at once.
+     */
+    UBaseType_t depth;
+    UBaseType_t maxDepth;
+
+    uint32_t maxLatency;
+    uint64_t totalLatency;
+  };
+
+  /**
+   *  Worker tasks, one per priority level, each draining its own queue
+   *  of work items.
+   *
+   *  A work item is an InlineFunction of up to Capacity bytes, copied
+   *  into the level's queue together with its submission timestamp, so
+   *  submitting never allocates. Submitting from an ISR is one
+   *  xQueueSendToBackFromISR() and a timestamp read.
+   *
+   *  Unlike xTimerPendFunctionCall(), which runs everything in the timer
+   *  daemon at configTIMER_TASK_PRIORITY, work is deferred to the level
+   *  it is submitted to. Items of one level run one after another in
+   *  submission order, a higher level preempts a lower one.
+   *
+   *      WorkQueue<3, 8, 256> work{"work", {4, 3, 1}};
+   *      work.start();
+   *      work.submitFromISR(0, [sample] { process(sample); }, &woken);
+   *
+   *  @tparam Levels Number of worker tasks.
+   *  @tparam Depth Items each level can queue.
+   *  @tparam StackWords Stack of each worker.
+   *  @tparam Capacity Bytes a work item may capture.
+   */
+  template<size_t Levels, size_t Depth, uint16_t StackWords, size_t Capacity = 2 * sizeof(void*)>
+  class WorkQueue {
+
+      static_assert(Levels > 0, "WorkQueue needs at least one level");
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Public API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    public:
+      using Work = InlineFunction<void(), Capacity>;
+
+      static constexpr size_t levels = Levels;
+
+      /**
+       *  @param name Name of the worker tasks.
+       *  @param priorities Task priority of each level, any order.
+       */
+      WorkQueue(const char* name, const std::array<uint8_t, Levels>& priorities)
+          :WorkQueue(name, priorities, std::make_index_sequence<Levels>{})
+      {
+      }
+
+      WorkQueue(const WorkQueue&) = delete;
+      WorkQueue& operator=(const WorkQueue&) = delete;
+
+      /**
+       *  Start the worker tasks. Work submitted before queues up.
+       */
+      void start()
+      {
+        for (Worker& worker : m_workers) {
+          worker.start(nullptr);
+        }
+      }
+
+      /**
+       *  Queue work on a level.
+       *
+       *  @param Timeout How long to wait for room if the queue is full.
+       *  @return true if queued, false if the queue stayed full.
+       */
+      bool submit(size_t level, const Work& work, TickType_t Timeout = 0)
+      {
+        configASSERT(level < Levels && work);
+        return m_workers[level].submit(Item{work, Stats::timestamp()}, Timeout);
+      }
+
+      /**
+       *  Queue work on a level from ISR context.
+       *
+       *  @param pxHigherPriorityTaskWoken Did this operation result in a
+       *         rescheduling event.
+       *  @return true if queued, false if the queue is full.
+       */
+      bool submitFromISR(size_t level, const Work& work, BaseType_t* pxHigherPriorityTaskWoken)
+      {
+        configASSERT(level < Levels && work);
+        return m_workers[level].submitFromISR(Item{work, Stats::timestamp()}, pxHigherPriorityTaskWoken);
+      }
+
+      /**
+       *  Snapshot of a level's counters.
+       */
+      [[nodiscard]] WorkQueueStats stats(size_t level) const
+      {
+        configASSERT(level < Levels);
+        return m_workers[level].stats();
+      }
+
+      /////////////////////////////////////////////////////////////////////////
+      //
+      //  Private API
+      //
+      /////////////////////////////////////////////////////////////////////////
+    private:
+      struct Item {
+        Work work;
+        uint32_t submitted;
+      };
+
+      class Worker : public Task {
+        public:
+          #if(configSUPPORT_STATIC_ALLOCATION == 1)
+          Worker(const char* name, uint8_t priority)
+              :Task(name, m_stack.data(), StackWords, priority)
+          {
+          }
+          #else
+          Worker(const char* name, uint8_t priority)
+              :Task(name, StackWords, priority)
+          {
+          }
+          #endif
+
+          bool submit(const Item& item, TickType_t Timeout)
+          {
+            if (!m_queue.enqueue(item, Timeout)) {
+              m_rejected.fetch_add(1, std::memory_order_relaxed);
+              return false;
+            }
+            return true;
+          }
+
+          bool submitFromISR(const Item& item, BaseType_t* pxHigherPriorityTaskWoken)
+          {
+            if (!m_queue.enqueueFromISR(item, pxHigherPriorityTaskWoken)) {
+              m_rejected.fetch_add(1, std::memory_order_relaxed);
+              return false;
+            }
+            return true;
+          }
+
+          WorkQueueStats stats() const
+          {
+            const BaseType_t savedInterruptStatus = CriticalSection::enterFromISR();
+            WorkQueueStats snapshot = m_stats;
+            CriticalSection::exitFromISR(savedInterruptStatus);
+
+            snapshot.rejected = m_rejected.load(std::memory_order_relaxed);
+            snapshot.depth = m_queue.numItems();
+            return snapshot;
+          }
+
+        protected:
+          void run() override
+          {
+            loop {
+              Item item;
+              (void) m_queue.dequeue(item);
+
+              // Items only leave through here, so the queue is at its
+              // longest right before a dequeue.
+              const UBaseType_t depth = m_queue.numItems() + 1;
+              const uint32_t latency = Stats::timestamp() - item.submitted;
+
+              item.work();
+
+              CriticalSection::enter();
+              ++m_stats.completed;
+              if (depth > m_stats.maxDepth) {
+                m_stats.maxDepth = depth;
+              }
+              if (latency > m_stats.maxLatency) {
+                m_stats.maxLatency = latency;
+              }
+              m_stats.totalLatency += latency;
+              CriticalSection::exit();
+            }
+          }
+
+        private:
+          #if(configSUPPORT_STATIC_ALLOCATION == 1)
+          std::array<StackType_t, StackWords> m_stack{};
+          #endif
+          TypedQueue<Item, Depth> m_queue{};
+          WorkQueueStats m_stats{};
+          std::atomic<uint32_t> m_rejected{0};
+      };
+
+      template<size_t... I>
+      WorkQueue(const char* name, const std::array<uint8_t, Levels>& priorities, std::index_sequence<I...>)
+          :m_workers{{Worker{name, priorities[I]}...}}
+      {
+      }
+
+      std::array<Worker, Levels> m_workers;
+  };
+
+} // namespace freertos
+
+#endif /* LIB_FREERTOS_CPP_WORKQUEUE_HPP_ */
@@ -0,0 +1,124 @@
+/*
+ * Log.cpp
+ *
+ *  Deferred, binary encoded logging.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Log.hpp"
+
+#include <freertos_cpp/Critical.hpp>
+#include <freertos_cpp/SpscRing.hpp>
+
+#include <atomic>
+#include <span>
+
+namespace logging {
+
+  namespace {
+
+    /**
+     *  Producers are serialised with a critical section, which turns the
+     *  ring into the single producer the SPSC ring expects. The drain task
+     *  is the only consumer and reads without locking.
+     */
+    freertos::SpscRing<uint8_t, BUFFER_SIZE> ring{};
+
+    std::atomic<uint32_t> droppedRecords{0};
+
+    bool inInterrupt()
+    {
+#if defined(__arm__)
+      return xPortIsInsideInterrupt() == pdTRUE;
+#else
+      // No handler mode on the host, LogBench logs from a task only.
+      return false;
+#endif
+    }
+
+    /**
+     *  Store a record given as a header, a payload and a trailer, all or
+     *  nothing.
+     */
+    bool store(std::span<const uint8_t> header, std::span<const uint8_t> payload = {},
+               std::span<const uint8_t> trailer = {})
+    {
+      BaseType_t higherPriorityTaskWoken = pdFALSE;
+      bool stored = false;
+
+      // The FromISR flavour only raises BASEPRI, which is also valid from
+      // a task and lets one code path serve both contexts.
+      const BaseType_t savedInterruptStatus = freertos::CriticalSection::enterFromISR();
+      if (ring.spaceAvailable() >= header.size() + payload.size() + trailer.size()) {
+        (void) ring.pushFromISR(header, &higherPriorityTaskWoken);
+        if (!payload.empty()) {
+          (void) ring.pushFromISR(payload, &higherPriorityTaskWoken);
+        }
+        if (!trailer.empty()) {
+          (void) ring.pushFromISR(trailer, &higherPriorityTaskWoken);
+        }
+        stored = true;
+      }
+      freertos::CriticalSection::exitFromISR(savedInterruptStatus);
+
+      if (!stored) {
+        droppedRecords.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      // Only the switch is context specific. From a task a yield pends
+      // PendSV, so inside the caller's own critical section it is taken
+      // when that ends. With the scheduler suspended the woken drain task
+      // is already pending and xTaskResumeAll() switches to it.
+      if (inInterrupt()) {
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+      } else if (higherPriorityTaskWoken != pdFALSE && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        taskYIELD();
+      }
+      return stored;
+    }
+
+  } // namespace
+
+  bool commit(const uint8_t* record, size_t length)
+  {
+    return store(std::span<const uint8_t>(record, length));
+  }
+
+  bool writeBlob(const char* tag, const uint8_t* data, size_t length)
+  {
+    configASSERT(length <= MAX_BLOB_SIZE);
+
+    std::array<uint8_t, HEADER_SIZE> header{};
+    header[0] = FRAME_MARKER;
+    header[1] = static_cast<uint8_t>(sizeof(uint32_t) + length);
+
+    const auto id = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(tag));
+    std::memcpy(&header[2], &id, sizeof(id));
+    freertos::FlightRecorder::system().record(freertos::FlightEvent::Log, id);
+
+    // The CRC is worked out before taking the ring, like in write().
+    const uint16_t crc = detail::crc16(data, length, detail::crc16(&header[1], HEADER_SIZE - 1));
+    std::array<uint8_t, CRC_SIZE> trailer{};
+    std::memcpy(trailer.data(), &crc, sizeof(crc));
+
+    return store(header, std::span<const uint8_t>(data, length), trailer);
+  }
+
+  size_t drain(uint8_t* out, size_t length, TickType_t ticksToWait)
+  {
+    return ring.receive(std::span<uint8_t>(out, length), ticksToWait);
+  }
+
+  size_t space()
+  {
+    return ring.spaceAvailable();
+  }
+
+  uint32_t dropped()
+  {
+    return droppedRecords.load(std::memory_order_relaxed);
+  }
+
+} // namespace logging
@@ -0,0 +1,215 @@
+/*
+ * Log.hpp
+ *
+ *  Deferred, binary encoded logging.
+ */
+
+#ifndef LIB_LOGGING_LOG_HPP_
+#define LIB_LOGGING_LOG_HPP_
+
+#include "FreeRTOS.h"
+
+#include <freertos_cpp/FlightRecorder.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ *  Log a message from task or ISR context.
+ *
+ *  The format string is never formatted or sent on the target. It is
+ *  placed in the non allocated .log_strings section of the ELF and its
+ *  address in that section becomes the message ID. Only the ID and the
+ *  raw argument bytes are recorded, tools/log_decode.py rebuilds the text
+ *  from the ELF.
+ *
+ *  Supported conversions are the integer ones (%d %i %u %x %X %o %c, with
+ *  an ll modifier for 64 bit values), %p and the floating point ones
+ *  (%f %e %g, always sent as float). %s is not supported.
+ */
+#define LOG(fmt, ...)                                                                   \
+  do {                                                                                  \
+    __attribute__((section(".log_strings"), used)) static const char log_fmt_[] = fmt; \
+    ::logging::write(log_fmt_ __VA_OPT__(,) __VA_ARGS__);                               \
+  } while (0)
+
+/**
+ *  Send raw bytes through the log stream, tagged so a host tool can pick
+ *  them out: tools/log_decode.py skips blobs, other tools collect the
+ *  ones with their tag. Evaluates to true if the blob was stored.
+ */
+#define LOG_BLOB(tag, data, length)                                                            \
+  ([&]() {                                                                                     \
+    __attribute__((section(".log_strings"), used)) static const char log_fmt_[] = "@blob:" tag; \
+    return ::logging::writeBlob(log_fmt_, data, length);                                       \
+  }())
+
+namespace logging {
+
+  /**
+   *  Size of the record ring in bytes.
+   */
+  static constexpr size_t BUFFER_SIZE = 1024;
+
+  /**
+   *  Record layout on the wire, little endian:
+   *
+   *    uint8_t  marker    FRAME_MARKER
+   *    uint8_t  length    bytes of ID and args
+   *    uint32_t id        offset of the format string in .log_strings
+   *    ...      args      4 bytes per argument, 8 for 64 bit integers
+   *    uint16_t crc       CRC-16/CCITT-FALSE of length, ID and args
+   *
+   *  The marker and the CRC let a decoder that joins a running stream,
+   *  or loses bytes on the line, find the next whole record.
+   */
+  static constexpr uint8_t FRAME_MARKER = 0xA5;
+  static constexpr size_t HEADER_SIZE = 2 * sizeof(uint8_t) + sizeof(uint32_t);
+  static constexpr size_t CRC_SIZE = sizeof(uint16_t);
+
+  /**
+   *  Ring bytes a record takes on top of its arguments.
+   */
+  static constexpr size_t FRAME_OVERHEAD = HEADER_SIZE + CRC_SIZE;
+
+  /**
+   *  Copy an encoded record into the ring. Drops the whole record if it
+   *  does not fit. Safe from tasks and ISRs.
+   *
+   *  @return true if the record was stored.
+   */
+  bool commit(const uint8_t* record, size_t length);
+
+  /**
+   *  Largest LOG_BLOB() payload, the record length is one byte.
+   */
+  static constexpr size_t MAX_BLOB_SIZE = UINT8_MAX - sizeof(uint32_t);
+
+  /**
+   *  Commit a record carrying length raw bytes, without copying them
+   *  into a record first. Use the LOG_BLOB macro instead of calling this
+   *  directly, it places the tag.
+   *
+   *  @return true if the record was stored.
+   */
+  bool writeBlob(const char* tag, const uint8_t* data, size_t length);
+
+  /**
+   *  Copy pending record bytes out of the ring, blocking until some are
+   *  available or the timeout expires. Only one task may drain.
+   *
+   *  @return Number of bytes copied, 0 on timeout.
+   */
+  size_t drain(uint8_t* out, size_t length, TickType_t ticksToWait);
+
+  /**
+   *  Free bytes in the ring, for producers that would rather wait than
+   *  have a record dropped.
+   */
+  size_t space();
+
+  /**
+   *  Number of records dropped because the ring was full.
+   */
+  uint32_t dropped();
+
+  namespace detail {
+
+    constexpr std::array<uint16_t, 256> crcTable()
+    {
+      std::array<uint16_t, 256> table{};
+      for (uint32_t byte = 0; byte < table.size(); ++byte) {
+        uint32_t crc = byte << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+          crc = (crc & 0x8000U) != 0 ? (crc << 1) ^ 0x1021U : crc << 1;
+        }
+        table[byte] = static_cast<uint16_t>(crc);
+      }
+      return table;
+    }
+
+    inline constexpr std::array<uint16_t, 256> CRC_TABLE = crcTable();
+
+    /**
+     *  CRC-16/CCITT-FALSE, continued from crc over another block.
+     */
+    inline uint16_t crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF)
+    {
+      for (size_t i = 0; i < length; ++i) {
+        crc = static_cast<uint16_t>((crc << 8) ^ CRC_TABLE[((crc >> 8) ^ data[i]) & 0xFFU]);
+      }
+      return crc;
+    }
+
+    template<typename T>
+    constexpr size_t encodedSize()
+    {
+      if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        return sizeof(T) > sizeof(uint32_t) ? sizeof(uint64_t) : sizeof(uint32_t);
+      }
+      else {
+        return sizeof(uint32_t);
+      }
+    }
+
+    template<typename T>
+    inline uint8_t* encode(uint8_t* out, const T& value)
+    {
+      static_assert(!std::is_same_v<std::decay_t<T>, char*> && !std::is_same_v<std::decay_t<T>, const char*>,
+          "%s is not supported by the binary logger");
+
+      if constexpr (std::is_floating_point_v<T>) {
+        const auto narrowed = static_cast<float>(value);
+        std::memcpy(out, &narrowed, sizeof(narrowed));
+      }
+      else if constexpr (std::is_pointer_v<T>) {
+        const auto address = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value));
+        std::memcpy(out, &address, sizeof(address));
+      }
+      else if constexpr (encodedSize<T>() == sizeof(uint64_t)) {
+        const auto wide = static_cast<uint64_t>(value);
+        std::memcpy(out, &wide, sizeof(wide));
+      }
+      else {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "unsupported log argument type");
+        const auto word = static_cast<uint32_t>(value);
+        std::memcpy(out, &word, sizeof(word));
+      }
+      return out + encodedSize<T>();
+    }
+
+  } // namespace detail
+
+  /**
+   *  Encode and commit one record. Use the LOG macro instead of calling
+   *  this directly, it places the format string.
+   */
+  template<typename... Args>
+  inline void write(const char* fmt, const Args&... args)
+  {
+    constexpr size_t size = FRAME_OVERHEAD + (detail::encodedSize<std::decay_t<Args>>() + ... + 0);
+    static_assert(size - FRAME_OVERHEAD + sizeof(uint32_t) <= UINT8_MAX, "too many log arguments");
+
+    std::array<uint8_t, size> record;
+    record[0] = FRAME_MARKER;
+    record[1] = static_cast<uint8_t>(size - FRAME_OVERHEAD + sizeof(uint32_t));
+
+    const auto id = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(fmt));
+    std::memcpy(&record[2], &id, sizeof(id));
+    freertos::FlightRecorder::system().record(freertos::FlightEvent::Log, id);
+
+    uint8_t* out = &record[HEADER_SIZE];
+    ((out = detail::encode<std::decay_t<Args>>(out, args)), ...);
+
+    const uint16_t crc = detail::crc16(&record[1], size - 1 - CRC_SIZE);
+    std::memcpy(out, &crc, sizeof(crc));
+
+    (void) commit(record.data(), size);
+  }
+
+} // namespace logging
+
+#endif /* LIB_LOGGING_LOG_HPP_ */
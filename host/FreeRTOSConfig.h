@@ -0,0 +1,157 @@
+/*
+ * FreeRTOSConfig.h
+ *
+ *  Kernel configuration for the host build on the FreeRTOS POSIX port.
+ *  Mirrors core/inc/FreeRTOSConfig.h minus the Cortex-M specifics so the
+ *  libraries see the same feature set as on the target.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <assert.h>
+#include <stdint.h>
+
+#define configUSE_PREEMPTION                     1
+#define configSUPPORT_STATIC_ALLOCATION          FREERTOS_USE_STATIC_ALLOCATION
+/* heap_4 is always linked on the host so the benchmarks can compare
+   against it, the libraries still create their kernel objects statically
+   when FREERTOS_USE_STATIC_ALLOCATION is set. */
+#define configSUPPORT_DYNAMIC_ALLOCATION         1
+#define configUSE_IDLE_HOOK                      0
+#define configUSE_TICK_HOOK                      1
+#define configTICK_RATE_HZ                       ((TickType_t)1000)
+#define configMAX_PRIORITIES                     ( 56 )
+/* The POSIX port runs every task on a pthread, which needs at least
+   PTHREAD_STACK_MIN bytes of stack. */
+#define configMINIMAL_STACK_SIZE                 ((uint16_t)4096)
+#define configTOTAL_HEAP_SIZE                    ((size_t)(1024 * 1024))
+#define configMAX_TASK_NAME_LEN                  ( 16 )
+#define configUSE_TRACE_FACILITY                 1
+#define configUSE_16_BIT_TICKS                   0
+#define configUSE_MUTEXES                        1
+#define configQUEUE_REGISTRY_SIZE                8
+#define configCHECK_FOR_STACK_OVERFLOW           0
+#define configUSE_RECURSIVE_MUTEXES              1
+#define configUSE_MALLOC_FAILED_HOOK             1
+#define configUSE_COUNTING_SEMAPHORES            1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
+#define configMESSAGE_BUFFER_LENGTH_TYPE         size_t
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES                    0
+#define configMAX_CO_ROUTINE_PRIORITIES          ( 2 )
+
+/* Software timer definitions. */
+#define configUSE_TIMERS                         1
+#define configTIMER_TASK_PRIORITY                ( 2 )
+#define configTIMER_QUEUE_LENGTH                 10
+#define configTIMER_TASK_STACK_DEPTH             configMINIMAL_STACK_SIZE
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+#define INCLUDE_vTaskPrioritySet             1
+#define INCLUDE_uxTaskPriorityGet            1
+#define INCLUDE_vTaskDelete                  1
+#define INCLUDE_vTaskCleanUpResources        0
+#define INCLUDE_vTaskSuspend                 1
+#define INCLUDE_vTaskDelayUntil              1
+#define INCLUDE_vTaskDelay                   1
+#define INCLUDE_xTaskGetSchedulerState       1
+#define INCLUDE_xTimerPendFunctionCall       1
+#define INCLUDE_xQueueGetMutexHolder         1
+#define INCLUDE_uxTaskGetStackHighWaterMark  1
+#define INCLUDE_xTaskGetCurrentTaskHandle    1
+#define INCLUDE_eTaskGetState                1
+
+#define configASSERT( x ) assert( x )
+
+/* Run time statistics on the host monotonic clock, see freertos_cpp/Stats.hpp,
+   and the flight recorder in a plain buffer, see freertos_cpp/FlightRecorder.hpp */
+#define configGENERATE_RUN_TIME_STATS            1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS  1
+#define configSTATS_TLS_INDEX                    0
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void freertos_stats_configure_counter(void);
+uint32_t freertos_stats_run_time_counter(void);
+void freertos_stats_task_switched_in(void);
+uint32_t freertos_stats_isr_enter(void);
+void freertos_stats_isr_exit(uint32_t start);
+void freertos_flight_task_switched_in(void);
+void freertos_flight_isr(void);
+void freertos_flight_fault(const uint32_t *frame, uint32_t excReturn);
+#ifdef __cplusplus
+}
+#endif
+
+/* Kernel trace recorder, see freertos_cpp/Trace.hpp */
+#define configUSE_TRACE_RECORDER                 1
+
+#if (configUSE_TRACE_RECORDER == 1)
+#ifdef __cplusplus
+extern "C" {
+#endif
+void freertos_trace_task_create(void *handle, uint32_t task, uint32_t priority, const char *name);
+void freertos_trace_task_delete(void *handle);
+void freertos_trace_task_switched_in(uint32_t task);
+void freertos_trace_task_delay(uint32_t ticks);
+void freertos_trace_task_delay_until(uint32_t wakeTick);
+uint32_t freertos_trace_queue_create(uint32_t type);
+void freertos_trace_queue_delete(uint32_t queue);
+void freertos_trace_queue_send(uint32_t queue);
+void freertos_trace_queue_send_failed(uint32_t queue);
+void freertos_trace_queue_send_from_isr(uint32_t queue);
+void freertos_trace_queue_receive(uint32_t queue);
+void freertos_trace_queue_receive_failed(uint32_t queue);
+void freertos_trace_queue_receive_from_isr(uint32_t queue);
+void freertos_trace_blocking_on_queue_send(uint32_t queue);
+void freertos_trace_blocking_on_queue_receive(uint32_t queue);
+void freertos_trace_task_notify(uint32_t task);
+void freertos_trace_task_notify_from_isr(uint32_t task);
+void freertos_trace_task_notify_block(void);
+void freertos_trace_isr_enter(void);
+void freertos_trace_isr_exit(void);
+#ifdef __cplusplus
+}
+#endif
+
+#define traceRECORDER_TASK_SWITCHED_IN()         freertos_trace_task_switched_in((uint32_t) pxCurrentTCB->uxTCBNumber)
+#define traceTASK_CREATE(pxNewTCB)               \
+  freertos_trace_task_create((void *) (pxNewTCB), (uint32_t) (pxNewTCB)->uxTCBNumber, (uint32_t) (pxNewTCB)->uxPriority, \
+                             (pxNewTCB)->pcTaskName)
+#define traceTASK_DELETE(pxTaskToDelete)         freertos_trace_task_delete((void *) (pxTaskToDelete))
+#define traceTASK_DELAY()                        freertos_trace_task_delay((uint32_t) xTicksToDelay)
+#define traceTASK_DELAY_UNTIL(xTimeToWake)       freertos_trace_task_delay_until((uint32_t) (xTimeToWake))
+#define traceQUEUE_CREATE(pxNewQueue)            \
+  (pxNewQueue)->uxQueueNumber = freertos_trace_queue_create((uint32_t) (pxNewQueue)->ucQueueType)
+#define traceQUEUE_DELETE(pxQueue)               freertos_trace_queue_delete((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND(pxQueue)                 freertos_trace_queue_send((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND_FAILED(pxQueue)          freertos_trace_queue_send_failed((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)        freertos_trace_queue_send_from_isr((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE(pxQueue)              freertos_trace_queue_receive((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue)       freertos_trace_queue_receive_failed((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)     freertos_trace_queue_receive_from_isr((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue)     freertos_trace_blocking_on_queue_send((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue)  freertos_trace_blocking_on_queue_receive((uint32_t) (pxQueue)->uxQueueNumber)
+#define traceTASK_NOTIFY()                       freertos_trace_task_notify((uint32_t) pxTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_FROM_ISR()              freertos_trace_task_notify_from_isr((uint32_t) pxTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_GIVE_FROM_ISR()         freertos_trace_task_notify_from_isr((uint32_t) pxTCB->uxTCBNumber)
+#define traceTASK_NOTIFY_TAKE_BLOCK()            freertos_trace_task_notify_block()
+#define traceTASK_NOTIFY_WAIT_BLOCK()            freertos_trace_task_notify_block()
+#else
+#define traceRECORDER_TASK_SWITCHED_IN()
+#endif
+
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() freertos_stats_configure_counter()
+#define portGET_RUN_TIME_COUNTER_VALUE()         freertos_stats_run_time_counter()
+#define traceTASK_SWITCHED_IN()                  \
+  do {                                           \
+    freertos_stats_task_switched_in();           \
+    freertos_flight_task_switched_in();          \
+    traceRECORDER_TASK_SWITCHED_IN();            \
+  } while (0)
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,216 @@
+/*
+ * ActiveObjectBench.cpp
+ *
+ *  Posting reference counted events to active objects against copying
+ *  events through a queue.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/ActiveObject.hpp>
+#include <freertos_cpp/Semaphore.hpp>
+
+#include <array>
+#include <cstdio>
+
+using namespace bench;
+
+namespace {
+
+  /**
+   *  Stand in for etl::imessage and etl::hfsm, which expose the same
+   *  receive() and start() to Active.
+   */
+  struct Message {
+    enum Id : uint8_t { SAMPLE, TOGGLE, RESET };
+
+    Id id;
+  };
+
+  struct Sample : Message {
+    explicit Sample(uint32_t number)
+        :Message{SAMPLE}, sequence(number)
+    {
+    }
+
+    uint32_t sequence;
+    std::array<uint8_t, 24> payload{};
+  };
+
+  struct Toggle : Message {
+    Toggle()
+        :Message{TOGGLE}
+    {
+    }
+  };
+
+  freertos::BinarySemaphore handled{};
+
+  /**
+   *  Two level machine: Running has children Idle and Busy. Reset is
+   *  handled by the parent whatever the child, the way an hfsm state
+   *  passes unhandled events up.
+   */
+  class Machine {
+    public:
+      enum class State : uint8_t { STOPPED, IDLE, BUSY };
+
+      explicit Machine(bool signal)
+          :m_signal(signal)
+      {
+      }
+
+      void start()
+      {
+        m_state = State::IDLE;
+      }
+
+      void receive(const Message& message)
+      {
+        if (!child(message)) {
+          running(message);
+        }
+        ++m_received;
+        if (m_signal) {
+          (void) handled.give();
+        }
+      }
+
+      [[nodiscard]] uint32_t received() const
+      {
+        return m_received;
+      }
+
+    private:
+      bool child(const Message& message)
+      {
+        switch (m_state) {
+          case State::IDLE:
+            if (message.id == Message::TOGGLE) {
+              m_state = State::BUSY;
+              return true;
+            }
+            return false;
+          case State::BUSY:
+            if (message.id == Message::SAMPLE) {
+              m_last = static_cast<const Sample&>(message).sequence;
+              return true;
+            }
+            if (message.id == Message::TOGGLE) {
+              m_state = State::IDLE;
+              return true;
+            }
+            return false;
+          case State::STOPPED:
+          default:
+            return false;
+        }
+      }
+
+      void running(const Message& message)
+      {
+        if (message.id == Message::RESET) {
+          m_state = State::IDLE;
+        }
+      }
+
+      State m_state{State::STOPPED};
+      bool m_signal;
+      uint32_t m_received{0};
+      uint32_t m_last{0};
+  };
+
+  constexpr size_t SUBSCRIBERS = 8;
+
+  freertos::EventPool<Message, sizeof(Sample), 4> events{};
+
+  freertos::StaticActiveThread<Message, 4, STACK_SIZE> fast{"fast", PARTNER_PRIORITY};
+  freertos::Active<Machine, Message> echo{fast, true};
+
+  // Everything below the runner shares one thread and one queue.
+  freertos::StaticActiveThread<Message, 2 * SUBSCRIBERS, STACK_SIZE> slow{"slow", RUNNER_PRIORITY - 1};
+  std::array<freertos::Active<Machine, Message>, SUBSCRIBERS> listeners{{
+      freertos::Active<Machine, Message>{slow, false}, freertos::Active<Machine, Message>{slow, false},
+      freertos::Active<Machine, Message>{slow, false}, freertos::Active<Machine, Message>{slow, false},
+      freertos::Active<Machine, Message>{slow, false}, freertos::Active<Machine, Message>{slow, false},
+      freertos::Active<Machine, Message>{slow, false}, freertos::Active<Machine, Message>{slow, false},
+  }};
+  freertos::Subscribers<Message, SUBSCRIBERS> samples{};
+
+  /**
+   *  The same exchange as a plain task receiving event copies.
+   */
+  std::array<Sample, 4> copyStorage{Sample{0}, Sample{0}, Sample{0}, Sample{0}};
+  freertos::Queue copies = freertos::makeQueue(copyStorage);
+
+  void copyReceiver()
+  {
+    Machine machine{true};
+    machine.start();
+    loop {
+      Sample sample{0};
+      (void) copies.dequeue(&sample);
+      machine.receive(sample);
+    }
+  }
+
+  /**
+   *  Wait until the slow thread has dispatched every event and given it
+   *  back to the pool.
+   */
+  void drainSlow()
+  {
+    while (slow.pending() != 0 || events.stats().inUse != 0) {
+      vTaskDelay(1);
+    }
+  }
+
+  Benchmark activeObjectBench{"active object", [] {
+    fast.start(nullptr);
+    slow.start(nullptr);
+    static Partner partner{"copies", copyReceiver, PARTNER_PRIORITY};
+    partner.start(nullptr);
+
+    (void) echo.post(events.make<Toggle>());
+    (void) handled.take();
+
+    uint32_t sequence = 0;
+    measure("ActiveObject make+post+dispatch", ITERATIONS, [&sequence] {
+      (void) echo.post(events.make<Sample>(++sequence));
+      (void) handled.take();
+    });
+
+    measure("Queue copy 32 byte event+dispatch", ITERATIONS, [&sequence] {
+      Sample sample{++sequence};
+      (void) copies.enqueue(&sample);
+      (void) handled.take();
+    });
+
+    for (auto& listener : listeners) {
+      samples.subscribe(listener);
+    }
+
+    // The slow thread drains only while the runner sleeps, so only the
+    // publishing is timed. Each publish waits for the last event to come
+    // back, one event in use at a time whatever the host's timing.
+    constexpr uint32_t PUBLISHES = 200;
+    Clock::duration elapsed{};
+    for (uint32_t i = 0; i < PUBLISHES; ++i) {
+      drainSlow();
+      const Clock::time_point start = Clock::now();
+      const size_t delivered = samples.publish(events.make<Sample>(++sequence));
+      elapsed += Clock::now() - start;
+      configASSERT(delivered == SUBSCRIBERS);
+      (void) delivered;
+    }
+    report("Subscribers make+publish to 8", PUBLISHES, elapsed);
+    drainSlow();
+
+    const freertos::BlockPoolStats stats = events.stats();
+    configASSERT(stats.inUse == 0 && stats.highWaterMark == 1);
+    configASSERT(listeners[0].machine().received() == PUBLISHES);
+    std::printf("# active object: %zu machines on one thread, event pool high water mark %zu of 4\n",
+        SUBSCRIBERS, stats.highWaterMark);
+  }};
+
+} // namespace
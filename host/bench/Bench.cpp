@@ -0,0 +1,67 @@
+/*
+ * Bench.cpp
+ *
+ *  Minimal benchmark harness for the host build.
+ */
+
+#include "Bench.hpp"
+
+#include <cstdio>
+
+namespace bench {
+
+  Benchmark* Benchmark::s_head = nullptr;
+  Benchmark* Benchmark::s_tail = nullptr;
+
+  Benchmark::Benchmark(const char* name, Function function)
+      :m_name(name),
+       m_function(function),
+       m_next(nullptr)
+  {
+    if (s_tail == nullptr) {
+      s_head = this;
+    }
+    else {
+      s_tail->m_next = this;
+    }
+    s_tail = this;
+  }
+
+  void Benchmark::runAll()
+  {
+    std::printf("%-50s %10s %12s %12s\n", "benchmark", "ops", "ns/op", "cycles/op");
+
+    for (Benchmark* benchmark = s_head; benchmark != nullptr; benchmark = benchmark->m_next) {
+      std::printf("# %s\n", benchmark->m_name);
+      benchmark->m_function();
+    }
+  }
+
+  void report(const char* name, uint32_t operations, Clock::duration elapsed, uint64_t elapsedCycles)
+  {
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    const double perOperation = operations == 0 ? 0.0 : static_cast<double>(nanoseconds) / operations;
+
+    if (elapsedCycles == 0 || operations == 0) {
+      std::printf("%-50s %10u %12.1f %12s\n", name, operations, perOperation, "-");
+    }
+    else {
+      const double cyclesPerOperation = static_cast<double>(elapsedCycles) / operations;
+      std::printf("%-50s %10u %12.1f %12.1f\n", name, operations, perOperation, cyclesPerOperation);
+    }
+    std::fflush(stdout);
+  }
+
+  Partner::Partner(const char* name, Body body, uint8_t priority)
+      :freertos::Task(name, m_stack.data(), STACK_SIZE, priority),
+       m_body(body)
+  {
+  }
+
+  void Partner::run()
+  {
+    m_body();
+    vTaskSuspend(nullptr);
+  }
+
+} // namespace bench
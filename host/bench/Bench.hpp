@@ -0,0 +1,123 @@
+/*
+ * Bench.hpp
+ *
+ *  Minimal benchmark harness for the host build.
+ */
+
+#ifndef HOST_BENCH_BENCH_HPP_
+#define HOST_BENCH_BENCH_HPP_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <freertos_cpp/Task.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace bench {
+
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   *  Default number of operations timed per benchmark.
+   */
+  static constexpr uint32_t ITERATIONS = 20000;
+
+  /**
+   *  Priority the benchmarks run at. Partner tasks that must answer
+   *  immediately use a higher one.
+   */
+  static constexpr uint8_t RUNNER_PRIORITY = 2;
+  static constexpr uint8_t PARTNER_PRIORITY = 3;
+
+  static constexpr uint16_t STACK_SIZE = configMINIMAL_STACK_SIZE;
+
+  /**
+   *  A named benchmark. Define one as a static object in any bench source
+   *  file and it is picked up by the runner, in link order.
+   *
+   *  The function runs inside a FreeRTOS task at RUNNER_PRIORITY and
+   *  calls report() once per measured result.
+   */
+  class Benchmark {
+    public:
+      using Function = void (*)();
+
+      Benchmark(const char* name, Function function);
+
+      /**
+       *  Run every registered benchmark in turn.
+       */
+      static void runAll();
+
+    private:
+      const char* m_name;
+      Function m_function;
+      Benchmark* m_next;
+
+      static Benchmark* s_head;
+      static Benchmark* s_tail;
+  };
+
+  /**
+   *  CPU cycle counter of the host, the TSC on x86. Returns 0 where no
+   *  counter is available, results then show no cycle column.
+   */
+  inline uint64_t cycles()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  /**
+   *  Print one result line.
+   *
+   *  @param name What was measured.
+   *  @param operations How many operations elapsed covers.
+   *  @param elapsed Total wall time.
+   *  @param elapsedCycles Total cycles, 0 if not measured.
+   */
+  void report(const char* name, uint32_t operations, Clock::duration elapsed, uint64_t elapsedCycles = 0);
+
+  /**
+   *  Time operations calls of body and report the result.
+   */
+  template<typename Body>
+  inline void measure(const char* name, uint32_t operations, Body&& body)
+  {
+    const Clock::time_point start = Clock::now();
+    const uint64_t startCycles = cycles();
+    for (uint32_t i = 0; i < operations; ++i) {
+      body();
+    }
+    const uint64_t endCycles = cycles();
+    report(name, operations, Clock::now() - start, endCycles - startCycles);
+  }
+
+  /**
+   *  Helper task running a plain function, used as the other end of
+   *  ping-pong benchmarks. Once the function returns the task suspends
+   *  itself instead of exiting.
+   */
+  class Partner : public freertos::Task {
+    public:
+      using Body = void (*)();
+
+      Partner(const char* name, Body body, uint8_t priority = PARTNER_PRIORITY);
+
+    protected:
+      void run() override;
+
+    private:
+      std::array<StackType_t, STACK_SIZE> m_stack{};
+      Body m_body;
+  };
+
+} // namespace bench
+
+#endif /* HOST_BENCH_BENCH_HPP_ */
@@ -0,0 +1,58 @@
+/*
+ * ChannelBench.cpp
+ *
+ *  Per message cost of Channel against copying frames through a TypedQueue.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/Channel.hpp>
+#include <freertos_cpp/TypedQueue.hpp>
+
+#include <array>
+#include <cstdint>
+
+using namespace bench;
+
+namespace {
+
+  template<size_t Size>
+  struct Frame {
+    std::array<uint8_t, Size> bytes;
+  };
+
+  /**
+   *  Send and receive one frame of Size bytes on the same task, once by
+   *  copy and once by handle. The producer touches the first byte so both
+   *  paths write into the payload.
+   */
+  template<size_t Size>
+  void measureFrame(const char* copyName, const char* channelName)
+  {
+    static freertos::TypedQueue<Frame<Size>, 4> queue{};
+    static freertos::Channel<Frame<Size>, 4> channel{};
+    static Frame<Size> frame{};
+
+    measure(copyName, ITERATIONS, [] {
+      Frame<Size> received;
+      frame.bytes[0]++;
+      queue.enqueue(frame, 0);
+      queue.dequeue(received, 0);
+    });
+
+    measure(channelName, ITERATIONS, [] {
+      auto message = channel.acquire();
+      message->bytes[0] = 1;
+      channel.send(message, 0);
+      auto received = channel.receive(0);
+    });
+  }
+
+  Benchmark channelBench{"channel", [] {
+    measureFrame<16>("TypedQueue copy, 16 byte frame", "Channel handle, 16 byte frame");
+    measureFrame<64>("TypedQueue copy, 64 byte frame", "Channel handle, 64 byte frame");
+    measureFrame<256>("TypedQueue copy, 256 byte frame", "Channel handle, 256 byte frame");
+    measureFrame<1024>("TypedQueue copy, 1024 byte frame", "Channel handle, 1024 byte frame");
+  }};
+
+} // namespace
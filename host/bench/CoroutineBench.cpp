@@ -0,0 +1,222 @@
+/*
+ * CoroutineBench.cpp
+ *
+ *  Job switches and waits on one Executor against task context switches.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/Coroutine.hpp>
+
+#include <array>
+#include <cstdio>
+
+using namespace bench;
+using freertos::Executor;
+using freertos::Job;
+
+namespace {
+
+  // Sized for the host, 64 bit pointers and ticks make the frames about a
+  // third larger than on the target.
+  constexpr size_t FRAME_SIZE = 512;
+  constexpr size_t MACHINE_FRAME_SIZE = 256;
+  constexpr size_t MACHINES = 48;
+
+  freertos::StaticExecutor<FRAME_SIZE, 4> executor{};
+  freertos::StaticExecutor<MACHINE_FRAME_SIZE, MACHINES> machines{};
+
+  FREERTOS_COROUTINE_BEGIN
+  Job yielder(Executor& ex, uint32_t rounds)
+  {
+    for (uint32_t i = 0; i < rounds; ++i) {
+      co_await ex.yield();
+    }
+  }
+  FREERTOS_COROUTINE_END
+
+  std::array<uint32_t, 4> pingStorage{};
+  std::array<uint32_t, 4> pongStorage{};
+  freertos::Queue ping = freertos::makeQueue(pingStorage);
+  freertos::Queue pong = freertos::makeQueue(pongStorage);
+
+  FREERTOS_COROUTINE_BEGIN
+  Job queueClient(Executor& ex, uint32_t rounds)
+  {
+    for (uint32_t i = 0; i < rounds; ++i) {
+      uint32_t value = i;
+      (void) ping.enqueue(&value, 0);
+      (void) co_await ex.receive(pong, &value, portMAX_DELAY);
+    }
+  }
+  FREERTOS_COROUTINE_END
+
+  FREERTOS_COROUTINE_BEGIN
+  Job queueEcho(Executor& ex, uint32_t rounds)
+  {
+    for (uint32_t i = 0; i < rounds; ++i) {
+      uint32_t value = 0;
+      (void) co_await ex.receive(ping, &value, portMAX_DELAY);
+      (void) pong.enqueue(&value, 0);
+    }
+  }
+  FREERTOS_COROUTINE_END
+
+  /**
+   *  A task handing bits to a job, the way an ISR or driver task would.
+   */
+  freertos::BinarySemaphore request{};
+
+  void bitsPartner()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      request.take();
+      executor.notify(1U << (i % 2));
+    }
+  }
+
+  FREERTOS_COROUTINE_BEGIN
+  Job bitsWaiter(Executor& ex, uint32_t rounds)
+  {
+    for (uint32_t i = 0; i < rounds; ++i) {
+      request.give();
+      const uint32_t bits = co_await ex.waitBits(1U << (i % 2));
+      configASSERT(bits == 1U << (i % 2));
+      (void) bits;
+    }
+  }
+  FREERTOS_COROUTINE_END
+
+  /**
+   *  A task sending to a queue a job waits on. Nothing polls the queue,
+   *  the task wakes the executor after each send.
+   */
+  std::array<uint32_t, 4> fromTaskStorage{};
+  freertos::Queue fromTask = freertos::makeQueue(fromTaskStorage);
+
+  void queuePartner()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      request.take();
+      uint32_t value = i;
+      (void) fromTask.enqueue(&value);
+      executor.wake();
+    }
+  }
+
+  FREERTOS_COROUTINE_BEGIN
+  Job queueReceiver(Executor& ex, uint32_t rounds)
+  {
+    for (uint32_t i = 0; i < rounds; ++i) {
+      request.give();
+      uint32_t value = UINT32_MAX;
+      const bool received = co_await ex.receive(fromTask, &value, portMAX_DELAY);
+      configASSERT(received && value == i);
+      (void) received;
+    }
+  }
+  FREERTOS_COROUTINE_END
+
+  /**
+   *  A protocol state machine stand in: waits a few ticks per state.
+   */
+  uint32_t lateWakeups = 0;
+
+  FREERTOS_COROUTINE_BEGIN
+  Job machine(Executor& ex, TickType_t period, uint32_t states)
+  {
+    for (uint32_t state = 0; state < states; ++state) {
+      const TickType_t before = xTaskGetTickCount();
+      co_await ex.delay(period);
+      if (xTaskGetTickCount() - before < period) {
+        ++lateWakeups;
+      }
+    }
+  }
+  FREERTOS_COROUTINE_END
+
+  freertos::BinarySemaphore neverGiven{};
+  std::array<uint8_t, 16> streamStorage{};
+  freertos::StreamBuffer stream{streamStorage.size() - 1, 1, streamStorage.data()};
+
+  FREERTOS_COROUTINE_BEGIN
+  Job timeouts(Executor& ex)
+  {
+    const TickType_t start = xTaskGetTickCount();
+    const bool taken = co_await ex.take(neverGiven, 3);
+    std::array<uint8_t, 4> data{};
+    const size_t received = co_await ex.receive(stream, data.data(), data.size(), 3);
+    const uint32_t bits = co_await ex.waitBits(1U << 7, 3);
+    const TickType_t elapsed = xTaskGetTickCount() - start;
+
+    configASSERT(!taken && received == 0 && bits == 0 && elapsed >= 9);
+    (void) taken, (void) received, (void) bits, (void) elapsed;
+  }
+  FREERTOS_COROUTINE_END
+
+  /**
+   *  Bits sent while no run() is active, before the executor task gets
+   *  to it, must still reach the job.
+   */
+  FREERTOS_COROUTINE_BEGIN
+  Job earlyBits(Executor& ex)
+  {
+    const uint32_t bits = co_await ex.waitBits(1U << 5, 3);
+    configASSERT(bits == 1U << 5);
+    (void) bits;
+  }
+  FREERTOS_COROUTINE_END
+
+  Benchmark coroutineBench{"coroutine", [] {
+    (void) executor.spawn(yielder(executor, ITERATIONS));
+    (void) executor.spawn(yielder(executor, ITERATIONS));
+    Clock::time_point start = Clock::now();
+    executor.run();
+    report("Job switch (co_await yield)", ITERATIONS * 2, Clock::now() - start);
+
+    (void) executor.spawn(queueClient(executor, ITERATIONS));
+    (void) executor.spawn(queueEcho(executor, ITERATIONS));
+    start = Clock::now();
+    executor.run();
+    report("Job queue round trip, same executor", ITERATIONS, Clock::now() - start);
+
+    static Partner partner{"bits", bitsPartner, PARTNER_PRIORITY};
+    partner.start(nullptr);
+    (void) executor.spawn(bitsWaiter(executor, ITERATIONS));
+    start = Clock::now();
+    executor.run();
+    report("Job waitBits round trip with a task", ITERATIONS, Clock::now() - start);
+
+    static Partner sender{"qsend", queuePartner, PARTNER_PRIORITY};
+    sender.start(nullptr);
+    (void) executor.spawn(queueReceiver(executor, ITERATIONS));
+    start = Clock::now();
+    executor.run();
+    report("Job queue round trip with a task, woken", ITERATIONS, Clock::now() - start);
+
+    bool spawned = executor.spawn(timeouts(executor));
+    configASSERT(spawned);
+    executor.run();
+
+    executor.notify(1U << 5);
+    executor.wake();
+    spawned = executor.spawn(earlyBits(executor));
+    configASSERT(spawned);
+    executor.run();
+
+    for (size_t i = 0; i < MACHINES; ++i) {
+      spawned = machines.spawn(machine(machines, 1 + i % 4, 10));
+      configASSERT(spawned);
+    }
+    const freertos::BlockPoolStats frames = machines.frameStats();
+    machines.run();
+    configASSERT(lateWakeups == 0);
+    (void) spawned;
+
+    std::printf("# coroutine: %zu state machine jobs in %zu frames of %zu bytes, %zu bytes each in use\n",
+        MACHINES, frames.inUse, MACHINE_FRAME_SIZE, machines.largestFrame());
+    std::printf("# coroutine: %zu tasks with 128 word stacks would need %zu bytes of stack\n",
+        MACHINES, MACHINES * 128 * sizeof(uint32_t));
+  }};
+
+} // namespace
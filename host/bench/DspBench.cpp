@@ -0,0 +1,400 @@
+/*
+ * DspBench.cpp
+ *
+ *  DSP kernels checked against the portable references, bit for bit in
+ *  fixed point and within error bounds in float, then timed per sample.
+ */
+
+#include "Bench.hpp"
+
+#include <dsp/Biquad.hpp>
+#include <dsp/Fft.hpp>
+#include <dsp/Fir.hpp>
+#include <dsp/Reference.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+
+using namespace bench;
+using dsp::q15_t;
+using dsp::q31_t;
+
+namespace {
+
+  constexpr size_t SAMPLES = 1000;
+  constexpr size_t TAPS = 31;
+  constexpr size_t FACTOR = 4;
+  constexpr size_t FFT_SIZE = 256;
+
+  /**
+   *  Noise plus two tones at 0.7 of full scale, the same sequence on every
+   *  run.
+   */
+  std::array<float, SAMPLES> makeSignal()
+  {
+    std::array<float, SAMPLES> signal{};
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < SAMPLES; ++i) {
+      seed = seed * 1664525U + 1013904223U;
+      const double noise = static_cast<double>(seed >> 8) / 16777216.0 - 0.5;
+      const double t = static_cast<double>(i);
+      signal[i] = static_cast<float>(0.3 * std::sin(0.05 * t) + 0.2 * std::sin(0.9 * t) + 0.2 * noise);
+    }
+    return signal;
+  }
+
+  /**
+   *  Hamming windowed sinc low pass, unity DC gain.
+   */
+  template<size_t Taps>
+  std::array<double, Taps> lowPass(double cutoff)
+  {
+    std::array<double, Taps> h{};
+    double sum = 0.0;
+    for (size_t k = 0; k < Taps; ++k) {
+      const double m = static_cast<double>(k) - static_cast<double>(Taps - 1) / 2.0;
+      const double sinc = m == 0.0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * m) / (M_PI * m);
+      h[k] = sinc * (0.54 - 0.46 * std::cos(2.0 * M_PI * static_cast<double>(k) / static_cast<double>(Taps - 1)));
+      sum += h[k];
+    }
+    for (double& value : h) {
+      value /= sum;
+    }
+    return h;
+  }
+
+  template<typename Sample>
+  Sample toFixed(double value)
+  {
+    constexpr double scale = sizeof(Sample) == sizeof(q15_t) ? 32768.0 : 2147483648.0;
+    const double scaled = std::round(value * scale);
+    const double limited = std::fmin(std::fmax(scaled, -scale), scale - 1.0);
+    return static_cast<Sample>(limited);
+  }
+
+  template<typename Sample, size_t N>
+  std::array<Sample, N> convert(const std::array<float, N>& values, double gain = 1.0)
+  {
+    std::array<Sample, N> out{};
+    for (size_t i = 0; i < N; ++i) {
+      if constexpr (std::is_floating_point_v<Sample>) {
+        out[i] = static_cast<Sample>(gain * static_cast<double>(values[i]));
+      } else {
+        out[i] = toFixed<Sample>(gain * static_cast<double>(values[i]));
+      }
+    }
+    return out;
+  }
+
+  template<typename Sample, size_t N>
+  std::array<Sample, N> convert(const std::array<double, N>& values)
+  {
+    std::array<Sample, N> out{};
+    for (size_t i = 0; i < N; ++i) {
+      if constexpr (std::is_floating_point_v<Sample>) {
+        out[i] = static_cast<Sample>(values[i]);
+      } else {
+        out[i] = toFixed<Sample>(values[i]);
+      }
+    }
+    return out;
+  }
+
+  template<typename Sample, size_t N>
+  bool identical(const std::array<Sample, N>& a, const std::array<Sample, N>& b, size_t count = N)
+  {
+    for (size_t i = 0; i < count; ++i) {
+      if (a[i] != b[i]) {
+        std::printf("# dsp: mismatch at %zu: %ld != %ld\n", i, static_cast<long>(a[i]), static_cast<long>(b[i]));
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template<size_t N>
+  double maxError(const std::array<float, N>& a, const std::array<float, N>& b, size_t count = N)
+  {
+    double worst = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+      worst = std::fmax(worst, std::fabs(static_cast<double>(a[i]) - static_cast<double>(b[i])));
+    }
+    return worst;
+  }
+
+  const std::array<float, SAMPLES> signal = makeSignal();
+  const std::array<double, TAPS> taps = lowPass<TAPS>(0.1);
+
+  void checkFir()
+  {
+    const auto h = convert<float>(taps);
+    std::array<float, SAMPLES> kernel{};
+    std::array<float, SAMPLES> reference{};
+    dsp::Fir<float, TAPS> fir{h};
+    fir.process(signal.data(), kernel.data(), SAMPLES);
+    dsp::reference::fir(h.data(), TAPS, signal.data(), reference.data(), SAMPLES);
+    const double floatError = maxError(kernel, reference);
+    configASSERT(floatError < 1e-6);
+
+    const auto h15 = convert<q15_t>(taps);
+    const auto x15 = convert<q15_t>(signal);
+    std::array<q15_t, SAMPLES> kernel15{};
+    std::array<q15_t, SAMPLES> reference15{};
+    dsp::Fir<q15_t, TAPS> fir15{h15};
+    fir15.process(x15.data(), kernel15.data(), SAMPLES);
+    dsp::reference::fir(h15.data(), TAPS, x15.data(), reference15.data(), SAMPLES);
+    const bool exact15 = identical(kernel15, reference15);
+    configASSERT(exact15);
+
+    // log2(31) - 1 bits of headroom for the 2.62 accumulator.
+    const auto h31 = convert<q31_t>(taps);
+    const auto x31 = convert<q31_t>(signal, 1.0 / 16.0);
+    std::array<q31_t, SAMPLES> kernel31{};
+    std::array<q31_t, SAMPLES> reference31{};
+    dsp::Fir<q31_t, TAPS> fir31{h31};
+    fir31.process(x31.data(), kernel31.data(), SAMPLES);
+    dsp::reference::fir(h31.data(), TAPS, x31.data(), reference31.data(), SAMPLES);
+    const bool exact31 = identical(kernel31, reference31);
+    configASSERT(exact31);
+
+    std::printf("# dsp: FIR %zu taps, float max error %.2e, Q15 %s, Q31 %s\n", TAPS, floatError,
+        exact15 ? "bit exact" : "MISMATCH", exact31 ? "bit exact" : "MISMATCH");
+  }
+
+  void checkDecimator()
+  {
+    constexpr size_t OUTPUTS = SAMPLES / FACTOR;
+
+    const auto h = convert<float>(taps);
+    std::array<float, SAMPLES> kernel{};
+    std::array<float, SAMPLES> reference{};
+    dsp::FirDecimator<float, TAPS, FACTOR> decimator{h};
+    const size_t written = decimator.process(signal.data(), kernel.data(), SAMPLES);
+    configASSERT(written == OUTPUTS);
+    (void) written;
+    dsp::reference::firDecimate(h.data(), TAPS, FACTOR, signal.data(), reference.data(), SAMPLES);
+    const double floatError = maxError(kernel, reference, OUTPUTS);
+    configASSERT(floatError < 1e-6);
+
+    const auto h15 = convert<q15_t>(taps);
+    const auto x15 = convert<q15_t>(signal);
+    std::array<q15_t, SAMPLES> kernel15{};
+    std::array<q15_t, SAMPLES> reference15{};
+    dsp::FirDecimator<q15_t, TAPS, FACTOR> decimator15{h15};
+    (void) decimator15.process(x15.data(), kernel15.data(), SAMPLES);
+    dsp::reference::firDecimate(h15.data(), TAPS, FACTOR, x15.data(), reference15.data(), SAMPLES);
+    const bool exact15 = identical(kernel15, reference15, OUTPUTS);
+    configASSERT(exact15);
+
+    const auto h31 = convert<q31_t>(taps);
+    const auto x31 = convert<q31_t>(signal, 1.0 / 16.0);
+    std::array<q31_t, SAMPLES> kernel31{};
+    std::array<q31_t, SAMPLES> reference31{};
+    dsp::FirDecimator<q31_t, TAPS, FACTOR> decimator31{h31};
+    (void) decimator31.process(x31.data(), kernel31.data(), SAMPLES);
+    dsp::reference::firDecimate(h31.data(), TAPS, FACTOR, x31.data(), reference31.data(), SAMPLES);
+    const bool exact31 = identical(kernel31, reference31, OUTPUTS);
+    configASSERT(exact31);
+
+    std::printf("# dsp: decimate by %zu, float max error %.2e, Q15 %s, Q31 %s\n", FACTOR, floatError,
+        exact15 ? "bit exact" : "MISMATCH", exact31 ? "bit exact" : "MISMATCH");
+  }
+
+  /**
+   *  Two section Butterworth low pass at 0.05 fs. Coefficients up to 2
+   *  need one bit of post shift in fixed point.
+   */
+  constexpr std::array<std::array<double, 5>, 2> SECTIONS{{
+      {0.0004165992, 0.0008331984, 0.0004165992, -1.6692031429, 0.7166338735},
+      {1.0, 2.0, 1.0, -1.8208650973, 0.8781188960},
+  }};
+
+  template<typename Sample>
+  std::array<typename dsp::BiquadCascade<Sample, 2>::Section, 2> sections(double scale)
+  {
+    std::array<typename dsp::BiquadCascade<Sample, 2>::Section, 2> out{};
+    for (size_t stage = 0; stage < 2; ++stage) {
+      for (size_t i = 0; i < 5; ++i) {
+        if constexpr (std::is_floating_point_v<Sample>) {
+          out[stage][i] = static_cast<Sample>(SECTIONS[stage][i]);
+        } else {
+          out[stage][i] = toFixed<Sample>(SECTIONS[stage][i] * scale);
+        }
+      }
+    }
+    return out;
+  }
+
+  void checkBiquad()
+  {
+    const auto c = sections<float>(1.0);
+    std::array<float, SAMPLES> kernel{};
+    std::array<float, SAMPLES> reference{};
+    dsp::BiquadCascade<float, 2> filter{c};
+    filter.process(signal.data(), kernel.data(), SAMPLES);
+    dsp::reference::biquad(c[0].data(), 2, 0, signal.data(), reference.data(), SAMPLES);
+    const double floatError = maxError(kernel, reference);
+    configASSERT(floatError < 1e-4);
+
+    const auto c15 = sections<q15_t>(0.5);
+    const auto x15 = convert<q15_t>(signal);
+    std::array<q15_t, SAMPLES> kernel15{};
+    std::array<q15_t, SAMPLES> reference15{};
+    dsp::BiquadCascade<q15_t, 2> filter15{c15, 1};
+    filter15.process(x15.data(), kernel15.data(), SAMPLES);
+    dsp::reference::biquad(c15[0].data(), 2, 1, x15.data(), reference15.data(), SAMPLES);
+    const bool exact15 = identical(kernel15, reference15);
+    configASSERT(exact15);
+
+    const auto c31 = sections<q31_t>(0.5);
+    const auto x31 = convert<q31_t>(signal, 0.25);
+    std::array<q31_t, SAMPLES> kernel31{};
+    std::array<q31_t, SAMPLES> reference31{};
+    dsp::BiquadCascade<q31_t, 2> filter31{c31, 1};
+    filter31.process(x31.data(), kernel31.data(), SAMPLES);
+    dsp::reference::biquad(c31[0].data(), 2, 1, x31.data(), reference31.data(), SAMPLES);
+    const bool exact31 = identical(kernel31, reference31);
+    configASSERT(exact31);
+
+    std::printf("# dsp: biquad 2 sections, float max error %.2e, Q15 %s, Q31 %s\n", floatError,
+        exact15 ? "bit exact" : "MISMATCH", exact31 ? "bit exact" : "MISMATCH");
+  }
+
+  /**
+   *  Largest bin error against the double DFT, relative to the largest
+   *  bin.
+   */
+  template<typename Sample, size_t N>
+  double spectrumError(const std::array<Sample, N + 2>& spectrum, double scale)
+  {
+    std::array<double, N> x{};
+    for (size_t i = 0; i < N; ++i) {
+      x[i] = static_cast<double>(signal[i]);
+    }
+    std::array<double, N + 2> exact{};
+    dsp::reference::dft(x.data(), exact.data(), N);
+
+    double peak = 0.0;
+    double worst = 0.0;
+    for (size_t i = 0; i < N + 2; ++i) {
+      peak = std::fmax(peak, std::fabs(exact[i]));
+      worst = std::fmax(worst, std::fabs(static_cast<double>(spectrum[i]) * scale - exact[i]));
+    }
+    return worst / peak;
+  }
+
+  void checkFft()
+  {
+    using Fft = dsp::RealFft<float, FFT_SIZE>;
+    Fft::Input input{};
+    std::copy(signal.begin(), signal.begin() + FFT_SIZE, input.begin());
+    Fft::Spectrum spectrum{};
+    Fft::forward(input, spectrum);
+    const double floatError = spectrumError<float, FFT_SIZE>(spectrum, 1.0);
+    configASSERT(floatError < 1e-5);
+
+    using Fft15 = dsp::RealFft<q15_t, FFT_SIZE>;
+    Fft15::Input input15{};
+    for (size_t i = 0; i < FFT_SIZE; ++i) {
+      input15[i] = toFixed<q15_t>(static_cast<double>(signal[i]));
+    }
+    Fft15::Spectrum kernel15{};
+    Fft15::Spectrum reference15{};
+    std::array<dsp::reference::detail::Complex<q15_t>, FFT_SIZE / 2 + 1> scratch15{};
+    Fft15::forward(input15, kernel15);
+    dsp::reference::rfft(input15.data(), reference15.data(), FFT_SIZE, Fft15::twiddles.data(), scratch15.data());
+    const bool exact15 = identical(kernel15, reference15);
+    const double error15 = spectrumError<q15_t, FFT_SIZE>(kernel15, FFT_SIZE / 32768.0);
+    configASSERT(exact15 && error15 < 2e-2);
+
+    using Fft31 = dsp::RealFft<q31_t, FFT_SIZE>;
+    Fft31::Input input31{};
+    for (size_t i = 0; i < FFT_SIZE; ++i) {
+      input31[i] = toFixed<q31_t>(static_cast<double>(signal[i]));
+    }
+    Fft31::Spectrum kernel31{};
+    Fft31::Spectrum reference31{};
+    std::array<dsp::reference::detail::Complex<q31_t>, FFT_SIZE / 2 + 1> scratch31{};
+    Fft31::forward(input31, kernel31);
+    dsp::reference::rfft(input31.data(), reference31.data(), FFT_SIZE, Fft31::twiddles.data(), scratch31.data());
+    const bool exact31 = identical(kernel31, reference31);
+    const double error31 = spectrumError<q31_t, FFT_SIZE>(kernel31, FFT_SIZE / 2147483648.0);
+    configASSERT(exact31 && error31 < 1e-6);
+
+    std::printf("# dsp: real FFT %zu, error vs DFT float %.2e, Q15 %.2e (%s), Q31 %.2e (%s)\n", FFT_SIZE,
+        floatError, error15, exact15 ? "bit exact" : "MISMATCH", error31, exact31 ? "bit exact" : "MISMATCH");
+  }
+
+  /**
+   *  Time rounds passes over a block and report per sample.
+   */
+  template<typename Body>
+  void perSample(const char* name, uint32_t samples, uint32_t rounds, Body&& body)
+  {
+    const Clock::time_point start = Clock::now();
+    const uint64_t startCycles = cycles();
+    for (uint32_t i = 0; i < rounds; ++i) {
+      body();
+    }
+    const uint64_t endCycles = cycles();
+    report(name, samples * rounds, Clock::now() - start, endCycles - startCycles);
+  }
+
+  constexpr size_t BLOCK = 256;
+  constexpr uint32_t ROUNDS = 200;
+
+  template<typename Sample>
+  void timeFilters(const char* format)
+  {
+    const auto x = convert<Sample>(signal, std::is_same_v<Sample, q31_t> ? 1.0 / 16.0 : 1.0);
+    std::array<Sample, BLOCK> y{};
+    char name[64];
+
+    dsp::Fir<Sample, TAPS> fir{convert<Sample>(taps)};
+    std::snprintf(name, sizeof(name), "FIR %zu taps %s", TAPS, format);
+    perSample(name, BLOCK, ROUNDS, [&] {
+      fir.process(x.data(), y.data(), BLOCK);
+    });
+
+    const auto h = convert<Sample>(taps);
+    std::array<Sample, SAMPLES> z{};
+    std::snprintf(name, sizeof(name), "FIR %zu taps %s, reference", TAPS, format);
+    perSample(name, BLOCK, ROUNDS, [&] {
+      dsp::reference::fir(h.data(), TAPS, x.data(), z.data(), BLOCK);
+    });
+
+    dsp::FirDecimator<Sample, TAPS, FACTOR> decimator{h};
+    std::snprintf(name, sizeof(name), "FIR decimate by %zu %s", FACTOR, format);
+    perSample(name, BLOCK, ROUNDS, [&] {
+      (void) decimator.process(x.data(), y.data(), BLOCK);
+    });
+
+    dsp::BiquadCascade<Sample, 2> biquad{sections<Sample>(0.5), 1};
+    std::snprintf(name, sizeof(name), "biquad 2 sections %s", format);
+    perSample(name, BLOCK, ROUNDS, [&] {
+      biquad.process(x.data(), y.data(), BLOCK);
+    });
+
+    using Fft = dsp::RealFft<Sample, FFT_SIZE>;
+    typename Fft::Input input{};
+    std::copy(x.begin(), x.begin() + FFT_SIZE, input.begin());
+    typename Fft::Spectrum spectrum{};
+    std::snprintf(name, sizeof(name), "real FFT %zu %s", FFT_SIZE, format);
+    perSample(name, FFT_SIZE, ROUNDS, [&] {
+      Fft::forward(input, spectrum);
+    });
+  }
+
+  Benchmark dspBench{"dsp (ops are samples)", [] {
+    checkFir();
+    checkDecimator();
+    checkBiquad();
+    checkFft();
+
+    timeFilters<float>("float");
+    timeFilters<q15_t>("Q15");
+    timeFilters<q31_t>("Q31");
+  }};
+
+} // namespace
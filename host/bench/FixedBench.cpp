@@ -0,0 +1,127 @@
+/*
+ * FixedBench.cpp
+ *
+ *  Fixed point arithmetic checked at compile and run time, and a PI
+ *  control loop in fixed point against the same loop in float.
+ */
+
+#include "Bench.hpp"
+
+#include <dsp/Fixed.hpp>
+
+#include <cmath>
+#include <cstdio>
+
+using namespace bench;
+using dsp::Fixed;
+using dsp::Q15;
+using dsp::Q31;
+
+namespace {
+
+  using Q3_12 = Fixed<int16_t, 12>;
+  using Q4_11 = Fixed<int16_t, 11>;
+  using Q11_20 = Fixed<int32_t, 20>;
+  using Q7_24 = Fixed<int32_t, 24>;
+
+  // Conversions and constants are folded by the compiler.
+  static_assert(Q15{0.5}.raw() == 16384);
+  static_assert(Q15{1.0} == Q15::max() && Q15{-1.0}.raw() == INT16_MIN);
+  static_assert(Q15{-0.5 / 32768.0}.raw() == -1);
+  static_assert(static_cast<float>(Q15{0.25}) == 0.25F);
+  static_assert(Q3_12{Q15{0.5}}.raw() == 2048 && Q15{Q3_12{4.0}} == Q15::max());
+  static_assert(Q31{Q15{-0.5}}.raw() == INT32_MIN / 2);
+
+  // Saturation instead of wrap around.
+  static_assert(Q15{0.75} + Q15{0.5} == Q15::max());
+  static_assert(Q15{-0.75} - Q15{0.5} == Q15::min());
+  static_assert(-Q15::min() == Q15::max() && -Q31::min() == Q31::max());
+  static_assert(Q15{-1.0} * Q15{-1.0} == Q15::max() && Q31{-1.0} * Q31{-1.0} == Q31::max());
+
+  // Products round to nearest.
+  static_assert((Q15{0.5} * Q15{0.5}).raw() == 8192);
+  static_assert((Q15::epsilon() * Q15{0.5}).raw() == 1 && (-Q15::epsilon() * Q15{0.5}).raw() == -1);
+  static_assert(dsp::multiply<Q11_20>(Q3_12{3.0}, Q4_11{-2.5}) == Q11_20{-7.5});
+
+  static_assert(Q15{0.25} < Q15{0.5} && Q15{0.5} >= Q15{0.5});
+
+  /**
+   *  The same checks with operands the compiler cannot see, through the
+   *  run time path: SSAT and QADD on the M4.
+   */
+  void checkRuntime()
+  {
+    volatile int16_t a16 = 24576;
+    volatile int16_t b16 = 16384;
+    volatile int32_t a31 = INT32_MAX - 5;
+    volatile int32_t b31 = 10;
+
+    const Q15 a = Q15::fromRaw(a16);
+    const Q15 b = Q15::fromRaw(b16);
+    const Q31 c = Q31::fromRaw(a31);
+    const Q31 d = Q31::fromRaw(b31);
+
+    configASSERT(a + b == Q15::max());
+    configASSERT(-a - b == Q15::min());
+    configASSERT((a * b).raw() == 12288);
+    configASSERT(c + d == Q31::max());
+    configASSERT(-c - d - d == Q31::min());
+    configASSERT(-Q15::fromRaw(static_cast<int16_t>(-a16 - b16 + 8192)) == Q15::max());
+    (void) a, (void) b, (void) c, (void) d;
+  }
+
+  /**
+   *  PI controller driving a first order plant, the kind of loop that
+   *  runs in a timer ISR.
+   */
+  template<typename T>
+  struct Loop {
+    T kp;
+    T ki;
+    T alpha;
+    T integral{};
+    T output{};
+
+    T step(T setpoint)
+    {
+      const T error = setpoint - output;
+      integral += ki * error;
+      const T drive = kp * error + integral;
+      output += alpha * (drive - output);
+      return output;
+    }
+  };
+
+  constexpr uint32_t STEPS = 200000;
+
+  template<typename T>
+  double run(const char* name, T setpoint)
+  {
+    Loop<T> controller{T{0.5}, T{0.02}, T{0.1}};
+    measure(name, STEPS, [&] {
+      (void) controller.step(setpoint);
+    });
+    return static_cast<double>(controller.output);
+  }
+
+  Benchmark fixedBench{"fixed point", [] {
+    checkRuntime();
+
+    const double floatOutput = run<float>("PI loop step, float", 0.6F);
+    const double q15Output = run<Q15>("PI loop step, Q15", Q15{0.6});
+    const double q3Output = run<Q3_12>("PI loop step, Q3.12", Q3_12{0.6});
+    const double q31Output = run<Q7_24>("PI loop step, Q7.24", Q7_24{0.6});
+
+    // The fixed point integrators stop once ki * error rounds to zero,
+    // a dead band of 0.5 / ki steps of the format.
+    const auto deadBand = [](double epsilon) { return (0.5 / 0.02 + 1.0) * epsilon; };
+    configASSERT(std::fabs(floatOutput - 0.6) < 1e-4);
+    configASSERT(std::fabs(q15Output - 0.6) < deadBand(1.0 / 32768.0));
+    configASSERT(std::fabs(q3Output - 0.6) < deadBand(1.0 / 4096.0));
+    configASSERT(std::fabs(q31Output - 0.6) < deadBand(1.0 / 16777216.0) + 1e-6);
+    (void) deadBand;
+    std::printf("# fixed point: PI loop settles at float %.6f, Q15 %.6f, Q3.12 %.6f, Q7.24 %.6f\n",
+        floatOutput, q15Output, q3Output, q31Output);
+  }};
+
+} // namespace
@@ -0,0 +1,148 @@
+/*
+ * FlightRecorderBench.cpp
+ *
+ *  Flight recorder round trip through a simulated reset, the kernel hook
+ *  recording real context switches, and the cost of one event.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/FlightRecorder.hpp>
+
+#include <cstdio>
+
+using namespace bench;
+using freertos::FaultRegisters;
+using freertos::FlightEvent;
+using freertos::FlightLog;
+using freertos::FlightRecord;
+using freertos::FlightRecorder;
+
+namespace {
+
+  /**
+   *  Stands in for the backup SRAM, given a garbage magic below like the
+   *  target finds after power up.
+   */
+  FlightLog memory;
+  FlightLog previous;
+
+  constexpr uint32_t EVENTS = FlightLog::CAPACITY + 100;
+
+  void checkRoundTrip()
+  {
+    memory.magic = 0xDEADBEEF;
+
+    {
+      FlightRecorder recorder{memory};
+      configASSERT(!recorder.begin(previous, 0x24000000));
+      configASSERT(!FlightRecorder::isValid(previous));
+
+      for (uint32_t i = 0; i < EVENTS; ++i) {
+        recorder.record(i % 2 == 0 ? FlightEvent::Mark : FlightEvent::Log, i);
+      }
+
+      FaultRegisters fault{};
+      fault.cfsr = 0x00008200;
+      fault.pc = 0x08001234;
+      fault.excReturn = 0xFFFFFFFD;
+      recorder.recordFault(fault);
+    }
+
+    // Reset: a new recorder over the same memory finds the session.
+    FlightRecorder recorder{memory};
+    configASSERT(recorder.begin(previous, 0x04000000));
+    configASSERT(FlightRecorder::isValid(previous));
+    configASSERT(previous.sessions == 1 && previous.resetFlags == 0x24000000);
+    configASSERT(previous.faulted != 0 && previous.fault.pc == 0x08001234 && previous.fault.cfsr == 0x00008200);
+    configASSERT(FlightRecorder::size(previous) == FlightLog::CAPACITY);
+
+    // Oldest first, the ones that were overwritten are gone.
+    uint32_t expected = EVENTS + 1 - FlightLog::CAPACITY;
+    uint32_t lastTimestamp = 0;
+    FlightRecorder::forEach(previous, [&](const FlightRecord& record) {
+      configASSERT(record.timestamp >= lastTimestamp);
+      lastTimestamp = record.timestamp;
+      if (expected == EVENTS) {
+        configASSERT(record.event() == FlightEvent::Fault && record.payload() == 0x00008200);
+      } else {
+        configASSERT(record.event() == (expected % 2 == 0 ? FlightEvent::Mark : FlightEvent::Log));
+        configASSERT(record.payload() == expected);
+      }
+      ++expected;
+    });
+    configASSERT(expected == EVENTS + 1);
+
+    // The new session starts empty, counted on from the old one.
+    configASSERT(memory.sessions == 2 && memory.resetFlags == 0x04000000);
+    configASSERT(FlightRecorder::size(memory) == 0 && memory.faulted == 0);
+
+    // Payloads keep their low 28 bits.
+    recorder.record(FlightEvent::Mark, 0xFFFFFFFF);
+    FlightRecorder::forEach(memory, [](const FlightRecord& record) {
+      configASSERT(record.event() == FlightEvent::Mark && record.payload() == FlightRecord::PAYLOAD_MASK);
+      (void) record;
+    });
+
+    recorder.stop();
+    recorder.record(FlightEvent::Mark, 1);
+    configASSERT(FlightRecorder::size(memory) == 1);
+  }
+
+  /**
+   *  The system recorder, fed by traceTASK_SWITCHED_IN, sees the switches
+   *  between the runner and a partner it wakes.
+   */
+  uint32_t checkKernelHook()
+  {
+    FlightRecorder& recorder = FlightRecorder::system();
+    (void) FlightRecorder::start(previous);
+
+    static Partner wakeup{"flight", [] {
+      loop {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      }
+    }};
+    (void) wakeup.start(nullptr);
+
+    constexpr uint32_t WAKEUPS = 20;
+    for (uint32_t i = 0; i < WAKEUPS; ++i) {
+      xTaskNotifyGive(wakeup.getHandle());
+    }
+    recorder.stop();
+
+    const uint32_t runner = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(xTaskGetCurrentTaskHandle()))
+        & FlightRecord::PAYLOAD_MASK;
+    const uint32_t other = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(wakeup.getHandle()))
+        & FlightRecord::PAYLOAD_MASK;
+
+    uint32_t toRunner = 0;
+    uint32_t toPartner = 0;
+    FlightRecorder::forEach(recorder.log(), [&](const FlightRecord& record) {
+      if (record.event() != FlightEvent::TaskSwitch) {
+        return;
+      }
+      toRunner += record.payload() == runner ? 1U : 0U;
+      toPartner += record.payload() == other ? 1U : 0U;
+    });
+    configASSERT(toPartner >= WAKEUPS && toRunner >= WAKEUPS);
+    (void) toRunner;
+    return toPartner;
+  }
+
+  Benchmark flightRecorderBench{"flight recorder", [] {
+    checkRoundTrip();
+    const uint32_t switches = checkKernelHook();
+
+    FlightRecorder recorder{memory};
+    (void) recorder.begin(previous);
+    uint32_t value = 0;
+    measure("FlightRecorder::record", ITERATIONS, [&] {
+      recorder.record(FlightEvent::Mark, ++value);
+    });
+    recorder.stop();
+
+    std::printf("# flight recorder: round trip through reset ok, %u switches to the partner recorded\n", switches);
+  }};
+
+} // namespace
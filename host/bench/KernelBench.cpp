@@ -0,0 +1,378 @@
+/*
+ * KernelBench.cpp
+ *
+ *  Round trip costs of the freertos_cpp primitives.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/EventGroup.hpp>
+#include <freertos_cpp/Mutex.hpp>
+#include <freertos_cpp/Queue.hpp>
+#include <freertos_cpp/Semaphore.hpp>
+#include <freertos_cpp/SpscRing.hpp>
+#include <freertos_cpp/StreamBuffer.hpp>
+#include <freertos_cpp/TypedQueue.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+
+using namespace bench;
+
+namespace {
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Context switch: two tasks at the same priority yielding to each other.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  std::atomic<bool> yieldDone{false};
+
+  void yieldPartner()
+  {
+    while (!yieldDone.load()) {
+      taskYIELD();
+    }
+  }
+
+  Benchmark contextSwitch{"context switch", [] {
+    static Partner partner{"yield", yieldPartner, RUNNER_PRIORITY};
+    partner.start(nullptr);
+    taskYIELD();
+
+    // Every yield switches to the partner and back.
+    const Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      taskYIELD();
+    }
+    report("context switch (taskYIELD)", ITERATIONS * 2, Clock::now() - start);
+
+    yieldDone.store(true);
+    taskYIELD();
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Queue round trip: send to a higher priority echo task and wait for
+  //  the reply.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  std::array<uint32_t, 4> pingStorage{};
+  std::array<uint32_t, 4> pongStorage{};
+  freertos::Queue ping = freertos::makeQueue(pingStorage);
+  freertos::Queue pong = freertos::makeQueue(pongStorage);
+
+  void queueEcho()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      uint32_t value = 0;
+      ping.dequeue(&value);
+      pong.enqueue(&value);
+    }
+  }
+
+  freertos::TypedQueue<uint32_t, 4> typedPing{};
+  freertos::TypedQueue<uint32_t, 4> typedPong{};
+
+  void typedQueueEcho()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      uint32_t value = 0;
+      typedPing.dequeue(value);
+      typedPong.enqueue(value);
+    }
+  }
+
+  Benchmark queueRoundTrip{"queue", [] {
+    static Partner echo{"qecho", queueEcho};
+    echo.start(nullptr);
+
+    measure("queue round trip (Queue)", ITERATIONS, [] {
+      uint32_t value = 42;
+      ping.enqueue(&value);
+      pong.dequeue(&value);
+    });
+
+    static Partner typedEcho{"tqecho", typedQueueEcho};
+    typedEcho.start(nullptr);
+
+    measure("queue round trip (TypedQueue)", ITERATIONS, [] {
+      uint32_t value = 42;
+      typedPing.enqueue(value);
+      typedPong.dequeue(value);
+    });
+
+    // Without a partner: the raw cost of one send plus one receive.
+    measure("queue send+receive, no switch (Queue)", ITERATIONS, [] {
+      uint32_t value = 42;
+      ping.enqueue(&value, 0);
+      ping.dequeue(&value, 0);
+    });
+
+    measure("queue send+receive, no switch (TypedQueue)", ITERATIONS, [] {
+      uint32_t value = 42;
+      typedPing.enqueue(value, 0);
+      typedPing.dequeue(value, 0);
+    });
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Semaphore round trip.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  freertos::BinarySemaphore semaphorePing{};
+  freertos::BinarySemaphore semaphorePong{};
+
+  void semaphoreEcho()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      semaphorePing.take();
+      semaphorePong.give();
+    }
+  }
+
+  Benchmark semaphoreRoundTrip{"semaphore", [] {
+    static Partner echo{"secho", semaphoreEcho};
+    echo.start(nullptr);
+
+    measure("semaphore round trip (BinarySemaphore)", ITERATIONS, [] {
+      semaphorePing.give();
+      semaphorePong.take();
+    });
+
+    measure("semaphore give+take, no switch", ITERATIONS, [] {
+      semaphorePing.give();
+      semaphorePing.take();
+    });
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Mutex, uncontended.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  freertos::Mutex mutex{};
+
+  Benchmark mutexLockUnlock{"mutex", [] {
+    measure("mutex lock+unlock, uncontended", ITERATIONS, [] {
+      mutex.lock();
+      mutex.unlock();
+    });
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Event group round trip.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr EventBits_t PING_BIT = 1U << 0;
+  constexpr EventBits_t PONG_BIT = 1U << 1;
+
+  freertos::EventGroup events{};
+
+  void eventEcho()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      events.WaitBits(PING_BIT, true, true, portMAX_DELAY);
+      events.SetBits(PONG_BIT);
+    }
+  }
+
+  Benchmark eventGroupRoundTrip{"event group", [] {
+    static Partner echo{"eecho", eventEcho};
+    echo.start(nullptr);
+
+    measure("event group round trip", ITERATIONS, [] {
+      events.SetBits(PING_BIT);
+      events.WaitBits(PONG_BIT, true, true, portMAX_DELAY);
+    });
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Stream buffer round trip and the lock free ring next to it.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  std::array<uint8_t, 64 + 1> streamPingStorage{};
+  std::array<uint8_t, 64 + 1> streamPongStorage{};
+  freertos::StreamBuffer streamPing{64, 1, streamPingStorage.data()};
+  freertos::StreamBuffer streamPong{64, 1, streamPongStorage.data()};
+
+  void streamEcho()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      uint32_t value = 0;
+      streamPing.receive(&value, sizeof(value));
+      streamPong.send(&value, sizeof(value));
+    }
+  }
+
+  freertos::SpscRing<uint8_t, 64> ring{};
+
+  Benchmark streamBufferRoundTrip{"stream buffer", [] {
+    static Partner echo{"sbecho", streamEcho};
+    echo.start(nullptr);
+
+    measure("stream buffer round trip, 4 bytes", ITERATIONS, [] {
+      uint32_t value = 42;
+      streamPing.send(&value, sizeof(value));
+      streamPong.receive(&value, sizeof(value));
+    });
+
+    measure("stream buffer send+receive, 16 bytes, no switch", ITERATIONS, [] {
+      std::array<uint8_t, 16> bytes{};
+      streamPing.send(bytes.data(), bytes.size(), 0);
+      streamPing.receive(bytes.data(), bytes.size(), 0);
+    });
+
+    measure("SpscRing push+pop, 16 bytes", ITERATIONS, [] {
+      std::array<uint8_t, 16> bytes{};
+      ring.push(std::span<const uint8_t>(bytes));
+      ring.pop(std::span<uint8_t>(bytes));
+    });
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  SpscRing producer/consumer stress: a producer woken by every tick
+  //  pushes one byte, the consumer drains the ring and starts a blocking
+  //  receive a little before the next tick, so the push regularly lands
+  //  while the consumer is publishing itself. Every blocking receive must
+  //  return data and the bytes must arrive in order.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr uint32_t RING_ROUNDS = 4000;
+  constexpr uint32_t RING_OFFSETS = 50;
+  constexpr std::chrono::microseconds TICK_PERIOD{1000000 / configTICK_RATE_HZ};
+
+  freertos::SpscRing<uint8_t, 64> tickRing{};
+  std::atomic<bool> ringDone{false};
+
+  void ringProducer()
+  {
+    uint8_t next = 0;
+    while (!ringDone.load()) {
+      vTaskDelay(1);
+      const bool pushed = tickRing.push(next++);
+      configASSERT(pushed);
+      (void) pushed;
+    }
+  }
+
+  Benchmark spscRingStress{"spsc ring, stress", [] {
+    static Partner producer{"rproducer", ringProducer};
+
+    uint8_t expected = 0;
+    std::array<uint8_t, 64> bytes{};
+    const auto check = [&](size_t count) {
+      for (size_t i = 0; i < count; ++i) {
+        configASSERT(bytes[i] == expected);
+        ++expected;
+      }
+    };
+
+    uint32_t empty = 0;
+    producer.start(nullptr);
+    check(tickRing.receive(std::span<uint8_t>(bytes)));
+
+    const Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < RING_ROUNDS; ++i) {
+      // Woken by the push at the last tick, the next one is a period away.
+      const Clock::time_point attempt = Clock::now() + TICK_PERIOD - std::chrono::microseconds(i % RING_OFFSETS);
+      check(tickRing.pop(std::span<uint8_t>(bytes)));
+      while (Clock::now() < attempt) {
+      }
+      const size_t received = tickRing.receive(std::span<uint8_t>(bytes));
+      empty += received == 0 ? 1U : 0U;
+      check(received);
+    }
+    ringDone.store(true);
+    report("SpscRing receive, push at the tick", RING_ROUNDS, Clock::now() - start);
+    configASSERT(empty == 0 && "SpscRing::receive returned without data");
+    (void) empty;
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  SpscRing bulk stress: producer and consumer at the same priority,
+  //  time sliced against each other, move random sized chunks so single
+  //  calls regularly straddle the end of the storage. The bytes carry a
+  //  running count and must arrive in order.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr uint32_t BULK_BYTES = 2000000;
+  constexpr size_t BULK_MAX_CHUNK = 48;
+
+  freertos::SpscRing<uint8_t, 64> bulkRing{};
+  std::atomic<uint32_t> bulkPushWraps{0};
+
+  void bulkProducer()
+  {
+    std::minstd_rand random{1};
+    std::array<uint8_t, BULK_MAX_CHUNK> chunk{};
+    uint8_t next = 0;
+    uint32_t pushed = 0;
+    while (pushed < BULK_BYTES) {
+      const size_t want = std::min<size_t>(1 + random() % BULK_MAX_CHUNK, BULK_BYTES - pushed);
+      for (size_t i = 0; i < want; ++i) {
+        chunk[i] = static_cast<uint8_t>(next + i);
+      }
+      const size_t index = pushed % bulkRing.capacity;
+      const size_t written = bulkRing.push(std::span<const uint8_t>(chunk.data(), want));
+      if (index + written > bulkRing.capacity) {
+        bulkPushWraps.fetch_add(1, std::memory_order_relaxed);
+      }
+      next = static_cast<uint8_t>(next + written);
+      pushed += written;
+      if (written < want) {
+        taskYIELD();
+      }
+    }
+  }
+
+  Benchmark spscRingBulk{"spsc ring, bulk", [] {
+    static Partner producer{"rbulk", bulkProducer, RUNNER_PRIORITY};
+
+    std::minstd_rand random{2};
+    std::array<uint8_t, BULK_MAX_CHUNK> chunk{};
+    uint8_t expected = 0;
+    uint32_t popped = 0;
+    uint32_t popWraps = 0;
+
+    producer.start(nullptr);
+    const Clock::time_point start = Clock::now();
+    while (popped < BULK_BYTES) {
+      const size_t want = 1 + random() % BULK_MAX_CHUNK;
+      const size_t index = popped % bulkRing.capacity;
+      const size_t count = bulkRing.pop(std::span<uint8_t>(chunk.data(), want));
+      if (index + count > bulkRing.capacity) {
+        ++popWraps;
+      }
+      for (size_t i = 0; i < count; ++i) {
+        configASSERT(chunk[i] == expected && "SpscRing bulk bytes out of order");
+        ++expected;
+      }
+      popped += count;
+      if (count < want) {
+        taskYIELD();
+      }
+    }
+    report("SpscRing random bulk push/pop, bytes", BULK_BYTES, Clock::now() - start);
+    std::printf("# spsc ring bulk: %lu pushes and %lu pops wrapped in one call, in order\n",
+                static_cast<unsigned long>(bulkPushWraps.load()), static_cast<unsigned long>(popWraps));
+    configASSERT(bulkPushWraps.load() > 0 && popWraps > 0);
+    configASSERT(bulkRing.isEmpty());
+  }};
+
+} // namespace
@@ -0,0 +1,203 @@
+/*
+ * LogBench.cpp
+ *
+ *  Binary logger: the cost of LOG() and commit() from a task, the frames
+ *  drained back out checked for marker, length and CRC, and records
+ *  dropped whole once the ring is full.
+ */
+
+#include "Bench.hpp"
+
+#include <logging/Log.hpp>
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+using namespace bench;
+
+namespace {
+
+  /**
+   *  Records with one 32 bit argument, a batch fits the ring with room to
+   *  spare so the timed calls never drop.
+   */
+  constexpr size_t RECORD_SIZE = logging::FRAME_OVERHEAD + sizeof(uint32_t);
+  constexpr uint32_t BATCH = 64;
+  static_assert(BATCH * RECORD_SIZE < logging::BUFFER_SIZE, "batch overflows the log ring");
+
+  constexpr uint32_t OVERFLOWS = 100;
+  constexpr uint32_t NEVER_STORED = 0xDEADBEEF;
+
+  std::array<uint8_t, logging::BUFFER_SIZE> drained{};
+
+  // Value of the next record logged and the next one expected back.
+  uint32_t logged = 0;
+  uint32_t checked = 0;
+
+  size_t drainAll()
+  {
+    size_t length = 0;
+    size_t count = 0;
+    while ((count = logging::drain(drained.data() + length, drained.size() - length, 0)) != 0) {
+      length += count;
+    }
+    return length;
+  }
+
+  /**
+   *  Walk drained bytes frame by frame, checking the marker, that the
+   *  length stays within the bytes and the CRC, and hand each frame's ID
+   *  and argument bytes to visit.
+   *
+   *  @return false on the first malformed frame.
+   */
+  template<typename Visit>
+  bool forEachFrame(size_t length, Visit&& visit)
+  {
+    size_t at = 0;
+    while (at < length) {
+      if (length - at < logging::FRAME_OVERHEAD || drained[at] != logging::FRAME_MARKER) {
+        return false;
+      }
+      const size_t body = drained[at + 1];
+      const size_t frame = 2 + body + logging::CRC_SIZE;
+      if (body < sizeof(uint32_t) || length - at < frame) {
+        return false;
+      }
+
+      uint16_t crc = 0;
+      std::memcpy(&crc, &drained[at + 2 + body], sizeof(crc));
+      if (crc != logging::detail::crc16(&drained[at + 1], 1 + body)) {
+        return false;
+      }
+
+      uint32_t id = 0;
+      std::memcpy(&id, &drained[at + 2], sizeof(id));
+      visit(id, &drained[at + logging::HEADER_SIZE], body - sizeof(uint32_t));
+      at += frame;
+    }
+    return true;
+  }
+
+  /**
+   *  Check drained one argument records: well formed, one ID, and the
+   *  values logged in order with none missing.
+   *
+   *  @return Number of records.
+   */
+  uint32_t checkRecords(size_t length)
+  {
+    uint32_t records = 0;
+    uint32_t firstId = 0;
+    bool sameId = true;
+    bool inOrder = true;
+    const bool wellFormed = forEachFrame(length, [&](uint32_t id, const uint8_t* arguments, size_t size) {
+      firstId = records == 0 ? id : firstId;
+      sameId = sameId && id == firstId;
+
+      uint32_t value = 0;
+      std::memcpy(&value, arguments, sizeof(value));
+      inOrder = inOrder && size == sizeof(value) && value == checked;
+      ++checked;
+      ++records;
+    });
+    configASSERT(wellFormed && sameId && inOrder);
+    (void) wellFormed;
+    return records;
+  }
+
+  /**
+   *  Time batches of body, draining and checking the records between
+   *  batches, outside the timed part.
+   */
+  template<typename Body>
+  void measureBatches(const char* name, Body&& body)
+  {
+    constexpr uint32_t rounds = ITERATIONS / BATCH;
+    Clock::duration elapsed{};
+    uint64_t elapsedCycles = 0;
+
+    for (uint32_t round = 0; round < rounds; ++round) {
+      const Clock::time_point start = Clock::now();
+      const uint64_t startCycles = cycles();
+      for (uint32_t i = 0; i < BATCH; ++i) {
+        body();
+      }
+      elapsedCycles += cycles() - startCycles;
+      elapsed += Clock::now() - start;
+
+      const uint32_t records = checkRecords(drainAll());
+      configASSERT(records == BATCH);
+      (void) records;
+    }
+    report(name, rounds * BATCH, elapsed, elapsedCycles);
+  }
+
+  /**
+   *  A record encoded by hand, as a caller of commit() would.
+   */
+  std::array<uint8_t, RECORD_SIZE> encode(uint32_t value)
+  {
+    constexpr uint32_t id = 0x1234;
+    std::array<uint8_t, RECORD_SIZE> record{};
+    record[0] = logging::FRAME_MARKER;
+    record[1] = static_cast<uint8_t>(2 * sizeof(uint32_t));
+    std::memcpy(&record[2], &id, sizeof(id));
+    std::memcpy(&record[logging::HEADER_SIZE], &value, sizeof(value));
+    const uint16_t crc = logging::detail::crc16(&record[1], RECORD_SIZE - 1 - logging::CRC_SIZE);
+    std::memcpy(&record[RECORD_SIZE - logging::CRC_SIZE], &crc, sizeof(crc));
+    return record;
+  }
+
+  Benchmark logBench{"log", [] {
+    // Nothing from earlier benchmarks in the way.
+    (void) drainAll();
+
+    measureBatches("LOG(), one 32 bit argument", [] {
+      LOG("bench: record %u", logged++);
+    });
+
+    measureBatches("logging::commit(), 12 byte record", [] {
+      const std::array<uint8_t, RECORD_SIZE> record = encode(logged++);
+      (void) logging::commit(record.data(), record.size());
+    });
+
+    // Fill the ring with nobody draining. Records that do not fit are
+    // counted and dropped whole, never stored in part.
+    const uint32_t droppedBefore = logging::dropped();
+    uint32_t stored = 0;
+    while (logging::space() >= RECORD_SIZE) {
+      LOG("bench: record %u", logged++);
+      ++stored;
+    }
+    for (uint32_t i = 0; i < OVERFLOWS; ++i) {
+      LOG("bench: record %u", NEVER_STORED);
+    }
+    const uint32_t lost = logging::dropped() - droppedBefore;
+    configASSERT(lost == OVERFLOWS);
+    const uint32_t records = checkRecords(drainAll());
+    configASSERT(records == stored);
+    (void) records;
+
+    // A blob goes in as header, payload and trailer, it must come out as
+    // one frame.
+    std::array<uint8_t, 40> blob{};
+    for (size_t i = 0; i < blob.size(); ++i) {
+      blob[i] = static_cast<uint8_t>(i * 7);
+    }
+    const bool blobStored = LOG_BLOB("bench", blob.data(), blob.size());
+    bool blobIntact = false;
+    const bool blobWellFormed = forEachFrame(drainAll(), [&](uint32_t, const uint8_t* payload, size_t size) {
+      blobIntact = size == blob.size() && std::memcmp(payload, blob.data(), size) == 0;
+    });
+    configASSERT(blobStored && blobWellFormed && blobIntact);
+    (void) blobStored;
+    (void) blobWellFormed;
+
+    std::printf("# log: %u records checked for marker, length and CRC, %u stored until the ring filled, "
+                "%u more dropped whole, %zu bytes per one argument record\n",
+                checked, stored, lost, RECORD_SIZE);
+  }};
+
+} // namespace
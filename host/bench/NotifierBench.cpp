@@ -0,0 +1,185 @@
+/*
+ * NotifierBench.cpp
+ *
+ *  Wake latency and RAM of the notification based primitives against
+ *  BinarySemaphore, and checks of their give/take semantics.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/Notifier.hpp>
+#include <freertos_cpp/Semaphore.hpp>
+
+#include <atomic>
+#include <cstdio>
+
+using namespace bench;
+
+namespace {
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Round trip: wake a higher priority task and wait to be woken back,
+  //  two wakeups per operation.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  freertos::BinarySemaphore semaphorePing{};
+  freertos::BinarySemaphore semaphorePong{};
+
+  void semaphoreEcho()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      semaphorePing.take();
+      semaphorePong.give();
+    }
+  }
+
+  void lightweightEcho();
+  void notifierEcho();
+
+  Partner lightweightPartner{"lecho", lightweightEcho};
+  Partner notifierPartner{"necho", notifierEcho};
+
+  freertos::BinaryNotifier lightweightPing{lightweightPartner};
+  freertos::Notifier notifierPing{notifierPartner};
+
+  // Bound to the runner once it is known.
+  freertos::BinaryNotifier* lightweightPong = nullptr;
+  freertos::Notifier* notifierPong = nullptr;
+
+  void lightweightEcho()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      lightweightPing.take();
+      lightweightPong->give();
+    }
+  }
+
+  void notifierEcho()
+  {
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+      (void) notifierPing.wait();
+      notifierPong->set(1);
+    }
+  }
+
+  Benchmark notifierBench{"notifier", [] {
+    std::printf("# RAM per instance: BinarySemaphore %u bytes, BinaryNotifier %u bytes, Notifier %u bytes\n",
+        static_cast<unsigned>(sizeof(freertos::BinarySemaphore)),
+        static_cast<unsigned>(sizeof(freertos::BinaryNotifier)),
+        static_cast<unsigned>(sizeof(freertos::Notifier)));
+
+    static Partner semaphorePartner{"secho", semaphoreEcho};
+    semaphorePartner.start(nullptr);
+    measure("wake round trip (BinarySemaphore)", ITERATIONS, [] {
+      semaphorePing.give();
+      semaphorePong.take();
+    });
+
+    static freertos::BinaryNotifier runnerLightweight{xTaskGetCurrentTaskHandle()};
+    lightweightPong = &runnerLightweight;
+    lightweightPartner.start(nullptr);
+    measure("wake round trip (BinaryNotifier)", ITERATIONS, [] {
+      lightweightPing.give();
+      (void) runnerLightweight.take();
+    });
+
+    static freertos::Notifier runnerNotifier{xTaskGetCurrentTaskHandle()};
+    notifierPong = &runnerNotifier;
+    notifierPartner.start(nullptr);
+    measure("wake round trip (Notifier bits)", ITERATIONS, [] {
+      notifierPing.set(1);
+      (void) runnerNotifier.wait();
+    });
+
+    static freertos::CountingNotifier counting{xTaskGetCurrentTaskHandle()};
+    measure("CountingNotifier give+take, no switch", ITERATIONS, [] {
+      counting.give();
+      (void) counting.take(0);
+    });
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Semantics: a CountingNotifier keeps every give, a BinaryNotifier
+  //  collapses them into one, Notifier ORs bits, and the FromISR flavours
+  //  report a wake only when they readied a higher priority task.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr uint32_t GIVES = 3;
+
+  void isrTargetBody();
+
+  Partner isrTargetPartner{"nisr", isrTargetBody};
+  freertos::BinaryNotifier isrTarget{isrTargetPartner};
+  std::atomic<uint32_t> isrTargetWakes{0};
+
+  void isrTargetBody()
+  {
+    for (;;) {
+      (void) isrTarget.take();
+      isrTargetWakes.fetch_add(1);
+    }
+  }
+
+  Benchmark notifierSemantics{"notifier, semantics", [] {
+    // The runner's notification value is shared with the benchmark above,
+    // start from a cleared one.
+    (void) ulTaskNotifyTake(pdTRUE, 0);
+
+    freertos::CountingNotifier counting{xTaskGetCurrentTaskHandle()};
+    for (uint32_t i = 0; i < GIVES; ++i) {
+      counting.give();
+    }
+    uint32_t counted = 0;
+    while (counting.take(0)) {
+      ++counted;
+    }
+    configASSERT(counted == GIVES && "CountingNotifier lost a give");
+
+    freertos::BinaryNotifier binary{xTaskGetCurrentTaskHandle()};
+    for (uint32_t i = 0; i < GIVES; ++i) {
+      binary.give();
+    }
+    uint32_t collapsed = 0;
+    while (binary.take(0)) {
+      ++collapsed;
+    }
+    configASSERT(collapsed == 1 && "BinaryNotifier did not collapse gives");
+
+    freertos::Notifier bits{xTaskGetCurrentTaskHandle()};
+    bits.set(1U << 0);
+    bits.set(1U << 2);
+    const uint32_t seen = bits.wait(0);
+    const uint32_t after = bits.wait(0);
+    configASSERT(seen == ((1U << 0) | (1U << 2)) && after == 0);
+
+    // A give to ourselves readies nobody.
+    BaseType_t woken = pdFALSE;
+    counting.giveFromISR(&woken);
+    configASSERT(woken == pdFALSE);
+    (void) counting.take(0);
+
+    // The partner runs first, being higher priority, and blocks in take().
+    isrTargetPartner.start(nullptr);
+    configASSERT(isrTargetWakes.load() == 0);
+
+    isrTarget.giveFromISR(&woken);
+    configASSERT(woken == pdTRUE && "giveFromISR did not report the woken task");
+    portYIELD_FROM_ISR(woken);
+    configASSERT(isrTargetWakes.load() == 1);
+
+    measure("BinaryNotifier giveFromISR, waking a task", ITERATIONS, [] {
+      BaseType_t higherPriorityTaskWoken = pdFALSE;
+      isrTarget.giveFromISR(&higherPriorityTaskWoken);
+      portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    });
+    configASSERT(isrTargetWakes.load() == 1 + ITERATIONS);
+
+    std::printf("# notifier: counting kept %u of %u gives, binary kept %u, bits 0x%x, ISR gives woke the partner %u times\n",
+                counted, GIVES, collapsed, seen, isrTargetWakes.load());
+  }};
+
+} // namespace
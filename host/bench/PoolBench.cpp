@@ -0,0 +1,92 @@
+/*
+ * PoolBench.cpp
+ *
+ *  Allocation cost of BlockPool against the kernel heap, and its
+ *  behaviour once every block is in use.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/BlockPool.hpp>
+
+#include <array>
+#include <cstdio>
+
+using namespace bench;
+
+namespace {
+
+  freertos::BlockPool<256, 16> pool{};
+
+  Benchmark blockPool{"block pool", [] {
+    measure("BlockPool<256> allocate+free", ITERATIONS, [] {
+      pool.free(pool.allocate());
+    });
+
+    measure("BlockPool<256> allocateFromISR+freeFromISR", ITERATIONS, [] {
+      pool.freeFromISR(pool.allocateFromISR());
+    });
+
+    measure("pvPortMalloc+vPortFree, 256 bytes", ITERATIONS, [] {
+      vPortFree(pvPortMalloc(256));
+    });
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Exhaustion: every block handed out once, distinct and owned by the
+  //  pool, then allocation fails until one comes back. The high-water
+  //  mark keeps the peak after everything is freed.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  freertos::BlockPool<64, 8> smallPool{};
+
+  Benchmark blockPoolExhaustion{"block pool, exhaustion", [] {
+    std::array<void*, smallPool.blockCount> blocks{};
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      blocks[i] = i % 2 == 0 ? smallPool.allocate() : smallPool.allocateFromISR();
+      configASSERT(blocks[i] != nullptr && smallPool.owns(blocks[i]));
+      for (size_t j = 0; j < i; ++j) {
+        configASSERT(blocks[j] != blocks[i]);
+      }
+    }
+
+    const void* overflow = smallPool.allocate();
+    const void* overflowFromISR = smallPool.allocateFromISR();
+    const freertos::PoolMessage overflowMessage = smallPool.allocateMessage(16);
+    configASSERT(overflow == nullptr && overflowFromISR == nullptr && overflowMessage.block == nullptr);
+    (void) overflow;
+    (void) overflowFromISR;
+    (void) overflowMessage;
+
+    measure("BlockPool<64> allocate, exhausted", ITERATIONS, [] {
+      void* block = smallPool.allocate();
+      configASSERT(block == nullptr);
+      (void) block;
+    });
+
+    const freertos::BlockPoolStats full = smallPool.stats();
+    configASSERT(full.inUse == smallPool.blockCount);
+    configASSERT(full.highWaterMark == smallPool.blockCount);
+    configASSERT(full.exhaustions == 3 + ITERATIONS);
+
+    // One block back is enough for the next allocation to succeed.
+    smallPool.free(blocks[0]);
+    blocks[0] = smallPool.allocate();
+    configASSERT(blocks[0] != nullptr);
+
+    for (void* block : blocks) {
+      smallPool.free(block);
+    }
+
+    const freertos::BlockPoolStats drained = smallPool.stats();
+    configASSERT(drained.inUse == 0);
+    configASSERT(drained.highWaterMark == smallPool.blockCount);
+    std::printf("# block pool: %u blocks, high water mark %u after freeing all, %u failed allocations counted\n",
+                static_cast<unsigned>(smallPool.blockCount), static_cast<unsigned>(drained.highWaterMark),
+                static_cast<unsigned>(drained.exhaustions));
+  }};
+
+} // namespace
@@ -0,0 +1,239 @@
+/*
+ * RwLockBench.cpp
+ *
+ *  RwLock against the ReadWriteLock classes, plus a reader/writer stress
+ *  run that checks the lock invariants.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/ReadWriteLock.hpp>
+#include <freertos_cpp/RwLock.hpp>
+
+#include <atomic>
+#include <cstdio>
+
+using namespace bench;
+
+namespace {
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Uncontended costs.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  freertos::ReadWriteLockPreferReader oldPreferReader{};
+  freertos::ReadWriteLockPreferWriter oldPreferWriter{};
+  freertos::RwLock<freertos::RwLockPolicy::PreferReader> preferReader{};
+  freertos::RwLock<freertos::RwLockPolicy::PreferWriter> preferWriter{};
+
+  Benchmark uncontended{"rw lock, uncontended", [] {
+    measure("read lock+unlock (ReadWriteLockPreferReader)", ITERATIONS, [] {
+      oldPreferReader.readerLock();
+      oldPreferReader.readerUnlock();
+    });
+    measure("read lock+unlock (ReadWriteLockPreferWriter)", ITERATIONS, [] {
+      oldPreferWriter.readerLock();
+      oldPreferWriter.readerUnlock();
+    });
+    measure("read lock+unlock (RwLock<PreferReader>)", ITERATIONS, [] {
+      freertos::ReadGuard guard{preferReader};
+    });
+    measure("read lock+unlock (RwLock<PreferWriter>)", ITERATIONS, [] {
+      freertos::ReadGuard guard{preferWriter};
+    });
+
+    measure("write lock+unlock (ReadWriteLockPreferReader)", ITERATIONS, [] {
+      oldPreferReader.writerLock();
+      oldPreferReader.writerUnlock();
+    });
+    measure("write lock+unlock (ReadWriteLockPreferWriter)", ITERATIONS, [] {
+      oldPreferWriter.writerLock();
+      oldPreferWriter.writerUnlock();
+    });
+    measure("write lock+unlock (RwLock<PreferReader>)", ITERATIONS, [] {
+      freertos::WriteGuard guard{preferReader};
+    });
+    measure("write lock+unlock (RwLock<PreferWriter>)", ITERATIONS, [] {
+      freertos::WriteGuard guard{preferWriter};
+    });
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Stress: three readers and one writer at the same priority, yielding
+  //  inside the critical region. Readers check that the writer's two
+  //  fields are consistent and that no writer is inside with them, some
+  //  acquisitions use a short timeout.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr uint32_t STRESS_ROUNDS = ITERATIONS / 10;
+  constexpr uint8_t STRESS_PRIORITY = RUNNER_PRIORITY - 1;
+
+  template<freertos::RwLockPolicy Policy>
+  struct Stress {
+    static inline freertos::RwLock<Policy> lock{};
+    static inline uint32_t first = 0;
+    static inline uint32_t second = 0;
+    static inline std::atomic<int> readersInside{0};
+    static inline std::atomic<int> writersInside{0};
+    static inline std::atomic<uint32_t> timeouts{0};
+    static inline std::atomic<uint32_t> finished{0};
+
+    static void reader()
+    {
+      for (uint32_t i = 0; i < STRESS_ROUNDS; ++i) {
+        freertos::ReadGuard guard{lock, i % 4 == 0 ? 1 : portMAX_DELAY};
+        if (!guard.lockAcquired()) {
+          timeouts.fetch_add(1);
+          continue;
+        }
+        readersInside.fetch_add(1);
+        configASSERT(writersInside.load() == 0);
+        const uint32_t seen = first;
+        taskYIELD();
+        configASSERT(second == seen);
+        readersInside.fetch_sub(1);
+      }
+      finished.fetch_add(1);
+    }
+
+    static void writer()
+    {
+      for (uint32_t i = 0; i < STRESS_ROUNDS; ++i) {
+        freertos::WriteGuard guard{lock, i % 4 == 0 ? 1 : portMAX_DELAY};
+        if (!guard.lockAcquired()) {
+          timeouts.fetch_add(1);
+          continue;
+        }
+        configASSERT(writersInside.fetch_add(1) == 0);
+        configASSERT(readersInside.load() == 0);
+        ++first;
+        taskYIELD();
+        ++second;
+        writersInside.fetch_sub(1);
+      }
+      finished.fetch_add(1);
+    }
+
+    static void run(const char* name)
+    {
+      static Partner readers[] = {
+          {"reader1", reader, STRESS_PRIORITY},
+          {"reader2", reader, STRESS_PRIORITY},
+          {"reader3", reader, STRESS_PRIORITY},
+      };
+      static Partner writerTask{"writer", writer, STRESS_PRIORITY};
+
+      const Clock::time_point start = Clock::now();
+      for (Partner& partner : readers) {
+        partner.start(nullptr);
+      }
+      writerTask.start(nullptr);
+      while (finished.load() < 4) {
+        vTaskDelay(1);
+      }
+      report(name, STRESS_ROUNDS * 4, Clock::now() - start);
+      std::printf("#   %u acquisitions timed out, writer made %u updates\n", timeouts.load(), first);
+    }
+  };
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Preempted writer: a low priority writer starts waiting just before
+  //  a tick, which wakes a high priority task that releases the write
+  //  lock and asks for a read lock straight away. When the tick lands
+  //  between the writer's failed attempt and its wait, the reader's
+  //  attempt runs in that gap, and a lock that loses the release there
+  //  leaves both waiting on a free lock.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr uint32_t PREEMPT_TRIALS = 1000;
+  constexpr uint32_t PREEMPT_OFFSETS = 40;
+  constexpr TickType_t PREEMPT_DEADLINE = pdMS_TO_TICKS(2000);
+
+  template<freertos::RwLockPolicy Policy>
+  struct Preempted {
+    static inline freertos::RwLock<Policy> lock{};
+    static inline TaskHandle_t runner = nullptr;
+    static inline TaskHandle_t holder = nullptr;
+    static inline TaskHandle_t waiter = nullptr;
+
+    static Clock::time_point nextTick()
+    {
+      const TickType_t now = xTaskGetTickCount();
+      while (xTaskGetTickCount() == now) {
+      }
+      return Clock::now();
+    }
+
+    /**
+     *  Takes the write lock, sleeps to the third tick, then releases it
+     *  and reads.
+     */
+    static void releaseAndRead()
+    {
+      holder = xTaskGetCurrentTaskHandle();
+      for (uint32_t i = 0; i < PREEMPT_TRIALS; ++i) {
+        const bool taken = lock.writerLock(0);
+        configASSERT(taken);
+        (void) taken;
+        xTaskNotifyGive(waiter);
+        vTaskDelay(3);
+        lock.writerUnlock();
+        {
+          freertos::ReadGuard guard{lock};
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      }
+      xTaskNotifyGive(runner);
+    }
+
+    /**
+     *  Times a write lock attempt to a little before the third tick.
+     */
+    static void write()
+    {
+      for (uint32_t i = 0; i < PREEMPT_TRIALS; ++i) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const Clock::time_point first = nextTick();
+        const Clock::time_point second = nextTick();
+        const Clock::time_point attempt = second + (second - first)
+                                          - std::chrono::microseconds(i % PREEMPT_OFFSETS);
+        while (Clock::now() < attempt) {
+        }
+        {
+          freertos::WriteGuard guard{lock};
+        }
+        xTaskNotifyGive(holder);
+      }
+    }
+
+    static void run(const char* name)
+    {
+      static Partner holderTask{"pholder", releaseAndRead, PARTNER_PRIORITY};
+      static Partner waiterTask{"pwaiter", write, STRESS_PRIORITY};
+
+      runner = xTaskGetCurrentTaskHandle();
+      const Clock::time_point start = Clock::now();
+      waiterTask.start(nullptr);
+      waiter = waiterTask.getHandle();
+      holderTask.start(nullptr);
+      const bool finished = ulTaskNotifyTake(pdTRUE, PREEMPT_TRIALS * 4 + PREEMPT_DEADLINE) != 0;
+      configASSERT(finished && "RwLock lost a release to a preempted writer");
+      (void) finished;
+      report(name, PREEMPT_TRIALS, Clock::now() - start);
+    }
+  };
+
+  Benchmark stress{"rw lock, stress", [] {
+    Stress<freertos::RwLockPolicy::PreferReader>::run("3 readers + 1 writer (RwLock<PreferReader>)");
+    Stress<freertos::RwLockPolicy::PreferWriter>::run("3 readers + 1 writer (RwLock<PreferWriter>)");
+    Preempted<freertos::RwLockPolicy::PreferReader>::run("preempted writer handoff (RwLock<PreferReader>)");
+    Preempted<freertos::RwLockPolicy::PreferWriter>::run("preempted writer handoff (RwLock<PreferWriter>)");
+  }};
+
+} // namespace
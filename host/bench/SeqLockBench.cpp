@@ -0,0 +1,134 @@
+/*
+ * SeqLockBench.cpp
+ *
+ *  SeqLock read and write cost against a critical section copy and a
+ *  length one TypedQueue, plus a stress run with an interrupt writer.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/Critical.hpp>
+#include <freertos_cpp/SeqLock.hpp>
+#include <freertos_cpp/TickHook.hpp>
+#include <freertos_cpp/TypedQueue.hpp>
+
+#include <array>
+#include <cstdio>
+
+using namespace bench;
+
+namespace {
+
+  struct ImuSample {
+    int32_t accel[3];
+    int32_t gyro[3];
+    uint32_t timestamp;
+    uint32_t sequence;
+  };
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Uncontended costs.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  freertos::SeqLock<ImuSample> seqLock{};
+  ImuSample criticalSample{};
+  freertos::TypedQueue<ImuSample, 1> mailbox{};
+
+  ImuSample produced{};
+  volatile uint32_t consumed = 0;
+
+  Benchmark seqLockCost{"seq lock", [] {
+    measure("SeqLock<32 bytes> write", ITERATIONS, [] {
+      ++produced.sequence;
+      seqLock.write(produced);
+    });
+    measure("SeqLock<32 bytes> read", ITERATIONS, [] {
+      consumed = seqLock.read().sequence;
+    });
+
+    measure("critical section copy, 32 bytes, write", ITERATIONS, [] {
+      ++produced.sequence;
+      const BaseType_t savedInterruptStatus = freertos::CriticalSection::enterFromISR();
+      criticalSample = produced;
+      freertos::CriticalSection::exitFromISR(savedInterruptStatus);
+    });
+    measure("critical section copy, 32 bytes, read", ITERATIONS, [] {
+      freertos::CriticalSection::enter();
+      const ImuSample sample = criticalSample;
+      freertos::CriticalSection::exit();
+      consumed = sample.sequence;
+    });
+
+    measure("TypedQueue<32 bytes, 1> overwrite", ITERATIONS, [] {
+      ++produced.sequence;
+      mailbox.overwrite(produced);
+    });
+    measure("TypedQueue<32 bytes, 1> peek", ITERATIONS, [] {
+      ImuSample sample;
+      (void) mailbox.peek(sample, 0);
+      consumed = sample.sequence;
+    });
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Stress: the tick interrupt publishes a burst of samples every tick,
+  //  each with all words equal, while this task reads continuously and
+  //  checks for torn copies.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr uint32_t WRITES_PER_TICK = 200;
+  constexpr uint32_t STRESS_TICKS = 200;
+
+  using Words = std::array<uint32_t, 16>;
+
+  freertos::SeqLock<Words> shared{};
+
+  class Publisher : public freertos::TickHook {
+    protected:
+      void run() override
+      {
+        for (uint32_t i = 0; i < WRITES_PER_TICK; ++i) {
+          ++m_value;
+          Words words;
+          words.fill(m_value);
+          shared.write(words);
+        }
+      }
+
+    private:
+      uint32_t m_value{0};
+  };
+
+  Publisher publisher{};
+
+  Benchmark seqLockStress{"seq lock, stress", [] {
+    publisher.registerTickHook();
+
+    uint32_t reads = 0;
+    uint32_t changes = 0;
+    uint32_t last = 0;
+    const TickType_t end = xTaskGetTickCount() + STRESS_TICKS;
+    const Clock::time_point start = Clock::now();
+    while (xTaskGetTickCount() < end) {
+      const Words words = shared.read();
+      for (uint32_t word : words) {
+        configASSERT(word == words[0]);
+      }
+      configASSERT(words[0] >= last);
+      if (words[0] != last) {
+        ++changes;
+      }
+      last = words[0];
+      ++reads;
+    }
+    publisher.disable();
+
+    report("64 byte reads against a tick hook writer", reads, Clock::now() - start);
+    std::printf("#   %u distinct values seen, %u retries, no torn reads\n", changes, shared.retries());
+  }};
+
+} // namespace
@@ -0,0 +1,52 @@
+/*
+ * StatsBench.cpp
+ *
+ *  Cost of the run time statistics and a sample of the task table.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/Stats.hpp>
+
+#include <cstdio>
+
+using namespace bench;
+
+namespace {
+
+  freertos::StatsSnapshot<16> snapshot{};
+
+  Benchmark statsBench{"stats", [] {
+    freertos::Stats::start();
+
+    measure("run time counter read", ITERATIONS, [] {
+      (void) freertos_stats_run_time_counter();
+    });
+
+    measure("Stats::IsrScope enter+exit", ITERATIONS, [] {
+      freertos::Stats::IsrScope scope{};
+    });
+
+    measure("StatsSnapshot<16>::sample", ITERATIONS / 10, [] {
+      (void) snapshot.sample();
+    });
+
+    // Spin for about 10 ms, then sleep as long so the idle task runs.
+    (void) snapshot.sample();
+    const Clock::time_point busyUntil = Clock::now() + std::chrono::milliseconds(10);
+    while (Clock::now() < busyUntil) {
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+    (void) snapshot.sample();
+
+    const freertos::SystemStats& system = snapshot.system();
+    std::printf("# stats snapshot: %u tasks, %u switches, %u ISRs\n",
+        static_cast<unsigned>(system.taskCount), system.contextSwitches, system.isrCount);
+    for (const freertos::TaskStats& task : snapshot.tasks()) {
+      std::printf("#   %-16s prio %2u cpu %3u.%u%% stack %5u switches %u\n",
+          task.name, static_cast<unsigned>(task.priority), task.cpuPermille / 10U, task.cpuPermille % 10U,
+          static_cast<unsigned>(task.stackHighWaterMark), task.contextSwitches);
+    }
+  }};
+
+} // namespace
@@ -0,0 +1,67 @@
+/*
+ * SystemBench.cpp
+ *
+ *  RAM map of a small System and the cost of reaching its objects.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/System.hpp>
+
+#include <cstdio>
+#include <string_view>
+
+using namespace bench;
+
+namespace {
+
+  class IdleTask : public freertos::Task {
+    public:
+      using Task::Task;
+
+    protected:
+      void run() override
+      {
+        suspend();
+      }
+  };
+
+  using BenchSystem = freertos::System<256 * 1024,
+      freertos::TaskSpec<"idle", IdleTask, STACK_SIZE, 1>,
+      freertos::QueueSpec<"samples", uint32_t, 16>,
+      freertos::StreamBufferSpec<"bytes", 100>>;
+
+} // namespace
+
+FREERTOS_SYSTEM_DEFINE(BenchSystem);
+
+namespace {
+
+  Benchmark systemBench{"system", [] {
+    constexpr auto map = BenchSystem::ramMap();
+    const std::string_view text{map.data(), map.size()};
+    for (size_t start = 0; start < text.size();) {
+      const size_t end = text.find('\n', start);
+      const std::string_view line = text.substr(start, end - start);
+      std::printf("#   %.*s\n", static_cast<int>(line.size()), line.data());
+      start = end + 1;
+    }
+
+    BenchSystem::startTasks();
+
+    freertos::Queue& samples = BenchSystem::get<"samples">();
+    measure("System Queue send+receive", ITERATIONS, [&samples] {
+      uint32_t value = 0;
+      (void) samples.enqueue(&value, 0);
+      (void) samples.dequeue(&value, 0);
+    });
+
+    freertos::StreamBuffer& bytes = BenchSystem::get<"bytes">();
+    measure("System StreamBuffer send+receive, 4 bytes", ITERATIONS, [&bytes] {
+      uint32_t value = 0;
+      (void) bytes.send(&value, sizeof(value), 0);
+      (void) bytes.receive(&value, sizeof(value), 0);
+    });
+  }};
+
+} // namespace
@@ -0,0 +1,373 @@
+/*
+ * TicklessBench.cpp
+ *
+ *  TicklessIdle against a simulated SysTick, checking the tick count it
+ *  corrects against true time and counting the interrupts it saves, and
+ *  that the run time statistics still see the time slept.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/Stats.hpp>
+#include <freertos_cpp/TicklessIdle.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace bench;
+
+namespace {
+
+  // 180 MHz core clock (HSI 16 MHz, PLLM 16, PLLN 360, PLLP 2) and a
+  // 1 kHz tick, as on the target.
+  constexpr uint32_t COUNTS_PER_TICK = 180000;
+  constexpr uint32_t MAX_COUNTS = 0xFFFFFF;
+  constexpr uint32_t COMPENSATION = 45;
+  constexpr uint32_t SLEEPS = 20000;
+
+  // TIM6, the HAL time base, counts at 1 MHz and starts on its own phase.
+  constexpr uint32_t HAL_COUNTS_PER_TICK = 1000;
+  constexpr uint64_t HAL_TICK_PHASE = COUNTS_PER_TICK * 2 / 5;
+
+  uint32_t random()
+  {
+    static uint32_t state = 0x2545F491;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  /**
+   *  Virtual time in timer counts, the timer, the interrupts and what
+   *  the kernel believes.
+   */
+  struct Simulation {
+    uint64_t now;
+
+    bool tickRunning;
+    uint64_t nextTick;
+
+    bool wakeupRunning;
+    bool countFlag;
+    uint64_t wakeupStart;
+    uint64_t wakeupAt;
+
+    uint64_t externalAt;
+
+    bool halTickRunning;
+    uint64_t nextHalTick;
+    uint32_t uwTick;
+    bool halTickOwed;
+    uint32_t halUpdatesHeld;
+    uint32_t halUpdatesPending;
+    int64_t minHalLead;
+    int64_t maxHalLead;
+
+    TickType_t kernelTicks;
+    TickType_t unblockAt;
+
+    bool statsClockStopped;
+
+    uint32_t tickInterrupts;
+    uint32_t wakeupInterrupts;
+    uint32_t externalInterrupts;
+    uint32_t overshoots;
+    uint64_t maxTickError;
+  };
+
+  Simulation sim{};
+
+  void scheduleExternal()
+  {
+    sim.externalAt = sim.now + 1 + random() % (80 * COUNTS_PER_TICK);
+  }
+
+  /**
+   *  Run every interrupt that is due, bar TIM6 while a higher priority
+   *  handler holds it off.
+   */
+  void serviceInterrupts(bool halTickHeld = false)
+  {
+    while (sim.tickRunning && sim.nextTick <= sim.now) {
+      ++sim.kernelTicks;
+      ++sim.tickInterrupts;
+      sim.nextTick += COUNTS_PER_TICK;
+    }
+    if (sim.wakeupRunning && !sim.countFlag && sim.wakeupAt <= sim.now) {
+      sim.countFlag = true;
+      ++sim.kernelTicks;
+      ++sim.wakeupInterrupts;
+    }
+    while (!halTickHeld && sim.halTickRunning && sim.nextHalTick <= sim.now) {
+      ++sim.uwTick;
+      sim.nextHalTick += COUNTS_PER_TICK;
+    }
+    if (sim.externalAt <= sim.now) {
+      ++sim.externalInterrupts;
+      scheduleExternal();
+    }
+  }
+
+  /**
+   *  Stopping and restarting the timer costs COMPENSATION counts, the
+   *  time the tick boundaries are reckoned from keeps running.
+   */
+  struct SimulatedTimebase {
+    static uint32_t countsPerTick()
+    {
+      return COUNTS_PER_TICK;
+    }
+
+    static uint32_t maxSleepCounts()
+    {
+      return MAX_COUNTS;
+    }
+
+    static uint32_t stoppedCompensation()
+    {
+      return COMPENSATION;
+    }
+
+    static uint32_t stopTick()
+    {
+      sim.tickRunning = false;
+      sim.halTickRunning = false;
+      const auto untilTick = static_cast<uint32_t>(sim.nextTick - sim.now);
+
+      // As LowPower.cpp does: stopped between a tick and the TIM6 update
+      // just behind it, or after that update with its interrupt still
+      // pending, TIM_FLAG_UPDATE set, the update is owed.
+      const bool updatePending = sim.nextHalTick <= sim.now;
+      sim.halTickOwed = untilTick > COUNTS_PER_TICK / 2
+                        && (updatePending || sim.nextHalTick - sim.now < COUNTS_PER_TICK / 2);
+      if (updatePending) {
+        ++sim.halUpdatesPending;
+      }
+      return untilTick;
+    }
+
+    static void startWakeup(uint32_t counts)
+    {
+      sim.now += COMPENSATION;
+      sim.wakeupRunning = true;
+      sim.countFlag = false;
+      sim.wakeupStart = sim.now;
+      sim.wakeupAt = sim.now + counts;
+    }
+
+    static uint32_t stopWakeup(bool& expired)
+    {
+      expired = sim.countFlag;
+      sim.wakeupRunning = false;
+      const uint64_t elapsed = sim.now - sim.wakeupStart;
+      sim.now += COMPENSATION;
+
+      // As LowPower.cpp does: the cycle counter stops in WFI, the time
+      // the wake-up timer saw goes to the stats clock. The host clock
+      // sees none of the simulated time.
+      if (sim.statsClockStopped) {
+        freertos::Stats::advance(elapsed * freertos::Stats::timestampFrequency() / (uint64_t{COUNTS_PER_TICK} * configTICK_RATE_HZ));
+      }
+      return static_cast<uint32_t>(elapsed);
+    }
+
+    static void startTick(uint32_t counts, TickType_t slept)
+    {
+      sim.tickRunning = true;
+      sim.nextTick = sim.now + counts;
+
+      // As LowPower.cpp does: the update TIM6 flagged with its interrupt
+      // off is dropped, the slept ticks are added at once, and its period
+      // restarts to end with the first SysTick one.
+      uint64_t halCounts = (uint64_t{counts} * HAL_COUNTS_PER_TICK + COUNTS_PER_TICK - 1) / COUNTS_PER_TICK;
+      if (halCounts == 0) {
+        halCounts = 1;
+      }
+      sim.uwTick += static_cast<uint32_t>(slept) + (sim.halTickOwed ? 1U : 0U);
+      sim.nextHalTick = sim.now + halCounts * (COUNTS_PER_TICK / HAL_COUNTS_PER_TICK);
+      sim.halTickRunning = true;
+    }
+
+    static void disableInterrupts()
+    {
+    }
+
+    static void enableInterrupts()
+    {
+      serviceInterrupts();
+    }
+
+    static void waitForInterrupt()
+    {
+      const uint64_t wakeupAt = sim.countFlag ? UINT64_MAX : sim.wakeupAt;
+      const uint64_t next = wakeupAt < sim.externalAt ? wakeupAt : sim.externalAt;
+      if (next > sim.now) {
+        sim.now = next;
+      }
+    }
+  };
+
+  /**
+   *  Now and then a task becomes ready just as the idle task stops the
+   *  tick.
+   */
+  struct SimulatedKernel {
+    static bool abortSleep()
+    {
+      return random() % 50 == 0;
+    }
+
+    static void stepTick(TickType_t ticks)
+    {
+      sim.kernelTicks += ticks;
+      if (sim.kernelTicks > sim.unblockAt) {
+        ++sim.overshoots;
+      }
+    }
+
+    static void preSleep(TickType_t&)
+    {
+    }
+
+    static void postSleep(TickType_t&)
+    {
+    }
+  };
+
+  using Idle = freertos::TicklessIdle<SimulatedTimebase, SimulatedKernel>;
+
+  /**
+   *  Distance of the kernel tick count from true time, in counts. Zero
+   *  while the tick boundaries stay on the grid they started on.
+   */
+  uint64_t tickError()
+  {
+    const uint64_t truth = uint64_t{sim.kernelTicks} * COUNTS_PER_TICK;
+    const uint64_t boundary = sim.nextTick - COUNTS_PER_TICK;
+    return truth > boundary ? truth - boundary : boundary - truth;
+  }
+
+  Benchmark ticklessBench{"tickless idle", [] {
+    sim.tickRunning = true;
+    sim.nextTick = COUNTS_PER_TICK;
+    sim.halTickRunning = true;
+    sim.nextHalTick = HAL_TICK_PHASE;
+    sim.minHalLead = INT64_MAX;
+    sim.maxHalLead = INT64_MIN;
+    scheduleExternal();
+
+    measure("TicklessIdle::sleep, simulated SysTick", SLEEPS, [] {
+      // Busy for up to three ticks, then idle until a random deadline,
+      // some of them longer than the timer can sleep.
+      sim.now += random() % (3 * COUNTS_PER_TICK);
+      serviceInterrupts();
+
+      const uint64_t error = tickError();
+      if (error > sim.maxTickError) {
+        sim.maxTickError = error;
+      }
+      // From the first sleep on the HAL tick keeps in step with the
+      // kernel tick, at most one of its counts behind.
+      if (Idle::stats().sleeps != 0) {
+        const int64_t lead = static_cast<int64_t>(sim.uwTick) - static_cast<int64_t>(sim.kernelTicks);
+        sim.minHalLead = lead < sim.minHalLead ? lead : sim.minHalLead;
+        sim.maxHalLead = lead > sim.maxHalLead ? lead : sim.maxHalLead;
+      }
+
+      // Now and then the TIM6 interrupt is held off by a higher priority
+      // one, so its update is pending when the idle task stops the tick.
+      if (random() % 8 == 0) {
+        sim.now = sim.nextHalTick + random() % (COUNTS_PER_TICK / 4);
+        serviceInterrupts(true);
+        ++sim.halUpdatesHeld;
+      }
+
+      const TickType_t expected = 2 + random() % 150;
+      sim.unblockAt = sim.kernelTicks + expected;
+      Idle::sleep(expected);
+    });
+
+    const uint64_t trueTicks = sim.now / COUNTS_PER_TICK;
+    const uint64_t interrupts = sim.tickInterrupts + sim.wakeupInterrupts;
+    const freertos::TicklessStats stats = Idle::stats();
+
+    std::printf("# tickless: %u sleeps, %u aborted, %u woken early by %u external interrupts\n",
+        stats.sleeps, stats.aborted, stats.earlyWakeups, sim.externalInterrupts);
+    std::printf("# tickless: kernel %llu ticks, true time %llu ticks, worst phase error %llu counts, %u overshoots\n",
+        static_cast<unsigned long long>(sim.kernelTicks), static_cast<unsigned long long>(trueTicks),
+        static_cast<unsigned long long>(sim.maxTickError), sim.overshoots);
+    std::printf("# tickless: %llu tick interrupts instead of %llu, %.1f%% avoided\n",
+        static_cast<unsigned long long>(interrupts), static_cast<unsigned long long>(trueTicks),
+        100.0 * static_cast<double>(trueTicks - interrupts) / static_cast<double>(trueTicks));
+
+    std::printf("# tickless: HAL tick %u, ahead of the kernel by %lld to %lld ticks, %u of %u held TIM6 updates pending at the stop\n",
+        sim.uwTick, static_cast<long long>(sim.minHalLead), static_cast<long long>(sim.maxHalLead),
+        sim.halUpdatesPending, sim.halUpdatesHeld);
+
+    configASSERT(sim.maxTickError == 0);
+    configASSERT(sim.maxHalLead - sim.minHalLead <= 1);
+    configASSERT(sim.halUpdatesPending > 0);
+    configASSERT(sim.overshoots == 0);
+    configASSERT(sim.kernelTicks == trueTicks);
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Run time statistics across a long sleep: a partner is busy for a few
+  //  milliseconds, then the runner, standing in for the idle task, sleeps
+  //  through simulated seconds. With the slept time handed to the stats
+  //  clock the sleeping task keeps the idle share, without it the busy
+  //  partner would look like most of the load.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr auto BUSY_TIME = std::chrono::milliseconds(20);
+  constexpr uint64_t LONG_SLEEP_TICKS = 20000;
+
+  void busyPartner()
+  {
+    const Clock::time_point busyUntil = Clock::now() + BUSY_TIME;
+    while (Clock::now() < busyUntil) {
+    }
+  }
+
+  freertos::StatsSnapshot<16> sleepSnapshot{};
+
+  Benchmark ticklessStatsBench{"tickless idle, stats clock", [] {
+    static Partner busy{"tbusy", busyPartner};
+
+    (void) sleepSnapshot.sample();
+    busy.start(nullptr);
+
+    sim.statsClockStopped = true;
+    const uint64_t sleepUntil = sim.now + LONG_SLEEP_TICKS * COUNTS_PER_TICK;
+    while (sim.now < sleepUntil) {
+      Idle::sleep(1000);
+      serviceInterrupts();
+    }
+    sim.statsClockStopped = false;
+
+    const bool sampled = sleepSnapshot.sample();
+    configASSERT(sampled);
+    (void) sampled;
+
+    uint16_t idlePermille = 0;
+    uint16_t busyPermille = 0;
+    for (const freertos::TaskStats& task : sleepSnapshot.tasks()) {
+      if (task.state == eRunning) {
+        idlePermille = task.cpuPermille;
+      } else if (std::strcmp(task.name, "tbusy") == 0) {
+        busyPermille = task.cpuPermille;
+      }
+    }
+
+    std::printf("# tickless: %llu ticks slept after %lld ms busy, sleeping task %u.%u%%, busy task %u.%u%%\n",
+        static_cast<unsigned long long>(LONG_SLEEP_TICKS), static_cast<long long>(BUSY_TIME.count()),
+        idlePermille / 10U, idlePermille % 10U, busyPermille / 10U, busyPermille % 10U);
+
+    configASSERT(idlePermille >= 990);
+    configASSERT(busyPermille <= 10);
+  }};
+
+} // namespace
@@ -0,0 +1,248 @@
+/*
+ * TimerWheelBench.cpp
+ *
+ *  TimerWheel with 10k active timers against the kernel timer daemon,
+ *  and random operations on a wheel checked against a reference model.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/TimerWheel.hpp>
+
+#include "timers.h"
+
+#include <array>
+#include <cstdio>
+
+using namespace bench;
+
+namespace {
+
+  constexpr size_t WHEEL_TIMERS = 10000;
+  constexpr size_t KERNEL_TIMERS = 1000;
+  constexpr uint32_t MAX_DELAY = 5000;
+
+  uint32_t random()
+  {
+    static uint32_t state = 0x12345678;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  freertos::TimerWheel wheel{};
+  std::array<freertos::WheelTimer, WHEEL_TIMERS> timers{};
+  freertos::WheelTimer probe{};
+  uint32_t expiries = 0;
+
+  std::array<StaticTimer_t, KERNEL_TIMERS> kernelTimerBuffers{};
+  std::array<TimerHandle_t, KERNEL_TIMERS> kernelTimers{};
+  StaticTimer_t kernelProbeBuffer{};
+
+  void countExpiry()
+  {
+    ++expiries;
+  }
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  Reference model: random starts, restarts and cancels, delays from a
+  //  tick to beyond MAX_DELAY, one shot and periodic, some periodic timers
+  //  cancelling themselves, while the wheel advances in random steps. The
+  //  wheel starts shortly before its time wraps at 2^32, the model keeps
+  //  64 bit time, and every expiry must land on the tick the model says.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr size_t MODEL_TIMERS = 256;
+  constexpr size_t PARKED_TIMERS = 16;
+  constexpr uint64_t MODEL_START = (uint64_t{1} << 32) - 3000000;
+  constexpr uint64_t MODEL_TICKS = freertos::TimerWheel::MAX_DELAY + 400000;
+  constexpr uint32_t MODEL_MAX_STEP = 4096;
+
+  struct ModelTimer {
+    uint64_t due;
+    uint32_t period;
+    bool active;
+    uint32_t fired;
+  };
+
+  freertos::TimerWheel modelWheel{static_cast<uint32_t>(MODEL_START)};
+  std::array<freertos::WheelTimer, MODEL_TIMERS> modelTimers{};
+  std::array<ModelTimer, MODEL_TIMERS> model{};
+  uint64_t modelTime = MODEL_START;
+  uint32_t modelExpiries = 0;
+
+  /**
+   *  Wheel time in the model's 64 bit time, the wheel never gets more
+   *  than a step ahead of modelTime.
+   */
+  uint64_t wheelTime()
+  {
+    return modelTime + (modelWheel.now() - static_cast<uint32_t>(modelTime));
+  }
+
+  void modelExpired(size_t i)
+  {
+    ModelTimer& timer = model[i];
+    configASSERT(timer.active && timer.due == wheelTime());
+    ++timer.fired;
+    ++modelExpiries;
+
+    if (timer.period == 0) {
+      timer.active = false;
+    } else if (random() % 8 == 0) {
+      const bool cancelled = modelWheel.cancel(modelTimers[i]);
+      configASSERT(cancelled);
+      (void) cancelled;
+      timer.active = false;
+    } else {
+      timer.due += timer.period;
+    }
+  }
+
+  uint32_t modelDelay()
+  {
+    const uint32_t pick = random() % 20;
+    if (pick < 2) {
+      return 0;
+    } else if (pick < 10) {
+      return 1 + random() % 64;
+    } else if (pick < 14) {
+      return 1 + random() % 4096;
+    } else if (pick < 18) {
+      return 1 + random() % (1U << 18);
+    }
+    // Either side of MAX_DELAY, the ones above are parked.
+    return freertos::TimerWheel::MAX_DELAY - 1000 + random() % 100000;
+  }
+
+  void modelStart(size_t i, uint32_t delay, uint32_t period)
+  {
+    modelWheel.start(modelTimers[i], delay, period);
+    model[i].due = modelTime + (delay != 0 ? delay : 1);
+    model[i].period = period;
+    model[i].active = true;
+  }
+
+  void checkModel()
+  {
+    size_t active = 0;
+    for (size_t i = 0; i < MODEL_TIMERS; ++i) {
+      configASSERT(modelTimers[i].isActive() == model[i].active);
+      configASSERT(!model[i].active || model[i].due > modelTime);
+      active += model[i].active ? 1U : 0U;
+    }
+    configASSERT(modelWheel.activeTimers() == active);
+    (void) active;
+  }
+
+  /**
+   *  @return Expiries checked.
+   */
+  uint32_t runModel()
+  {
+    for (size_t i = 0; i < MODEL_TIMERS; ++i) {
+      modelTimers[i].setCallback([i] { modelExpired(i); });
+    }
+
+    // Parked from the start so they come due inside the run.
+    for (size_t i = 0; i < PARKED_TIMERS; ++i) {
+      modelStart(i, freertos::TimerWheel::MAX_DELAY + 1 + static_cast<uint32_t>(i) * 20000, 0);
+    }
+
+    const uint64_t end = MODEL_START + MODEL_TICKS;
+    while (modelTime < end) {
+      const size_t i = PARKED_TIMERS + random() % (MODEL_TIMERS - PARKED_TIMERS);
+      if (random() % 4 == 0) {
+        const bool wasActive = modelWheel.cancel(modelTimers[i]);
+        configASSERT(wasActive == model[i].active);
+        (void) wasActive;
+        model[i].active = false;
+      } else {
+        modelStart(i, modelDelay(), random() % 2 == 0 ? 0 : 1 + random() % MODEL_MAX_STEP);
+      }
+
+      const uint32_t step = 1 + random() % MODEL_MAX_STEP;
+      modelWheel.advance(static_cast<uint32_t>(modelTime + step));
+      modelTime += step;
+      checkModel();
+    }
+
+    for (size_t i = 0; i < PARKED_TIMERS; ++i) {
+      configASSERT(model[i].fired == 1);
+    }
+    for (freertos::WheelTimer& timer : modelTimers) {
+      (void) modelWheel.cancel(timer);
+    }
+    return modelExpiries;
+  }
+
+  Benchmark timerWheelBench{"timer wheel", [] {
+    // Every other timer periodic, delays spread over a few thousand ticks.
+    for (size_t i = 0; i < timers.size(); ++i) {
+      timers[i].setCallback(&countExpiry);
+      const uint32_t delay = 1 + random() % MAX_DELAY;
+      wheel.start(timers[i], delay, (i % 2 == 0) ? delay : 0);
+    }
+    configASSERT(wheel.activeTimers() == WHEEL_TIMERS);
+
+    measure("TimerWheel start+cancel, 10k active", ITERATIONS, [] {
+      wheel.start(probe, 1 + random() % MAX_DELAY);
+      (void) wheel.cancel(probe);
+    });
+
+    measure("TimerWheel restart, 10k active", ITERATIONS, [] {
+      wheel.start(probe, 1 + random() % MAX_DELAY);
+    });
+    (void) wheel.cancel(probe);
+
+    // One shots all expire within MAX_DELAY ticks, the periodic half stays.
+    measure("TimerWheel tick, 10k active", MAX_DELAY, [] {
+      wheel.tick();
+    });
+    configASSERT(wheel.activeTimers() == WHEEL_TIMERS / 2);
+    std::printf("# timer wheel: %u expiries in %u ticks\n", expiries, MAX_DELAY);
+
+    for (freertos::WheelTimer& timer : timers) {
+      (void) wheel.cancel(timer);
+    }
+    configASSERT(wheel.activeTimers() == 0);
+
+    measure("TimerWheel tick, empty", ITERATIONS, [] {
+      wheel.tick();
+    });
+
+    const Clock::time_point begin = Clock::now();
+    const uint32_t checked = runModel();
+    report("TimerWheel vs reference model, per tick", static_cast<uint32_t>(MODEL_TICKS),
+        Clock::now() - begin);
+    std::printf("# timer wheel: %u expiries matched the model over %llu ticks across 2^32\n",
+        checked, static_cast<unsigned long long>(MODEL_TICKS));
+
+    // The daemon keeps active timers in a sorted list, a long period
+    // makes every restart walk all of them.
+    for (size_t i = 0; i < kernelTimers.size(); ++i) {
+      kernelTimers[i] = xTimerCreateStatic("bench", 1000000 + i, pdFALSE, nullptr,
+          [](TimerHandle_t) {}, &kernelTimerBuffers[i]);
+      (void) xTimerStart(kernelTimers[i], portMAX_DELAY);
+    }
+    TimerHandle_t kernelProbe = xTimerCreateStatic("probe", 2000000, pdFALSE, nullptr,
+        [](TimerHandle_t) {}, &kernelProbeBuffer);
+
+    measure("xTimerReset+xTimerStop, 1k active", ITERATIONS / 10, [kernelProbe] {
+      (void) xTimerReset(kernelProbe, portMAX_DELAY);
+      (void) xTimerStop(kernelProbe, portMAX_DELAY);
+    });
+
+    for (TimerHandle_t timer : kernelTimers) {
+      (void) xTimerDelete(timer, portMAX_DELAY);
+    }
+    (void) xTimerDelete(kernelProbe, portMAX_DELAY);
+
+    // Let the daemon drain its queue before the next benchmark.
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }};
+
+} // namespace
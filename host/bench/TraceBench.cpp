@@ -0,0 +1,360 @@
+/*
+ * TraceBench.cpp
+ *
+ *  Kernel trace recorder: a capture of queue ping-pong, notifications and
+ *  a delay decoded back from the byte stream, the overflow record, the
+ *  task list cut short, and the cost of one event. The capture is written
+ *  to freertos_trace.bin in the build directory for tools/trace_convert.py.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/Trace.hpp>
+#include <freertos_cpp/TypedQueue.hpp>
+
+#include "queue.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace bench;
+using freertos::Trace;
+using freertos::TraceEvent;
+
+namespace {
+
+  constexpr uint32_t ROUNDS = 50;
+  constexpr uint32_t WAKEUPS = 10;
+  constexpr size_t EVENT_COUNT = static_cast<size_t>(TraceEvent::Truncated) + 1;
+
+  /**
+   *  One decoded record, the name only for TaskCreate.
+   */
+  struct Decoded {
+    TraceEvent event;
+    uint64_t delta;
+    std::array<uint64_t, 2> arguments;
+    const uint8_t* name;
+    size_t nameLength;
+  };
+
+  size_t argumentCount(TraceEvent event)
+  {
+    switch (event) {
+      case TraceEvent::Header:
+      case TraceEvent::TaskCreate:
+      case TraceEvent::QueueCreate:
+      case TraceEvent::Truncated:
+        return 2;
+      case TraceEvent::TaskNotifyBlock:
+      case TraceEvent::IsrExit:
+        return 0;
+      default:
+        return 1;
+    }
+  }
+
+  /**
+   *  Walk a recorded byte stream the way tools/trace_convert.py does.
+   *
+   *  @return false if the stream ends inside a record or holds an
+   *  unknown event.
+   */
+  template<typename Visitor>
+  bool parse(const std::vector<uint8_t>& bytes, Visitor&& visitor)
+  {
+    size_t position = 0;
+    const auto varint = [&](uint64_t& value) {
+      value = 0;
+      for (uint32_t shift = 0; position < bytes.size() && shift < 64; shift += 7) {
+        const uint8_t byte = bytes[position++];
+        value |= static_cast<uint64_t>(byte & 0x7FU) << shift;
+        if ((byte & 0x80U) == 0) {
+          return true;
+        }
+      }
+      return false;
+    };
+
+    while (position < bytes.size()) {
+      Decoded record{};
+      if (bytes[position] >= EVENT_COUNT) {
+        return false;
+      }
+      record.event = static_cast<TraceEvent>(bytes[position++]);
+      if (!varint(record.delta)) {
+        return false;
+      }
+      for (size_t i = 0; i < argumentCount(record.event); ++i) {
+        if (!varint(record.arguments[i])) {
+          return false;
+        }
+      }
+      if (record.event == TraceEvent::TaskCreate) {
+        if (position >= bytes.size() || position + 1 + bytes[position] > bytes.size()) {
+          return false;
+        }
+        record.nameLength = bytes[position++];
+        record.name = &bytes[position];
+        position += record.nameLength;
+      }
+      visitor(record);
+    }
+    return true;
+  }
+
+  /**
+   *  The number tasks are traced by, the kernel's TCB number.
+   */
+  uint64_t traceNumber(TaskHandle_t task)
+  {
+    TaskStatus_t status{};
+    vTaskGetInfo(task, &status, pdFALSE, eInvalid);
+    return status.xTaskNumber;
+  }
+
+  std::vector<uint8_t> drainAll()
+  {
+    std::vector<uint8_t> bytes;
+    std::array<uint8_t, 256> chunk{};
+    size_t length = 0;
+    while ((length = Trace::drain(chunk.data(), chunk.size())) != 0) {
+      bytes.insert(bytes.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(length));
+    }
+    return bytes;
+  }
+
+  /**
+   *  Created inside the capture, like the partners, so their create
+   *  records come from the kernel hooks.
+   */
+  freertos::TypedQueue<uint32_t, 4>* ping = nullptr;
+  freertos::TypedQueue<uint32_t, 4>* pong = nullptr;
+
+  void traceEcho()
+  {
+    loop {
+      uint32_t value = 0;
+      ping->dequeue(value);
+      pong->enqueue(value);
+    }
+  }
+
+  void traceWakeup()
+  {
+    loop {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+  }
+
+  /**
+   *  What start() listed ahead of its TaskSwitch record.
+   */
+  struct Listing {
+    uint32_t tasks;
+    std::vector<uint64_t> queues;
+    uint64_t unlistedTasks;
+    uint64_t unlistedQueues;
+  };
+
+  Listing listing(const std::vector<uint8_t>& bytes)
+  {
+    Listing listed{};
+    bool started = true;
+    const bool complete = parse(bytes, [&](const Decoded& record) {
+      started = started && record.event != TraceEvent::TaskSwitch;
+      if (!started) {
+        return;
+      }
+      listed.tasks += record.event == TraceEvent::TaskCreate ? 1U : 0U;
+      if (record.event == TraceEvent::QueueCreate) {
+        listed.queues.push_back(record.arguments[0]);
+      }
+      if (record.event == TraceEvent::Truncated) {
+        listed.unlistedTasks = record.arguments[0];
+        listed.unlistedQueues = record.arguments[1];
+      }
+    });
+    configASSERT(complete);
+    (void) complete;
+    return listed;
+  }
+
+  /**
+   *  Capture the ping-pong, check the stream decodes into what happened
+   *  and save it.
+   *
+   *  @return Size of the capture in bytes.
+   */
+  size_t checkCapture()
+  {
+    // Created before the capture, start() has to list it.
+    static StaticQueue_t earlyBuffer{};
+    static std::array<uint8_t, sizeof(uint32_t)> earlyStorage{};
+    static QueueHandle_t early = xQueueCreateStatic(1, sizeof(uint32_t), earlyStorage.data(), &earlyBuffer);
+    const UBaseType_t tasks = uxTaskGetNumberOfTasks();
+
+    Trace::start();
+    static freertos::TypedQueue<uint32_t, 4> pingQueue{};
+    static freertos::TypedQueue<uint32_t, 4> pongQueue{};
+    ping = &pingQueue;
+    pong = &pongQueue;
+
+    static Partner echo{"techo", traceEcho};
+    static Partner wakeup{"twake", traceWakeup};
+    (void) echo.start(nullptr);
+    (void) wakeup.start(nullptr);
+
+    for (uint32_t i = 0; i < ROUNDS; ++i) {
+      uint32_t value = i;
+      ping->enqueue(value);
+      pong->dequeue(value);
+    }
+    for (uint32_t i = 0; i < WAKEUPS; ++i) {
+      xTaskNotifyGive(wakeup.getHandle());
+    }
+    vTaskDelay(2);
+    Trace::stop();
+
+    const std::vector<uint8_t> bytes = drainAll();
+    configASSERT(Trace::dropped() == 0);
+
+    const uint64_t runner = traceNumber(xTaskGetCurrentTaskHandle());
+    const uint64_t partner = traceNumber(echo.getHandle());
+
+    std::array<uint32_t, EVENT_COUNT> counts{};
+    uint32_t toRunner = 0;
+    uint32_t toPartner = 0;
+    bool partnerNamed = false;
+    bool headerFirst = false;
+    size_t index = 0;
+    const bool complete = parse(bytes, [&](const Decoded& record) {
+      if (index++ == 0) {
+        headerFirst = record.event == TraceEvent::Header;
+      }
+      ++counts[static_cast<size_t>(record.event)];
+      if (record.event == TraceEvent::TaskSwitch) {
+        toRunner += record.arguments[0] == runner ? 1U : 0U;
+        toPartner += record.arguments[0] == partner ? 1U : 0U;
+      }
+      if (record.event == TraceEvent::TaskCreate && record.arguments[0] == partner) {
+        partnerNamed = record.nameLength == 5 && std::equal(record.name, record.name + 5, "techo");
+      }
+    });
+    configASSERT(complete && headerFirst && counts[static_cast<size_t>(TraceEvent::Header)] == 1);
+    configASSERT(partnerNamed && toPartner >= ROUNDS && toRunner >= ROUNDS);
+    const Listing listed = listing(bytes);
+    configASSERT(listed.tasks + listed.unlistedTasks == tasks);
+    configASSERT(counts[static_cast<size_t>(TraceEvent::QueueCreate)] == listed.queues.size() + 2);
+    configASSERT(std::find(listed.queues.begin(), listed.queues.end(), uxQueueGetQueueNumber(early))
+                 != listed.queues.end());
+    configASSERT(counts[static_cast<size_t>(TraceEvent::QueueSend)] >= 2 * ROUNDS);
+    configASSERT(counts[static_cast<size_t>(TraceEvent::QueueReceive)] >= 2 * ROUNDS);
+    configASSERT(counts[static_cast<size_t>(TraceEvent::TaskNotify)] >= WAKEUPS);
+    configASSERT(counts[static_cast<size_t>(TraceEvent::TaskDelay)] >= 1);
+    (void) complete;
+    (void) headerFirst;
+
+    FILE* file = std::fopen(BENCH_OUTPUT_DIR "/freertos_trace.bin", "wb");
+    if (file != nullptr) {
+      (void) std::fwrite(bytes.data(), 1, bytes.size(), file);
+      (void) std::fclose(file);
+    }
+    return bytes.size();
+  }
+
+  /**
+   *  Overflow the ring: recording stops short of the end, the first
+   *  record after a drain carries the count of the lost ones.
+   */
+  uint32_t checkOverflow()
+  {
+    Trace::start();
+    for (uint32_t i = 0; i < Trace::BUFFER_SIZE; ++i) {
+      Trace::record(TraceEvent::QueueSend, i);
+    }
+    const uint32_t dropped = Trace::dropped();
+    configASSERT(dropped != 0);
+
+    std::vector<uint8_t> bytes = drainAll();
+    configASSERT(bytes.size() > Trace::BUFFER_SIZE - Trace::MAX_RECORD_SIZE);
+    Trace::record(TraceEvent::QueueSend, 0);
+    Trace::stop();
+    const std::vector<uint8_t> rest = drainAll();
+    bytes.insert(bytes.end(), rest.begin(), rest.end());
+
+    uint64_t overflowed = 0;
+    uint32_t sends = 0;
+    const bool complete = parse(bytes, [&](const Decoded& record) {
+      overflowed += record.event == TraceEvent::Overflow ? record.arguments[0] : 0U;
+      sends += record.event == TraceEvent::QueueSend ? 1U : 0U;
+    });
+    configASSERT(complete && overflowed == dropped && Trace::dropped() == dropped);
+    configASSERT(sends + dropped >= Trace::BUFFER_SIZE + 1);
+    (void) complete;
+    (void) sends;
+    return dropped;
+  }
+
+  void parked()
+  {
+    loop {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+  }
+
+  /**
+   *  More tasks than start() can list: it names as many as fit and counts
+   *  the rest, deleted tasks leave the list.
+   *
+   *  @return Tasks not named.
+   */
+  uint64_t checkTruncation()
+  {
+    std::vector<std::unique_ptr<Partner>> extra;
+    while (uxTaskGetNumberOfTasks() <= Trace::MAX_TASKS + 2) {
+      extra.push_back(std::make_unique<Partner>("tpark", parked));
+      (void) extra.back()->start(nullptr);
+    }
+    const UBaseType_t tasks = uxTaskGetNumberOfTasks();
+    Trace::start();
+    Trace::stop();
+    const Listing truncated = listing(drainAll());
+    configASSERT(truncated.tasks == Trace::MAX_TASKS && truncated.tasks + truncated.unlistedTasks == tasks);
+
+    extra.clear();
+    vTaskDelay(2);
+    const UBaseType_t remaining = uxTaskGetNumberOfTasks();
+    Trace::start();
+    Trace::stop();
+    const Listing after = listing(drainAll());
+    configASSERT(after.tasks + after.unlistedTasks == remaining);
+    (void) remaining;
+    return truncated.unlistedTasks;
+  }
+
+  Benchmark traceBench{"trace", [] {
+    const size_t captured = checkCapture();
+    const uint32_t dropped = checkOverflow();
+    const uint64_t unlisted = checkTruncation();
+
+    // A run that fits the ring, so every record is stored.
+    constexpr uint32_t RECORDS = 500;
+    Trace::start();
+    uint32_t queue = 0;
+    measure("Trace::record, queue event", RECORDS, [&] {
+      Trace::record(TraceEvent::QueueSend, ++queue & 0x7FU);
+    });
+    Trace::stop();
+    configASSERT(Trace::dropped() == 0);
+    const size_t bytes = drainAll().size();
+
+    std::printf("# trace: %zu byte capture decoded and saved to freertos_trace.bin, %u records dropped on overflow, "
+                "%llu tasks past the list counted, %.1f bytes per queue event\n", captured, dropped,
+                static_cast<unsigned long long>(unlisted), static_cast<double>(bytes) / RECORDS);
+  }};
+
+} // namespace
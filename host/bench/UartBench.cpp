@@ -0,0 +1,349 @@
+/*
+ * UartBench.cpp
+ *
+ *  The UART drivers from core/ on a stand-in HAL: a simulated TX DMA
+ *  stream that takes as long as the line would, measuring throughput and
+ *  how much of the CPU the sender leaves idle, and a simulated RX DMA
+ *  counter with late interrupts, checking what the receiver hands over.
+ */
+
+#include "Bench.hpp"
+
+#include "UartRx.hpp"
+#include "UartTx.hpp"
+
+#include <freertos_cpp/Stats.hpp>
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+using namespace bench;
+
+namespace {
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  TX: the DMA stream is a task that sleeps for the line time of each
+  //  transfer and then runs the TX complete interrupt. Every START_FAILURE
+  //  th start is refused, like HAL does on a busy handle, which the driver
+  //  must count and step over.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  // The line runs at 128 bytes per tick, fast enough to keep the run
+  // short and slow enough that the descriptor queue fills up.
+  constexpr uint32_t LINE_BYTES_PER_TICK = 128;
+  constexpr uint32_t LINE_RATE = LINE_BYTES_PER_TICK * configTICK_RATE_HZ;
+  constexpr size_t TX_CHUNK = 96;
+  constexpr uint32_t TX_WRITES = 600;
+  constexpr uint32_t START_FAILURE = 97;
+  constexpr uint8_t DMA_PRIORITY = PARTNER_PRIORITY + 1;
+
+  /**
+   *  What the sender transmits, byte i holds i so the stream checks
+   *  that every transfer is a contiguous slice.
+   */
+  std::array<uint8_t, 256 + TX_CHUNK> pattern = [] {
+    std::array<uint8_t, 256 + TX_CHUNK> bytes{};
+    for (size_t i = 0; i < bytes.size(); ++i) {
+      bytes[i] = static_cast<uint8_t>(i);
+    }
+    return bytes;
+  }();
+
+  UART_HandleTypeDef txHandle{nullptr, HAL_UART_STATE_READY, HAL_UART_STATE_RESET};
+  UartTx uartTx{txHandle};
+
+  struct TxStream {
+    const uint8_t* data;
+    uint16_t length;
+    uint32_t starts;
+    uint32_t refused;
+    uint32_t lineBytes;
+    uint64_t sent;
+  };
+
+  TxStream txStream{};
+  TaskHandle_t txDma = nullptr;
+
+  void txDmaStream()
+  {
+    loop {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      configASSERT(txHandle.gState == HAL_UART_STATE_BUSY_TX);
+
+      for (uint16_t i = 1; i < txStream.length; ++i) {
+        configASSERT(txStream.data[i] == static_cast<uint8_t>(txStream.data[0] + i));
+      }
+
+      // Whole ticks of line time, the remainder carries into the next
+      // transfer.
+      txStream.lineBytes += txStream.length;
+      vTaskDelay(txStream.lineBytes / LINE_BYTES_PER_TICK);
+      txStream.lineBytes %= LINE_BYTES_PER_TICK;
+      txStream.sent += txStream.length;
+
+      txHandle.gState = HAL_UART_STATE_READY;
+      uartTx.onTxComplete();
+    }
+  }
+
+  freertos::StatsSnapshot<64> txSnapshot{};
+
+  uint16_t idlePermille()
+  {
+    for (const freertos::TaskStats& task : txSnapshot.tasks()) {
+      if (std::strcmp(task.name, "IDLE") == 0) {
+        return task.cpuPermille;
+      }
+    }
+    return 0;
+  }
+
+  Benchmark uartTxBench{"uart tx", [] {
+    static Partner dma{"txdma", txDmaStream, DMA_PRIORITY};
+    dma.start(nullptr);
+    txDma = dma.getHandle();
+
+    bool sampled = txSnapshot.sample();
+    Clock::duration writeTime{};
+    const Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < TX_WRITES; ++i) {
+      const Clock::time_point before = Clock::now();
+      const bool queued = uartTx.write(&pattern[(i * TX_CHUNK) % 256], TX_CHUNK);
+      writeTime += Clock::now() - before;
+      configASSERT(queued);
+      (void) queued;
+    }
+    const bool flushed = uartTx.flush(pdMS_TO_TICKS(5000));
+    configASSERT(flushed);
+    (void) flushed;
+    const Clock::duration elapsed = Clock::now() - start;
+    sampled = sampled && txSnapshot.sample();
+    configASSERT(sampled);
+    (void) sampled;
+
+    // Includes the time writes spent blocked on a full descriptor queue.
+    report("UartTx::write, 96 bytes, line limited", TX_WRITES, writeTime);
+
+    configASSERT(uartTx.errors() == txStream.refused && txStream.refused != 0);
+    configASSERT(txStream.sent == (TX_WRITES - txStream.refused) * TX_CHUNK);
+
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const uint16_t idle = idlePermille();
+    std::printf("# uart tx: %.0f of %u bytes/s line rate, CPU %u.%u%% idle, %u refused starts counted\n",
+                static_cast<double>(txStream.sent) / seconds, LINE_RATE,
+                idle / 10U, idle % 10U, uartTx.errors());
+  }};
+
+  /////////////////////////////////////////////////////////////////////////
+  //
+  //  RX: the DMA is simulated one byte time at a time. Its counter runs
+  //  down and reloads, raising the half transfer, transfer complete and
+  //  idle line flags the way the hardware does, and the interrupt that
+  //  services them runs up to a latency later, in the order HAL uses.
+  //  Below half a buffer of latency every byte must come out in order.
+  //  Above it the DMA can go all the way round between events, and the
+  //  bytes it lapped must be exactly the ones counted as overruns.
+  //
+  /////////////////////////////////////////////////////////////////////////
+
+  constexpr uint32_t RX_BYTES = 200000;
+  constexpr uint32_t RX_MAX_BURST = 300;
+  constexpr uint32_t RX_MAX_GAP = 4;
+  constexpr uint32_t RX_SHORT_LATENCY = UartRx::DMA_BUFFER_SIZE / 2 - 8;
+  constexpr uint32_t RX_LONG_LATENCY = UartRx::DMA_BUFFER_SIZE / 2 + 16;
+
+  constexpr uint8_t RX_HALF = 1U << 0;
+  constexpr uint8_t RX_COMPLETE = 1U << 1;
+  constexpr uint8_t RX_IDLE = 1U << 2;
+
+  UartRx::DmaBuffer rxBuffer{};
+  DMA_Stream_TypeDef rxStream{};
+  DMA_HandleTypeDef rxDma{&rxStream};
+  UART_HandleTypeDef rxHandle{&rxDma, HAL_UART_STATE_RESET, HAL_UART_STATE_READY};
+  UartRx uartRx{rxHandle, rxBuffer};
+
+  struct RxLine {
+    std::minstd_rand random{1};
+    uint32_t latency = 0;
+    uint64_t time = 0;
+    uint64_t serviceAt = 0;
+    uint8_t pending = 0;
+    bool idleArmed = false;
+    uint8_t next = 0;
+    uint8_t expected = 0;
+
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t lapped = 0;
+    uint32_t events = 0;
+    uint32_t coalesced = 0;
+    Clock::duration eventTime{};
+
+    uint32_t upTo(uint32_t limit)
+    {
+      return static_cast<uint32_t>(random() % (limit + 1));
+    }
+
+    void raise(uint8_t flag)
+    {
+      if (pending == 0) {
+        serviceAt = time + upTo(latency);
+      }
+      pending = static_cast<uint8_t>(pending | flag);
+    }
+
+    /**
+     *  One byte time, with or without a byte on the line.
+     */
+    void step(bool byte)
+    {
+      if (byte) {
+        rxBuffer[UartRx::DMA_BUFFER_SIZE - rxStream.NDTR] = next++;
+        ++sent;
+        idleArmed = true;
+        rxStream.NDTR = rxStream.NDTR - 1;
+        if (rxStream.NDTR == UartRx::DMA_BUFFER_SIZE / 2) {
+          raise(RX_HALF);
+        } else if (rxStream.NDTR == 0) {
+          rxStream.NDTR = UartRx::DMA_BUFFER_SIZE;
+          raise(RX_COMPLETE);
+        }
+      } else if (idleArmed) {
+        idleArmed = false;
+        raise(RX_IDLE);
+      }
+
+      ++time;
+      if (pending != 0 && time >= serviceAt) {
+        service();
+      }
+    }
+
+    void event(UartRx::RxEvent kind)
+    {
+      const Clock::time_point before = Clock::now();
+      uartRx.onRxEvent(kind);
+      eventTime += Clock::now() - before;
+      ++events;
+    }
+
+    /**
+     *  The DMA stream interrupt comes first, half transfer before
+     *  transfer complete, then the UART one. HAL only reports an idle line
+     *  with the DMA somewhere inside the buffer.
+     */
+    void service()
+    {
+      coalesced += (pending & (RX_HALF | RX_COMPLETE)) == (RX_HALF | RX_COMPLETE) ? 1U : 0U;
+      if ((pending & RX_HALF) != 0) {
+        event(UartRx::RxEvent::HalfTransfer);
+      }
+      if ((pending & RX_COMPLETE) != 0) {
+        event(UartRx::RxEvent::TransferComplete);
+      }
+      if ((pending & RX_IDLE) != 0 && rxStream.NDTR > 0 && rxStream.NDTR < UartRx::DMA_BUFFER_SIZE) {
+        event(UartRx::RxEvent::Idle);
+      }
+      pending = 0;
+      take();
+    }
+
+    /**
+     *  Read what was handed over. Bytes count up, so a jump is what the
+     *  receiver skipped, and the only skips allowed are whole lapped
+     *  buffers.
+     */
+    void take()
+    {
+      std::array<uint8_t, UartRx::RING_SIZE> bytes{};
+      size_t length = 0;
+      while ((length = uartRx.read(bytes.data(), bytes.size(), 0)) != 0) {
+        for (size_t i = 0; i < length; ++i) {
+          const auto skipped = static_cast<uint8_t>(bytes[i] - expected);
+          configASSERT(skipped % UartRx::DMA_BUFFER_SIZE == 0);
+          lapped += skipped;
+          expected = static_cast<uint8_t>(bytes[i] + 1U);
+        }
+        received += static_cast<uint32_t>(length);
+      }
+    }
+
+    /**
+     *  Bursts with short gaps, then enough idle line for everything to be
+     *  handed over.
+     */
+    void run(uint32_t interruptLatency)
+    {
+      latency = interruptLatency;
+      const uint32_t last = sent + RX_BYTES;
+      while (sent < last) {
+        for (uint32_t burst = upTo(RX_MAX_BURST); burst != 0 && sent < last; --burst) {
+          step(true);
+        }
+        for (uint32_t gap = upTo(RX_MAX_GAP); gap != 0; --gap) {
+          step(false);
+        }
+      }
+      while (pending != 0 || idleArmed) {
+        step(false);
+      }
+    }
+  };
+
+  RxLine rxLine{};
+
+  Benchmark uartRxBench{"uart rx", [] {
+    const bool started = uartRx.start();
+    configASSERT(started && rxHandle.RxState == HAL_UART_STATE_BUSY_RX);
+    (void) started;
+
+    rxLine.run(RX_SHORT_LATENCY);
+    configASSERT(rxLine.received == rxLine.sent && rxLine.lapped == 0 && uartRx.overruns() == 0);
+    const uint32_t shortEvents = rxLine.events;
+    report("UartRx::onRxEvent, interrupts within half a buffer", shortEvents, rxLine.eventTime);
+
+    rxLine.eventTime = {};
+    rxLine.run(RX_LONG_LATENCY);
+    configASSERT(rxLine.received + rxLine.lapped == rxLine.sent);
+    configASSERT(rxLine.lapped == uartRx.overruns() && rxLine.lapped != 0 && rxLine.coalesced != 0);
+    report("UartRx::onRxEvent, interrupts up to 3/4 buffer late", rxLine.events - shortEvents, rxLine.eventTime);
+
+    std::printf("# uart rx: %u bytes in order, %u coalesced DMA interrupts, %u lapped bytes counted as overruns\n",
+                rxLine.received, rxLine.coalesced, uartRx.overruns());
+  }};
+
+} // namespace
+
+extern "C" HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, uint8_t* pData, uint16_t Size)
+{
+  configASSERT(huart == &txHandle && Size != 0);
+  if (huart->gState != HAL_UART_STATE_READY) {
+    return HAL_BUSY;
+  }
+  if (++txStream.starts % START_FAILURE == 0) {
+    ++txStream.refused;
+    return HAL_ERROR;
+  }
+
+  huart->gState = HAL_UART_STATE_BUSY_TX;
+  txStream.data = pData;
+  txStream.length = Size;
+  xTaskNotifyGive(txDma);
+  return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* huart, uint8_t* pData, uint16_t Size)
+{
+  configASSERT(huart == &rxHandle && pData == rxBuffer.data() && Size == UartRx::DMA_BUFFER_SIZE);
+  if (huart->RxState != HAL_UART_STATE_READY) {
+    return HAL_BUSY;
+  }
+
+  huart->RxState = HAL_UART_STATE_BUSY_RX;
+  rxStream.NDTR = Size;
+  return HAL_OK;
+}
@@ -0,0 +1,90 @@
+/*
+ * WorkQueueBench.cpp
+ *
+ *  WorkQueue deferral against xTimerPendFunctionCall() and the timer
+ *  daemon.
+ */
+
+#include "Bench.hpp"
+
+#include <freertos_cpp/Semaphore.hpp>
+#include <freertos_cpp/WorkQueue.hpp>
+
+#include "timers.h"
+
+#include <cstdio>
+
+using namespace bench;
+
+namespace {
+
+  // Level 0 preempts the runner, level 1 runs below it.
+  freertos::WorkQueue<2, 16, STACK_SIZE> work{"work", {PARTNER_PRIORITY, RUNNER_PRIORITY - 1}};
+
+  freertos::BinarySemaphore done{};
+  uint32_t counted = 0;
+
+  void signalDone(void*, uint32_t)
+  {
+    done.give();
+  }
+
+  void printStats(const char* name, size_t level)
+  {
+    const freertos::WorkQueueStats stats = work.stats(level);
+    const double usPerUnit = 1e6 / freertos::Stats::timestampFrequency();
+    const double average = stats.completed != 0 ? static_cast<double>(stats.totalLatency) / stats.completed : 0.0;
+    std::printf("# work queue %s: %u completed, %u rejected, max depth %u, latency avg %.1f us max %.1f us\n",
+        name, stats.completed, stats.rejected, static_cast<unsigned>(stats.maxDepth),
+        average * usPerUnit, stats.maxLatency * usPerUnit);
+  }
+
+  Benchmark workQueueBench{"work queue", [] {
+    work.start();
+
+    measure("WorkQueue submit+run, higher priority", ITERATIONS, [] {
+      (void) work.submit(0, [] { done.give(); });
+      (void) done.take();
+    });
+
+    measure("WorkQueue submitFromISR+run, higher priority", ITERATIONS, [] {
+      BaseType_t higherPriorityTaskWoken = pdFALSE;
+      (void) work.submitFromISR(0, [] { done.give(); }, &higherPriorityTaskWoken);
+      portYIELD_FROM_ISR(higherPriorityTaskWoken);
+      (void) done.take();
+    });
+
+    measure("xTimerPendFunctionCall+run (daemon)", ITERATIONS / 10, [] {
+      (void) xTimerPendFunctionCall(signalDone, nullptr, 0, portMAX_DELAY);
+      (void) done.take();
+    });
+
+    // Below the runner nothing runs until the runner blocks, the queue
+    // fills up and further submissions are rejected.
+    measure("WorkQueue submit, lower priority", 16, [] {
+      (void) work.submit(1, [] { ++counted; });
+    });
+    bool refused = !work.submit(1, [] { ++counted; });
+    configASSERT(refused);
+    vTaskDelay(pdMS_TO_TICKS(10));
+    configASSERT(counted == 16);
+
+    // The same from an interrupt: nothing to wake below the runner, and a
+    // full queue is refused straight away instead of blocking.
+    measure("WorkQueue submitFromISR, lower priority", 16, [] {
+      BaseType_t higherPriorityTaskWoken = pdFALSE;
+      (void) work.submitFromISR(1, [] { ++counted; }, &higherPriorityTaskWoken);
+      configASSERT(higherPriorityTaskWoken == pdFALSE);
+    });
+    BaseType_t woken = pdFALSE;
+    refused = !work.submitFromISR(1, [] { ++counted; }, &woken);
+    configASSERT(refused && woken == pdFALSE);
+    (void) refused;
+    vTaskDelay(pdMS_TO_TICKS(10));
+    configASSERT(counted == 32);
+
+    printStats("high", 0);
+    printStats("low", 1);
+  }};
+
+} // namespace
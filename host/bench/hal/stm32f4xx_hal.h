@@ -0,0 +1,55 @@
+/*
+ * stm32f4xx_hal.h
+ *
+ *  Host stand-in for the parts of the STM32F4 HAL the UART drivers in
+ *  core/ use, so they build unchanged into the benchmarks. The functions
+ *  are implemented by the benchmark that simulates the peripheral.
+ */
+
+#ifndef HOST_BENCH_HAL_STM32F4XX_HAL_H_
+#define HOST_BENCH_HAL_STM32F4XX_HAL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  HAL_OK = 0x00U,
+  HAL_ERROR = 0x01U,
+  HAL_BUSY = 0x02U,
+  HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+  HAL_UART_STATE_RESET = 0x00U,
+  HAL_UART_STATE_READY = 0x20U,
+  HAL_UART_STATE_BUSY_TX = 0x21U,
+  HAL_UART_STATE_BUSY_RX = 0x22U
+} HAL_UART_StateTypeDef;
+
+typedef struct {
+  volatile uint32_t NDTR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+  DMA_Stream_TypeDef* Instance;
+} DMA_HandleTypeDef;
+
+typedef struct {
+  DMA_HandleTypeDef* hdmarx;
+  volatile HAL_UART_StateTypeDef gState;
+  volatile HAL_UART_StateTypeDef RxState;
+} UART_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__) ((__HANDLE__)->Instance->NDTR)
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, uint8_t* pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* huart, uint8_t* pData, uint16_t Size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_BENCH_HAL_STM32F4XX_HAL_H_ */
@@ -0,0 +1,48 @@
+/*
+ * main.cpp
+ *
+ *  Host benchmark runner. Starts the scheduler, runs every registered
+ *  benchmark from a task and exits.
+ */
+
+#include "Bench.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+  class Runner : public freertos::Task {
+    public:
+      Runner()
+          :freertos::Task("bench", m_stack.data(), bench::STACK_SIZE, bench::RUNNER_PRIORITY)
+      {
+      }
+
+    protected:
+      [[noreturn]] void run() override
+      {
+        bench::Benchmark::runAll();
+        std::fflush(stdout);
+
+        // Task objects are never torn down on the host, leave without
+        // running static destructors.
+        std::_Exit(EXIT_SUCCESS);
+      }
+
+    private:
+      std::array<StackType_t, bench::STACK_SIZE> m_stack{};
+  };
+
+  Runner runner{};
+
+} // namespace
+
+int main()
+{
+  runner.start(nullptr);
+  freertos::Task::startScheduler();
+
+  std::fprintf(stderr, "scheduler returned\n");
+  return EXIT_FAILURE;
+}
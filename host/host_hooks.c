@@ -0,0 +1,46 @@
+/*
+ * host_hooks.c
+ *
+ *  Application hooks the kernel expects, for the host build. On the
+ *  target these come from core/src/freertos.c and cmsis_os2.c.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void vApplicationMallocFailedHook(void)
+{
+  fprintf(stderr, "FreeRTOS: malloc failed\n");
+  abort();
+}
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+
+static StaticTask_t idleTaskTCB;
+static StackType_t idleTaskStack[configMINIMAL_STACK_SIZE];
+
+void vApplicationGetIdleTaskMemory(StaticTask_t** ppxIdleTaskTCBBuffer,
+                                   StackType_t** ppxIdleTaskStackBuffer,
+                                   uint32_t* pulIdleTaskStackSize)
+{
+  *ppxIdleTaskTCBBuffer = &idleTaskTCB;
+  *ppxIdleTaskStackBuffer = idleTaskStack;
+  *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+static StaticTask_t timerTaskTCB;
+static StackType_t timerTaskStack[configTIMER_TASK_STACK_DEPTH];
+
+void vApplicationGetTimerTaskMemory(StaticTask_t** ppxTimerTaskTCBBuffer,
+                                    StackType_t** ppxTimerTaskStackBuffer,
+                                    uint32_t* pulTimerTaskStackSize)
+{
+  *ppxTimerTaskTCBBuffer = &timerTaskTCB;
+  *ppxTimerTaskStackBuffer = timerTaskStack;
+  *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * placement.h
+ *
+ *  Host stand-in for core/inc/placement.h. There is one memory on the
+ *  host, the attributes place nothing and the checks have no section to
+ *  be read from.
+ */
+
+#ifndef HOST_PLACEMENT_H_
+#define HOST_PLACEMENT_H_
+
+#define RAMFUNC
+#define DMA_BUFFER
+#define DMA_BUFFER_CHECK(object) static_assert(true, "")
+
+#endif /* HOST_PLACEMENT_H_ */
@@ -0,0 +1,51 @@
+# Fails the build if a buffer registered with DMA_BUFFER_CHECK() was not
+# linked into SRAM2. Run after the build by stm32_check_dma_placement():
+#
+#   cmake -DCHECK_FILE=<dump of .dma_check> -DELF_FILE=<elf> -DOBJDUMP=<objdump>
+#         -DSRAM2_START=0x2001C000 -DSRAM2_END=0x20020000 -P stm32_check_dma_placement.cmake
+#
+# .dma_check holds one little endian 32 bit address per registered buffer.
+
+file(READ ${CHECK_FILE} RECORDS HEX)
+string(LENGTH "${RECORDS}" RECORDS_LENGTH)
+math(EXPR SRAM2_START_VALUE "${SRAM2_START}")
+math(EXPR SRAM2_END_VALUE "${SRAM2_END}")
+
+set(CHECKED 0)
+set(MISPLACED "")
+set(OFFSET 0)
+while (OFFSET LESS RECORDS_LENGTH)
+    set(ADDRESS_HEX "")
+    foreach (BYTE 3 2 1 0)
+        math(EXPR POSITION "${OFFSET} + ${BYTE} * 2")
+        string(SUBSTRING "${RECORDS}" ${POSITION} 2 BYTE_HEX)
+        string(APPEND ADDRESS_HEX ${BYTE_HEX})
+    endforeach ()
+    math(EXPR OFFSET "${OFFSET} + 8")
+    math(EXPR ADDRESS "0x${ADDRESS_HEX}")
+
+    # Zero is a buffer removed by --gc-sections, nothing to place
+    if (ADDRESS EQUAL 0)
+        continue()
+    endif ()
+    math(EXPR CHECKED "${CHECKED} + 1")
+    if (ADDRESS LESS SRAM2_START_VALUE OR NOT ADDRESS LESS SRAM2_END_VALUE)
+        list(APPEND MISPLACED ${ADDRESS_HEX})
+    endif ()
+endwhile ()
+
+if (MISPLACED)
+    execute_process(COMMAND ${OBJDUMP} -t -C -w ${ELF_FILE} OUTPUT_VARIABLE SYMBOLS)
+    set(REPORT "")
+    foreach (ADDRESS_HEX ${MISPLACED})
+        string(TOLOWER ${ADDRESS_HEX} ADDRESS_HEX)
+        string(REGEX MATCH "${ADDRESS_HEX} [^\n]*O [^\n]*" SYMBOL "${SYMBOLS}")
+        if (NOT SYMBOL)
+            set(SYMBOL "0x${ADDRESS_HEX}")
+        endif ()
+        string(APPEND REPORT "\n  ${SYMBOL}")
+    endforeach ()
+    message(FATAL_ERROR "DMA buffers outside SRAM2 (${SRAM2_START} - ${SRAM2_END}):${REPORT}")
+endif ()
+
+message(STATUS "${CHECKED} DMA buffers in SRAM2")
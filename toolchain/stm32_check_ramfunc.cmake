@@ -0,0 +1,34 @@
+# Fails the build if a function expected to run from RAM was not linked
+# into .ramfunc. Run after the build by stm32_generate_ramfunc_report():
+#
+#   cmake -DREPORT_FILE=<target>.ramfunc.txt -DEXPECTED=<name>,<name>,...
+#         -P stm32_check_ramfunc.cmake
+#
+# The report is the demangled objdump symbol table of .ramfunc, names are
+# compared without their parameter list, freertos::Stats::timestamp for
+# freertos::Stats::timestamp().
+
+file(STRINGS ${REPORT_FILE} LINES)
+set(PLACED "")
+foreach (LINE ${LINES})
+    # <address> <flags> .ramfunc<tab><size> <name>
+    if (LINE MATCHES "\\.ramfunc\t[0-9a-fA-F]+ ([^(]+)")
+        list(APPEND PLACED "${CMAKE_MATCH_1}")
+    endif ()
+endforeach ()
+
+string(REPLACE "," ";" EXPECTED "${EXPECTED}")
+set(MISSING "")
+foreach (SYMBOL ${EXPECTED})
+    list(FIND PLACED "${SYMBOL}" INDEX)
+    if (INDEX EQUAL -1)
+        string(APPEND MISSING "\n  ${SYMBOL}")
+    endif ()
+endforeach ()
+
+if (MISSING)
+    message(FATAL_ERROR "Functions expected in .ramfunc run from flash or were not linked:${MISSING}")
+endif ()
+
+list(LENGTH EXPECTED EXPECTED_COUNT)
+message(STATUS "${EXPECTED_COUNT} expected functions in .ramfunc")
@@ -103,6 +103,67 @@ function(stm32_generate_hex_file TARGET)
     )
 endfunction()
 
+# helper function to dump and print the freertos::System RAM map after build
+function(stm32_generate_ram_map TARGET)
+    # cmake -E cat needs CMake 3.18, older versions only write the file
+    if (CMAKE_VERSION VERSION_GREATER_EQUAL 3.18)
+        set(PRINT_RAM_MAP COMMAND ${CMAKE_COMMAND} -E cat ${TARGET}.ram_map.txt)
+    endif ()
+
+    add_custom_command(
+            TARGET ${TARGET}
+            POST_BUILD
+            COMMAND ${CMAKE_OBJCOPY} -O binary --only-section=.ram_map --set-section-flags .ram_map=alloc,load,contents
+                    ${TARGET}${CMAKE_EXECUTABLE_SUFFIX_C} ${TARGET}.ram_map.txt
+            ${PRINT_RAM_MAP}
+            BYPRODUCTS ${TARGET}.ram_map.txt
+            COMMENT "RAM map ${TARGET}.ram_map.txt"
+    )
+endfunction()
+
+# helper function to list the code executed from RAM, symbol and size
+# of everything that ended up in the .ramfunc section, and to fail the
+# build when a function listed after EXPECTED is not among them
+set(STM32_RAMFUNC_CHECK_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/stm32_check_ramfunc.cmake)
+function(stm32_generate_ramfunc_report TARGET)
+    cmake_parse_arguments(PARSE_ARGV 1 RAMFUNC "" "" "EXPECTED")
+    if (CMAKE_VERSION VERSION_GREATER_EQUAL 3.18)
+        set(PRINT_RAMFUNC_REPORT COMMAND ${CMAKE_COMMAND} -E cat ${TARGET}.ramfunc.txt)
+    endif ()
+    if (RAMFUNC_EXPECTED)
+        string(REPLACE ";" "," EXPECTED "${RAMFUNC_EXPECTED}")
+        set(CHECK_RAMFUNC COMMAND ${CMAKE_COMMAND} -DREPORT_FILE=${TARGET}.ramfunc.txt -DEXPECTED=${EXPECTED}
+                -P ${STM32_RAMFUNC_CHECK_SCRIPT})
+    endif ()
+
+    add_custom_command(
+            TARGET ${TARGET}
+            POST_BUILD
+            COMMAND ${CMAKE_OBJDUMP} -t -C -w -j .ramfunc ${TARGET}${CMAKE_EXECUTABLE_SUFFIX_C} > ${TARGET}.ramfunc.txt
+            ${PRINT_RAMFUNC_REPORT}
+            ${CHECK_RAMFUNC}
+            BYPRODUCTS ${TARGET}.ramfunc.txt
+            COMMENT "RAM code ${TARGET}.ramfunc.txt"
+    )
+endfunction()
+
+# helper function to fail the build when a buffer registered with
+# DMA_BUFFER_CHECK() was not linked into SRAM2
+set(STM32_DMA_PLACEMENT_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/stm32_check_dma_placement.cmake)
+function(stm32_check_dma_placement TARGET)
+    add_custom_command(
+            TARGET ${TARGET}
+            POST_BUILD
+            COMMAND ${CMAKE_OBJCOPY} -O binary --only-section=.dma_check --set-section-flags .dma_check=alloc,load,contents
+                    ${TARGET}${CMAKE_EXECUTABLE_SUFFIX_C} ${TARGET}.dma_check.bin
+            COMMAND ${CMAKE_COMMAND} -DCHECK_FILE=${TARGET}.dma_check.bin -DELF_FILE=${TARGET}${CMAKE_EXECUTABLE_SUFFIX_C}
+                    -DOBJDUMP=${CMAKE_OBJDUMP} -DSRAM2_START=0x2001C000 -DSRAM2_END=0x20020000
+                    -P ${STM32_DMA_PLACEMENT_SCRIPT}
+            BYPRODUCTS ${TARGET}.dma_check.bin
+            COMMENT "Checking DMA buffer placement"
+    )
+endfunction()
+
 # set some compilation definitions to be used in entire project
 add_compile_definitions(
         STM32F4
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""Decode the binary log stream produced by core_lib/logging.
+
+The target never formats log messages. Each record carries the offset of
+its format string in the ELF's .log_strings section plus the raw argument
+bytes, this tool rebuilds the text. Records are framed by a marker byte
+and a CRC, bytes that do not form a valid record are skipped and counted.
+
+    log_decode.py build/stm32_template.elf capture.bin
+    cat /dev/ttyACM0 | log_decode.py build/stm32_template.elf
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+CONVERSION = re.compile(r"%(?P<flags>[-+ #0]*)(?P<width>\d*)(?P<precision>\.\d+)?"
+                        r"(?P<length>hh|h|ll|l|z|j|t)?(?P<type>[diuxXocpfFeEgG%])")
+
+# Format strings of LOG_BLOB() records, followed by the blob's tag.
+BLOB_PREFIX = "@blob:"
+
+# Framing from core_lib/logging/Log.hpp: marker, length, ID and arguments,
+# CRC-16/CCITT-FALSE of everything after the marker.
+FRAME_MARKER = 0xA5
+ID_SIZE = 4
+CRC_SIZE = 2
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as the target computes it."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def read_log_strings(elf_path):
+    """Return {offset: format string} from the .log_strings section."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        sys.exit("%s: not a 32 bit ELF file" % elf_path)
+
+    (e_shoff,) = struct.unpack_from("<I", elf, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    def section(index):
+        # name, type, flags, addr, offset, size
+        return struct.unpack_from("<IIIIII", elf, e_shoff + index * e_shentsize)
+
+    names = section(e_shstrndx)
+    for index in range(e_shnum):
+        name, _, _, addr, offset, size = section(index)
+        end = elf.index(b"\0", names[4] + name)
+        if elf[names[4] + name:end] != b".log_strings":
+            continue
+
+        data = elf[offset:offset + size]
+        strings = {}
+        position = 0
+        while position < len(data):
+            end = data.find(b"\0", position)
+            if end < 0:
+                break
+            if end > position:
+                strings[addr + position] = data[position:end].decode("utf-8", "replace")
+            position = end + 1
+        return strings
+
+    sys.exit("%s: no .log_strings section" % elf_path)
+
+
+def format_record(fmt, payload):
+    """Apply the raw argument bytes to a printf style format string."""
+    out = []
+    position = 0
+    last = 0
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[last:match.start()])
+        last = match.end()
+
+        kind = match.group("type")
+        if kind == "%":
+            out.append("%")
+            continue
+
+        spec = "%" + match.group("flags") + match.group("width") + (match.group("precision") or "")
+        if kind in "fFeEgG":
+            (value,) = struct.unpack_from("<f", payload, position)
+            position += 4
+            out.append((spec + kind) % value)
+            continue
+
+        if match.group("length") == "ll":
+            (value,) = struct.unpack_from("<Q", payload, position)
+            position += 8
+            bits = 64
+        else:
+            (value,) = struct.unpack_from("<I", payload, position)
+            position += 4
+            bits = 32
+
+        if kind in "di" and value >= 1 << (bits - 1):
+            value -= 1 << bits
+
+        if kind == "p":
+            out.append("0x%08x" % value)
+        elif kind == "c":
+            out.append((spec + "c") % chr(value & 0xFF))
+        elif kind == "u":
+            out.append((spec + "d") % value)
+        else:
+            out.append((spec + kind) % value)
+
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def read_records(stream):
+    """Yield (message ID, argument bytes) for each record in a binary stream.
+
+    Bytes skipped to find the next valid record, a stream joined halfway
+    or bytes lost on the line, are reported as (None, count).
+    """
+    read = getattr(stream, "read1", stream.read)
+    data = bytearray()
+    skipped = 0
+    while True:
+        while True:
+            start = data.find(FRAME_MARKER)
+            if start < 0:
+                skipped += len(data)
+                del data[:]
+                break
+            skipped += start
+            del data[:start]
+            if len(data) < 2:
+                break
+            end = 2 + data[1] + CRC_SIZE
+            if len(data) < end:
+                break
+
+            (crc,) = struct.unpack_from("<H", data, end - CRC_SIZE)
+            if data[1] < ID_SIZE or crc16(data[1:end - CRC_SIZE]) != crc:
+                # Not a record after all, look for the next marker.
+                skipped += 1
+                del data[:1]
+                continue
+
+            if skipped:
+                yield None, skipped
+                skipped = 0
+            (message_id,) = struct.unpack_from("<I", data, 2)
+            yield message_id, bytes(data[2 + ID_SIZE:end - CRC_SIZE])
+            del data[:end]
+
+        chunk = read(4096)
+        if not chunk:
+            if skipped + len(data):
+                yield None, skipped + len(data)
+            return
+        data += chunk
+
+
+def decode(strings, stream):
+    """Yield decoded lines from a binary record stream, skipping LOG_BLOB() records."""
+    for message_id, payload in read_records(stream):
+        if message_id is None:
+            yield "<%d bytes skipped to the next record>" % payload
+            continue
+        fmt = strings.get(message_id)
+        if fmt is None:
+            yield "<unknown log id 0x%08x>" % message_id
+            continue
+        if fmt.startswith(BLOB_PREFIX):
+            continue
+
+        try:
+            yield format_record(fmt, payload)
+        except struct.error:
+            yield "<truncated arguments for: %s>" % fmt
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF the stream was produced by")
+    parser.add_argument("stream", nargs="?", help="captured stream, stdin if omitted")
+    args = parser.parse_args()
+
+    strings = read_log_strings(args.elf)
+    stream = open(args.stream, "rb") if args.stream else sys.stdin.buffer
+    with stream:
+        for line in decode(strings, stream):
+            print(line.rstrip("\r\n"), flush=True)
+
+
+if __name__ == "__main__":
+    main()
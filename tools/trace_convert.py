@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+"""Convert a kernel trace from freertos_cpp/Trace.hpp into Chrome trace JSON.
+
+The target sends a trace as LOG_BLOB("trace", ...) records in the log
+stream, this tool collects them, decodes the records and writes a JSON
+file that chrome://tracing and https://ui.perfetto.dev load. Tasks become
+rows of run slices, interrupts rows of their own, queue, notification and
+delay events are instants on the row of whoever caused them.
+
+    trace_convert.py build/stm32_template.elf capture.bin -o trace.json
+    trace_convert.py --raw freertos_trace.bin -o trace.json
+
+--raw reads the recorder's byte stream directly, as the host benchmark
+saves it. Every trace started in the capture becomes a process of its own.
+"""
+
+import argparse
+import json
+import sys
+
+import log_decode
+
+BLOB_TAG = log_decode.BLOB_PREFIX + "trace"
+
+# TraceEvent, in enum order, with its argument count.
+EVENTS = [
+    ("Header", 2),
+    ("TaskCreate", 2),
+    ("TaskSwitch", 1),
+    ("TaskDelay", 1),
+    ("TaskDelayUntil", 1),
+    ("QueueCreate", 2),
+    ("QueueSend", 1),
+    ("QueueSendFailed", 1),
+    ("QueueSendFromIsr", 1),
+    ("QueueReceive", 1),
+    ("QueueReceiveFailed", 1),
+    ("QueueReceiveFromIsr", 1),
+    ("QueueBlockSend", 1),
+    ("QueueBlockReceive", 1),
+    ("TaskNotify", 1),
+    ("TaskNotifyFromIsr", 1),
+    ("TaskNotifyBlock", 0),
+    ("IsrEnter", 1),
+    ("IsrExit", 0),
+    ("Overflow", 1),
+    ("Truncated", 2),
+]
+
+# queueQUEUE_TYPE_* from queue.h.
+QUEUE_TYPES = ["queue", "mutex", "counting semaphore", "binary semaphore", "recursive mutex", "queue set"]
+
+# Interrupt rows sort after the task rows.
+ISR_ROW = 1000
+
+
+def varint(data, position):
+    """Return (value, next position) of an unsigned LEB128 value."""
+    value = 0
+    shift = 0
+    while True:
+        if position >= len(data):
+            raise ValueError("stream ends inside a record")
+        byte = data[position]
+        position += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, position
+        shift += 7
+
+
+def records(data):
+    """Yield (event name, time delta, arguments, name) for each record."""
+    position = 0
+    while position < len(data):
+        event = data[position]
+        if event >= len(EVENTS):
+            raise ValueError("unknown event %d at offset %d" % (event, position))
+        kind, count = EVENTS[event]
+        delta, position = varint(data, position + 1)
+
+        arguments = []
+        for _ in range(count):
+            value, position = varint(data, position)
+            arguments.append(value)
+
+        name = None
+        if kind == "TaskCreate":
+            length = data[position]
+            name = data[position + 1:position + 1 + length].decode("utf-8", "replace")
+            position += 1 + length
+        yield kind, delta, arguments, name
+
+
+class Converter:
+    """Turns decoded records into Chrome trace events."""
+
+    def __init__(self):
+        self.events = []
+        self.process = 0
+        self.frequency = None
+
+    def start(self, frequency, tick_rate):
+        self.process += 1
+        self.frequency = frequency
+        self.time = 0
+        self.tasks = {}
+        self.queues = {}
+        self.running = None
+        self.running_since = 0
+        self.interrupts = []
+        self.isr_rows = set()
+        self.metadata("process_name", None, "FreeRTOS trace %d, %u Hz ticks" % (self.process, tick_rate))
+
+    def microseconds(self):
+        return self.time * 1e6 / self.frequency
+
+    def metadata(self, kind, row, name):
+        event = {"name": kind, "ph": "M", "pid": self.process, "args": {"name": name}}
+        if row is not None:
+            event["tid"] = row
+        self.events.append(event)
+
+    def task_name(self, task):
+        return self.tasks.get(task, "task %d" % task)
+
+    def queue_name(self, queue):
+        return self.queues.get(queue, "queue %d" % queue)
+
+    def current_row(self):
+        if self.interrupts:
+            return ISR_ROW + self.interrupts[-1][0]
+        return self.running if self.running is not None else 0
+
+    def instant(self, name, scope="t"):
+        self.events.append({"name": name, "ph": "i", "s": scope, "pid": self.process, "tid": self.current_row(),
+                            "ts": self.microseconds()})
+
+    def close_slice(self):
+        if self.running is None:
+            return
+        start = self.running_since * 1e6 / self.frequency
+        self.events.append({"name": self.task_name(self.running), "ph": "X", "pid": self.process,
+                            "tid": self.running, "ts": start, "dur": self.microseconds() - start})
+
+    def finish(self):
+        if self.frequency is None:
+            return
+        self.close_slice()
+        while self.interrupts:
+            self.isr_exit()
+
+    def isr_exit(self):
+        exception, since = self.interrupts.pop()
+        start = since * 1e6 / self.frequency
+        self.events.append({"name": "exception %d" % exception, "ph": "X", "pid": self.process,
+                            "tid": ISR_ROW + exception, "ts": start, "dur": self.microseconds() - start})
+
+    def add(self, kind, delta, arguments, name):
+        if kind == "Header":
+            self.finish()
+            self.start(*arguments)
+            return
+        if self.frequency is None:
+            raise ValueError("stream does not start with a Header record")
+
+        self.time += delta
+        if kind == "TaskCreate":
+            task, priority = arguments
+            self.tasks[task] = name
+            self.metadata("thread_name", task, "%s (prio %d)" % (name, priority))
+            self.events.append({"name": "thread_sort_index", "ph": "M", "pid": self.process, "tid": task,
+                                "args": {"sort_index": task}})
+        elif kind == "TaskSwitch":
+            self.close_slice()
+            self.running = arguments[0]
+            self.running_since = self.time
+        elif kind == "QueueCreate":
+            queue, queue_type = arguments
+            type_name = QUEUE_TYPES[queue_type] if queue_type < len(QUEUE_TYPES) else "queue"
+            self.queues[queue] = "%s %d" % (type_name, queue)
+            self.instant("create " + self.queues[queue])
+        elif kind.startswith("Queue"):
+            self.instant("%s %s" % (kind, self.queue_name(arguments[0])))
+        elif kind in ("TaskNotify", "TaskNotifyFromIsr"):
+            self.instant("%s %s" % (kind, self.task_name(arguments[0])))
+        elif kind == "TaskNotifyBlock":
+            self.instant(kind)
+        elif kind == "TaskDelay":
+            self.instant("delay %d ticks" % arguments[0])
+        elif kind == "TaskDelayUntil":
+            self.instant("delay until tick %d" % arguments[0])
+        elif kind == "IsrEnter":
+            exception = arguments[0]
+            if exception not in self.isr_rows:
+                self.isr_rows.add(exception)
+                self.metadata("thread_name", ISR_ROW + exception, "exception %d" % exception)
+            self.interrupts.append((exception, self.time))
+        elif kind == "IsrExit":
+            if self.interrupts:
+                self.isr_exit()
+        elif kind == "Overflow":
+            self.instant("overflow, %d records lost" % arguments[0], scope="g")
+        elif kind == "Truncated":
+            self.instant("%d tasks and %d queues not named at start" % tuple(arguments), scope="g")
+
+
+def read_blobs(elf, stream):
+    """Concatenate the payloads of the "trace" blobs in a log stream."""
+    strings = log_decode.read_log_strings(elf)
+    data = bytearray()
+    for message_id, payload in log_decode.read_records(stream):
+        if strings.get(message_id) == BLOB_TAG:
+            data += payload
+    return bytes(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--raw", action="store_true", help="input is the recorder's byte stream, no ELF")
+    parser.add_argument("inputs", nargs="+", metavar="input",
+                        help="firmware ELF and captured log stream, or the raw trace with --raw")
+    parser.add_argument("-o", "--output", help="JSON file to write, stdout if omitted")
+    args = parser.parse_args()
+
+    if args.raw:
+        if len(args.inputs) != 1:
+            parser.error("--raw takes one input file")
+        with open(args.inputs[0], "rb") as f:
+            data = f.read()
+    else:
+        if len(args.inputs) != 2:
+            parser.error("expected the firmware ELF and a captured log stream")
+        with open(args.inputs[1], "rb") as stream:
+            data = read_blobs(args.inputs[0], stream)
+
+    converter = Converter()
+    try:
+        for record in records(data):
+            converter.add(*record)
+    except (ValueError, IndexError) as error:
+        print("warning: %s, trace truncated" % error, file=sys.stderr)
+    converter.finish()
+
+    document = {"traceEvents": converter.events, "displayTimeUnit": "ns"}
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(document, f)
+    else:
+        json.dump(document, sys.stdout)
+        sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()